@@ -0,0 +1,45 @@
+// PR-026 micro-benchmark: CRC32C throughput per implementation
+// Usage: bench_crc32c [total_mib]   (default 256 MiB per size and implementation)
+// Not a test: prints MB/s for a few buffer sizes, including one segment pre-header.
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "pc_crc32c.h"
+
+static double now_sec(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+  const size_t total = (argc > 1 ? (size_t)atol(argv[1]) : 256u) << 20;
+  const size_t sizes[] = {64, 256, 4096 - 256, 65536};
+  static uint8_t buf[65536];
+  for (size_t i = 0; i < sizeof buf; ++i)
+    buf[i] = (uint8_t)(i * 131u + 7u);
+
+  printf("active: %s\n", pc_crc32c_impl_name(pc_crc32c_active()));
+  printf("%-10s %8s %10s\n", "impl", "bytes", "MB/s");
+  for (int impl = 0; impl < PC_CRC32C_IMPL_COUNT; ++impl)
+  {
+    if (!pc_crc32c_available((pc_crc32c_impl_t)impl))
+      continue;
+    for (size_t s = 0; s < sizeof sizes / sizeof sizes[0]; ++s)
+    {
+      const size_t len = sizes[s], iters = total / len;
+      uint32_t crc = PC_CRC32C_SEED;
+      double t0 = now_sec();
+      for (size_t i = 0; i < iters; ++i)
+        crc = pc_crc32c_update_with((pc_crc32c_impl_t)impl, crc, buf, len);
+      double dt = now_sec() - t0;
+      printf("%-10s %8zu %10.0f   (crc %08x)\n", pc_crc32c_impl_name((pc_crc32c_impl_t)impl), len,
+             (double)(iters * len) / dt / 1e6, crc);
+    }
+  }
+  return 0;
+}
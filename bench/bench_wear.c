@@ -0,0 +1,111 @@
+// PR-033 simulation: wear spread per allocation policy
+// Usage: bench_wear [segment_writes]   (default 1000000 per configuration)
+// Not a test: a 256-sector device holds a cold set (half the sectors, written
+// once) and a hot set that is rewritten at random; prints the erase-count
+// spread from pc_flash_wear_stats with and without static wear leveling.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_alloc.h"
+#include "pc_appender.h"
+
+#define SECTORS 256u
+#define COLD (SECTORS / 2)
+#define HOT 96u
+#define LEVEL_EVERY 256u // writes between static wear leveling checks
+
+static uint32_t rng = 12345u;
+static uint32_t next_rand(void)
+{
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// Write an (empty) segment into a freshly acquired sector
+static size_t write_seg(pc_flash_t *f, pc_alloc_t *a, pc_alloc_policy_t policy, uint32_t seqno)
+{
+  size_t base = 0;
+  pc_appender_t app;
+  if (pc_alloc_acquire_policy(a, policy, &base) != PC_OK || pc_appender_open(&app, f, base, seqno) != PC_OK ||
+      pc_appender_commit(&app, PC_SEG_DATA) != PC_OK)
+  {
+    fprintf(stderr, "allocation failed\n");
+    exit(1);
+  }
+  pc_alloc_commit(a, base);
+  return base / pc_flash_sector_bytes(f);
+}
+
+static void run(pc_alloc_policy_t policy, uint32_t wear_delta, size_t writes)
+{
+  const size_t SEG = 1024, PROG = 64; // small sectors keep the simulation fast
+  pc_flash_t f = {0};
+  if (!pc_flash_init(&f, SECTORS * SEG, SEG, PROG, 0xFF))
+    exit(1);
+  pc_alloc_t a;
+  if (pc_alloc_init(&a, &f) != PC_OK)
+    exit(1);
+
+  uint64_t in_use[SECTORS / 64] = {0};
+  size_t hot[HOT];
+  uint32_t seq = 1;
+  for (size_t i = 0; i < COLD; ++i)
+  {
+    const size_t s = write_seg(&f, &a, policy, seq++);
+    in_use[s / 64] |= 1ull << (s % 64);
+  }
+  for (size_t i = 0; i < HOT; ++i)
+  {
+    hot[i] = write_seg(&f, &a, policy, seq++);
+    in_use[hot[i] / 64] |= 1ull << (hot[i] % 64);
+  }
+
+  size_t moves = 0;
+  for (size_t w = 0; w < writes; ++w)
+  {
+    // Rewrite a random hot segment: free its sector, write the new version
+    const size_t k = next_rand() % HOT;
+    pc_flash_erase_sector(&f, hot[k]);
+    pc_alloc_release(&a, hot[k] * SEG, true);
+    in_use[hot[k] / 64] &= ~(1ull << (hot[k] % 64));
+    hot[k] = write_seg(&f, &a, policy, seq++);
+    in_use[hot[k] / 64] |= 1ull << (hot[k] % 64);
+
+    // Static wear leveling: move the coldest data onto the most-worn free sector
+    size_t cold = 0;
+    if (!wear_delta || w % LEVEL_EVERY != 0 || pc_alloc_cold_sector(&a, in_use, wear_delta, &cold) != PC_OK)
+      continue;
+    const size_t to = write_seg(&f, &a, PC_ALLOC_MOST_WORN, seq++);
+    pc_flash_erase_sector(&f, cold);
+    pc_alloc_release(&a, cold * SEG, true);
+    in_use[cold / 64] &= ~(1ull << (cold % 64));
+    in_use[to / 64] |= 1ull << (to % 64);
+    for (size_t j = 0; j < HOT; ++j)
+      if (hot[j] == cold)
+        hot[j] = to;
+    moves++;
+  }
+
+  uint32_t mn = 0, mx = 0, avg = 0;
+  pc_flash_wear_stats(&f, &mn, &mx, &avg);
+  static const char *names[] = {"next", "least-worn", "most-worn"};
+  printf("%-11s %6u %8u %8u %8u %8.2f %8zu\n", names[policy], wear_delta, mn, mx, avg,
+         avg ? (double)mx / avg : 0.0, moves);
+  pc_alloc_deinit(&a);
+  pc_flash_free(&f);
+}
+
+int main(int argc, char **argv)
+{
+  const size_t writes = argc > 1 ? (size_t)atol(argv[1]) : 1000000u;
+  printf("%zu segment writes, %u sectors (%u cold, %u hot)\n", writes, SECTORS, COLD, HOT);
+  printf("%-11s %6s %8s %8s %8s %8s %8s\n", "policy", "delta", "min", "max", "avg", "max/avg", "moves");
+  run(PC_ALLOC_NEXT, 0, writes);
+  run(PC_ALLOC_LEAST_WORN, 0, writes);
+  run(PC_ALLOC_NEXT, 64, writes);
+  run(PC_ALLOC_LEAST_WORN, 64, writes);
+  return 0;
+}
@@ -7,6 +7,19 @@
 // Notes:
 // - "Free" means: commit page is fully erased (no header written).
 // - We assume a single writer (our flusher), so no concurrent allocs.
+// - PR-030: sectors below first_index are never handed out (epoch superblock).
+// - PR-033: wear-aware policies pick among all free sectors by erase count
+//   (ties go in circular order), sectors erased wear_limit times are retired,
+//   and pc_alloc_cold_sector finds cold data pinning a low-wear sector (static
+//   wear leveling). Erase counts come from the device (pc_flash_t.wear).
+// - PR-034: a state per sector (free-dirty, free-erased, open, committed)
+//   replaces re-reading the commit page: sectors are probed once, acquire marks
+//   them open and the owner reports commits and releases. pc_alloc_refill_step
+//   keeps pool_target sectors erased ahead of time, off the write path, and
+//   wear-aware acquires take those first.
+// - PR-035: free and erased sectors are also kept as bitmaps, searched a word
+//   at a time (ctz), and pc_alloc_load_states seeds every state from the mount's
+//   header pass, so acquire reads no flash at all.
 
 #ifndef PC_ALLOC_H
 #define PC_ALLOC_H
@@ -22,22 +35,89 @@
 extern "C" {
 #endif
 
+typedef enum {
+    PC_ALLOC_NEXT = 0,       // next free sector in circular order (default)
+    PC_ALLOC_LEAST_WORN = 1, // free sector with the fewest erases
+    PC_ALLOC_MOST_WORN = 2   // free sector with the most erases (a home for cold data)
+} pc_alloc_policy_t;
+
+typedef enum {
+    PC_ALLOC_UNKNOWN = 0,     // not probed yet
+    PC_ALLOC_FREE_DIRTY = 1,  // holds nothing live, may need an erase
+    PC_ALLOC_FREE_ERASED = 2, // blank: opens without an erase
+    PC_ALLOC_OPEN = 3,        // handed out by acquire
+    PC_ALLOC_COMMITTED = 4,   // holds a committed segment
+    PC_ALLOC_BAD = 5
+} pc_alloc_state_t;
+
 typedef struct {
     pc_flash_t* f;
     size_t seg_bytes;       // e.g., 4096
     size_t prog_bytes;      // e.g., 256
     size_t sector_count;    // total segments = total_bytes / seg_bytes
     size_t next_index;      // where to start the next search
+    size_t first_index;     // sectors [0, first_index) are reserved (default 0)
+    pc_alloc_policy_t policy; // used by pc_alloc_acquire (default PC_ALLOC_NEXT)
+    uint32_t wear_limit;    // sectors erased this many times are retired (0 = no limit)
+    uint8_t* state;         // pc_alloc_state_t per sector
+    uint64_t* free_map;     // bit per sector: free or not probed yet
+    uint64_t* erased_map;   // bit per sector: PC_ALLOC_FREE_ERASED
+    size_t pool_target;     // erased sectors pc_alloc_refill_step keeps ready (0 = no pool)
+    size_t erased;          // sectors in PC_ALLOC_FREE_ERASED
+    size_t pool_misses;     // acquires that had to take a dirty sector despite the pool
 } pc_alloc_t;
 
 // Initialize allocator for the given flash device.
-// Starts searching from index 0.
+// Starts searching from index 0, every sector PC_ALLOC_UNKNOWN.
+// Returns PC_OK, PC_EINVAL or PC_NO_SPACE (state table).
 pc_result_t pc_alloc_init(pc_alloc_t* a, pc_flash_t* f);
 
+// Free the state table.
+void pc_alloc_deinit(pc_alloc_t* a);
+
+// State of sector 'idx', probing its commit page if it is still unknown.
+pc_alloc_state_t pc_alloc_state(pc_alloc_t* a, size_t idx);
+
+// Seed every sector from a header pass ('states' holds a pc_sector_state_t per
+// sector, as left by pc_index_mount_ex). Free sectors become dirty, committed
+// and corrupt ones committed; PC_SECT_UNKNOWN (not read by an epoch mount)
+// becomes 'unknown_as'.
+void pc_alloc_load_states(pc_alloc_t* a, const uint8_t* states, pc_alloc_state_t unknown_as);
+
 // Acquire the base address of the next free segment, advancing next_index.
-// Returns PC_OK and *out_base on success, PC_NO_SPACE if none available.
+// The sector becomes PC_ALLOC_OPEN until pc_alloc_commit / pc_alloc_release.
+// Returns PC_OK and *out_base on success, PC_NO_SPACE if none available,
+// PC_FLASH_WEAR if the only free sectors are retired.
 pc_result_t pc_alloc_acquire(pc_alloc_t* a, size_t* out_base);
 
+// pc_alloc_acquire with an explicit policy.
+pc_result_t pc_alloc_acquire_policy(pc_alloc_t* a, pc_alloc_policy_t policy, size_t* out_base);
+
+// pc_alloc_acquire_policy that also reports whether the sector is already
+// erased (open it with pc_appender_open_erased). Wear-aware policies prefer
+// erased sectors; PC_ALLOC_NEXT keeps strict circular order (epoch walks).
+pc_result_t pc_alloc_acquire_ex(pc_alloc_t* a, pc_alloc_policy_t policy, size_t* out_base, bool* pre_erased);
+
+// The segment at 'base' was committed.
+void pc_alloc_commit(pc_alloc_t* a, size_t base);
+
+// The sector at 'base' holds nothing live any more: PC_ALLOC_FREE_ERASED if
+// the caller erased it, else PC_ALLOC_FREE_DIRTY (erased later by the refill
+// step, or on open).
+void pc_alloc_release(pc_alloc_t* a, size_t base, bool erased);
+
+// Background maintenance: bring up to max_erases dirty sectors into the erased
+// pool until it holds pool_target. A sector that reads back blank joins without
+// an erase. *erased (optional) counts sectors actually erased.
+// Returns PC_OK or a flash error.
+pc_result_t pc_alloc_refill_step(pc_alloc_t* a, size_t max_erases, size_t* erased);
+
+// Static wear leveling: the least-worn sector among 'in_use' (one bit per
+// sector) when the most-worn usable sector is more than wear_delta erases ahead
+// of it. Returns PC_OK and *out_index, or PC_ITER_END when wear is balanced.
+pc_result_t pc_alloc_cold_sector(const pc_alloc_t* a, const uint64_t* in_use,
+                                 uint32_t wear_delta, size_t* out_index);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -3,6 +3,36 @@
 // - pc_write: enqueue a point into the SPSC ring
 // - pc_db_flush_once / pc_db_flush_until_empty: drain ring -> flash (multi-block segments)
 // - pc_query_latest: scan committed segments for latest value of a metric
+// - PR-011: in-RAM segment catalog, rebuilt at init from the newest INDEX
+//   snapshot (+ newer segments); snapshots are written every index_interval commits
+// - PR-012: queries walk segments newest-first (by seqno) and blocks newest-first,
+//   stopping once no older segment's ts_max can win; pc_query_tail for "last N"
+// - PR-013: read-your-writes mode (pc_query_*_ex) that also sees the open segment
+//   and the ring
+// - PR-014: batch latest/range over many metrics in one pass (pc_query_*_many)
+// - PR-016: time-bucketed aggregation (pc_query_aggregate) using block summaries
+// - PR-017: push-style streaming scan (pc_query_scan) with offset/limit and early exit
+// - PR-018: optional per-block quantile sketches + pc_query_quantile
+// - PR-019: persistent series dictionary (pc_series_resolve) for names + tags
+// - PR-020: tag selectors (pc_series_select) for aggregate and scan queries
+// - PR-021: LRU cache of decoded blocks + directories behind the query paths
+// - PR-022: aggregate and scan run on the batch executor (pc_exec.h)
+// - PR-023: derived series in the engine: pc_query_derive / pc_query_rate
+// - PR-024: several series on a common time grid (pc_query_align)
+// - PR-025: "as of t" point lookup that binary-searches sorted blocks (pc_query_asof)
+// - PR-027: segment commits use the appender's running CRC (optional read-back check)
+// - PR-028: lazy mount (headers only); segments are CRC-verified on first read or
+//   by pc_db_verify_step, and the ones that fail are quarantined
+// - PR-030: epoch markers (pc_db_enable_epochs) bound the mount to the sectors
+//   the newest epoch points at
+// - PR-031: pc_db_open mounts with a config and resumes the log by itself
+//   (next seqno + allocator position recovered from the headers it read)
+// - PR-032: retention (age / bytes / segment count / free-space floor) reclaims
+//   the oldest segments, turning the device into a ring log
+// - PR-033: wear-aware allocation and static wear leveling (pc_db_wear_level_step)
+// - PR-034: pre-erased segment pool refilled off the write path (pc_db_erase_step)
+// - PR-035: the allocator keeps a free-space bitmap seeded at mount; opening a
+//   segment does not read flash
 //
 // Notes
 // - Single-writer flusher, as per SPSC plan (Core1 in firmware; here we call it directly in tests).
@@ -22,6 +52,11 @@
 #include "pc_block.h"
 #include "pc_logseg.h"
 #include "pc_alloc.h"
+#include "pc_catalog.h"
+#include "pc_index.h"
+#include "pc_scan.h"
+#include "pc_series.h"
+#include "pc_exec.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -37,6 +72,17 @@ extern "C"
     float value;        // sample
   } pc_point_ram_t;
 
+  // What to keep. Every limit is off at 0. Segments go oldest (lowest seqno)
+  // first, whole segments at a time.
+  typedef struct
+  {
+    uint32_t max_age_secs;      // newest point older than the newest data by more than this
+    uint64_t max_bytes;         // DATA segments beyond this many bytes
+    uint32_t keep_segments;     // DATA segments beyond the newest N
+    uint32_t min_free_segments; // reclaim while fewer free segments; also makes a full
+                                // device reclaim on the write path instead of PC_NO_SPACE
+  } pc_retention_t;
+
   // Opaque DB handle (small, fixed-size)
   typedef struct
   {
@@ -58,15 +104,144 @@ extern "C"
     // Monotonic segment sequence number
     uint32_t next_seq;
     pc_alloc_t alloc;
+
+    // Committed DATA segments (sorted by seqno) + the live INDEX snapshot
+    pc_catalog_t catalog;
+    pc_index_t index;
+    uint32_t index_interval;      // snapshot every N data commits (0 = never); default 16
+    uint32_t commits_since_index; // data commits since the last snapshot
+    pc_mount_stats_t mount;       // what pc_db_init found on flash
+
+    // Lazy mount: one bit per sector. 'unverified' segments are in the catalog
+    // but their CRC has not been checked yet; 'quarantined' ones failed it and
+    // are never read again (dropped from the catalog at the next flush/step).
+    uint64_t *unverified;
+    uint64_t *quarantined;
+    size_t unverified_count;
+    size_t quarantined_count;
+    bool quarantine_pending; // quarantined segments still in the catalog
+
+    // The device keeps epochs in its superblock slots (pc_epoch.h): one is
+    // written with every snapshot. Detected at mount; see pc_db_enable_epochs.
+    bool epochs;
+
+    // Applied by pc_db_reclaim_step (and the write path when the device is full)
+    pc_retention_t retention;
+    size_t segments_reclaimed; // total erased by retention
+
+    // Static wear leveling: move a segment off its sector once the most-worn
+    // sector is more than wear_delta erases ahead (0 = off; pc_db_wear_level_step)
+    uint32_t wear_delta;
+    size_t segments_relocated;
+
+    // Reader scratch (block directory + points) shared by the query paths
+    pc_scan_t scan;
+    // Decoded blocks of committed segments (PC_BLOCKCACHE_BYTES_DEFAULT; resize
+    // with pc_blockcache_free + pc_blockcache_init between queries)
+    pc_blockcache_t cache;
+
+    // Store a quantile sketch with every summarized block (default off; applies
+    // from the next segment opened)
+    bool sketch_blocks;
+
+    // Re-read each segment before committing it and check it against the CRC
+    // tracked while writing (default off; applies from the next segment opened)
+    bool verify_commits;
+
+    // Names + tags → ids; saved with every snapshot (and forces one when changed)
+    pc_series_dict_t series;
   } pc_db_t;
 
+#define PC_DB_INDEX_INTERVAL_DEFAULT 16u
+
   // Initialize the DB with a flash device + ring capacity (elements).
   // seq_start: initial segment sequence number.
+  // Mounts the device: loads the newest INDEX snapshot into the catalog and
+  // verifies only the DATA segments written after it.
   // Returns PC_OK or PC_EINVAL / allocation failures as PC_EINVAL.
   pc_result_t pc_db_init(pc_db_t *db, pc_flash_t *flash,
                          uint32_t ring_capacity_elems,
                          uint32_t seq_start);
 
+  // How pc_db_init_ex mounts the device
+  typedef enum
+  {
+    PC_MOUNT_VERIFY = 0, // CRC-check every segment newer than the snapshot
+    PC_MOUNT_LAZY = 1    // trust commit headers; verify on first read / pc_db_verify_step
+  } pc_mount_mode_t;
+
+  // pc_db_init with a mount mode. A lazy mount reads only commit pages (plus
+  // the snapshot), so its cost does not grow with the data behind them.
+  pc_result_t pc_db_init_ex(pc_db_t *db, pc_flash_t *flash,
+                            uint32_t ring_capacity_elems,
+                            uint32_t seq_start, pc_mount_mode_t mode);
+
+  // Background verification after a lazy mount: CRC-check up to max_segments
+  // unverified segments (newest first) and drop the quarantined ones from the
+  // catalog. Flusher thread, between flush calls; call when idle until
+  // *remaining (optional) is 0. Returns PC_OK or a flash error.
+  pc_result_t pc_db_verify_step(pc_db_t *db, size_t max_segments, size_t *remaining);
+
+#define PC_DB_RING_CAPACITY_DEFAULT 512u
+
+  // Settings for pc_db_open (pc_db_config_default fills in the defaults)
+  typedef struct
+  {
+    uint32_t ring_capacity;   // ring elements
+    pc_mount_mode_t mount;    // PC_MOUNT_VERIFY
+    uint32_t index_interval;  // PC_DB_INDEX_INTERVAL_DEFAULT
+    bool sketch_blocks;       // false
+    bool verify_commits;      // false
+    pc_retention_t retention; // all off
+    pc_alloc_policy_t alloc_policy; // PC_ALLOC_NEXT (epoch devices always use it)
+    uint32_t wear_limit;      // retire sectors erased this often (0 = never)
+    uint32_t wear_delta;      // static wear leveling threshold (0 = off)
+    size_t erased_pool;       // sectors kept erased by pc_db_erase_step (0 = erase on open)
+    unsigned mount_threads;   // 1; header and CRC passes of the mount (serial without PC_THREADS)
+  } pc_db_config_t;
+
+  void pc_db_config_default(pc_db_config_t *cfg);
+
+  // Mount 'flash' and get ready to write, in one pass over what the mount reads:
+  // next_seq becomes one past the highest seqno on the device (INDEX, EPOCH and
+  // CRC-failed segments included, so no seqno is ever reused) and the allocator
+  // resumes just after the segment holding it, keeping placement in write order.
+  // cfg NULL = defaults. Returns as pc_db_init_ex.
+  pc_result_t pc_db_open(pc_db_t *db, pc_flash_t *flash, const pc_db_config_t *cfg);
+
+  // Background space reclamation: erase up to max_segments segments that the
+  // retention policy gives up (quarantined ones first, then the oldest DATA
+  // segments while a limit is exceeded), dropping them from the catalog and the
+  // block cache. Call from the flusher thread when idle; *reclaimed (optional)
+  // receives how many went. Returns PC_OK or a flash error.
+  pc_result_t pc_db_reclaim_step(pc_db_t *db, size_t max_segments, size_t *reclaimed);
+
+  // Static wear leveling: while the least-worn sector holding a DATA segment is
+  // more than wear_delta erases behind the most-worn usable sector, copy that
+  // (cold) segment to the most-worn free sector (the next one on epoch devices)
+  // with the same seqno and erase its old sector, freeing it for hot data. At
+  // most max_moves copies; a snapshot follows any move. Flusher thread, when
+  // idle. Returns PC_OK, PC_FLASH_WEAR (no sector left below wear_limit) or a
+  // flash error.
+  pc_result_t pc_db_wear_level_step(pc_db_t *db, size_t max_moves, size_t *moved);
+
+  // Refill the pool of pre-erased segments (alloc.pool_target of them) with at
+  // most max_erases erases, so the flusher opens segments without erasing.
+  // Flusher thread, when idle; alloc.pool_misses counts opens that found the
+  // pool empty. Returns PC_OK or a flash error.
+  pc_result_t pc_db_erase_step(pc_db_t *db, size_t max_erases, size_t *erased);
+
+  // Free segments as counted by retention: usable sectors minus catalogued,
+  // snapshot, quarantined and open segments.
+  size_t pc_db_free_segments(const pc_db_t *db);
+
+  // Start writing epochs (a snapshot + epoch now, then one with every snapshot)
+  // so later mounts read only what the newest epoch points at. A device-format
+  // choice: it reserves the first PC_EPOCH_SLOTS sectors and stays on. Returns
+  // PC_OK, PC_BUSY (a segment is open or the slots hold data), PC_UNSUPPORTED
+  // (the live bitmap does not fit a segment) or a write error.
+  pc_result_t pc_db_enable_epochs(pc_db_t *db);
+
   // Free allocations and close any open appender (does not erase/commit).
   void pc_db_deinit(pc_db_t *db);
 
@@ -76,6 +251,25 @@ extern "C"
   pc_result_t pc_write(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
                        uint32_t ts, float value);
 
+  // Ids for a metric name + tags (any order), creating them on first use.
+  // New entries become durable with the snapshot written at the next segment
+  // commit (or pc_db_write_index). Flusher thread only; see pc_series.h.
+  // Returns PC_OK, PC_TOO_MANY_SERIES, PC_EINVAL or PC_NO_SPACE.
+  pc_result_t pc_series_resolve(pc_db_t *db, const char *name,
+                                const pc_tag_t *tags, size_t ntags, pc_series_t *out);
+
+  // "name{k=v,...}" for resolved ids. PC_METRIC_UNKNOWN / PC_NO_SPACE (buf too small).
+  pc_result_t pc_series_describe(const pc_db_t *db, pc_series_t s, char *buf, size_t cap);
+
+  // Raise the dictionary capacity (default PC_SERIES_CAPACITY_DEFAULT entries).
+  pc_result_t pc_db_series_capacity(pc_db_t *db, size_t capacity);
+
+  // Hot-path write through a resolved handle (no hashing).
+  static inline pc_result_t pc_write_series(pc_db_t *db, pc_series_t s, uint32_t ts, float value)
+  {
+    return pc_write(db, s.metric_id, s.series_id, ts, value);
+  }
+
   // Drain a limited number of points from the ring and append as ONE block.
   // - Opens a segment appender if none is open.
   // - Pack contiguous points that share the FIRST point's (metric_id, series_id).
@@ -87,12 +281,204 @@ extern "C"
   // Drain the ring entirely, committing current segment at the end.
   pc_result_t pc_db_flush_until_empty(pc_db_t *db);
 
+  // Write an INDEX snapshot of the catalog now (also done every index_interval commits).
+  // Returns PC_BUSY while a segment is open (flush first), PC_NO_SPACE if the device is full.
+  pc_result_t pc_db_write_index(pc_db_t *db);
+
+  // Read consistency for queries.
+  //
+  // PC_READ_COMMITTED: only committed segments. What you see survives a crash.
+  //
+  // PC_READ_YOUR_WRITES: committed segments, plus the open segment (pages already
+  // programmed and the appender's staging page), plus a snapshot of the ring
+  // taken at the start of the query (points published by the producer so far).
+  // Pending data is newer than anything committed, so on equal timestamps it wins.
+  // Points that are not committed yet may be lost on power failure.
+  //
+  // Contract: the appender and ring tail belong to the flusher, so queries run on
+  // the flusher (ring consumer) thread, between flush calls. No lock is taken and
+  // nothing is popped: the producer keeps writing, and the next flush proceeds
+  // exactly as if the query had not happened.
+  typedef enum
+  {
+    PC_READ_COMMITTED = 0,
+    PC_READ_YOUR_WRITES = 1
+  } pc_read_mode_t;
+
   // Latest value for a metric across committed segments (and ignores uncommitted).
-  // Scans in address order, decodes blocks, and keeps the max timestamp for metric_id.
+  // Walks the catalog newest-first and stops once older segments cannot win.
+  // On equal timestamps the most recently written point is returned.
   // Returns PC_OK if found at least one sample; PC_METRIC_UNKNOWN if none found.
   pc_result_t pc_query_latest(pc_db_t *db, uint16_t metric_id,
                               float *out_value, uint32_t *out_ts);
 
+  // pc_query_latest with an explicit read mode.
+  pc_result_t pc_query_latest_ex(pc_db_t *db, uint16_t metric_id, pc_read_mode_t mode,
+                                 float *out_value, uint32_t *out_ts);
+
+  // Value of (metric, series) as of time t: the point with the greatest ts <= t
+  // (on equal timestamps, the most recently written). Walks the catalog
+  // newest-first and stops once older segments cannot hold a newer match; blocks
+  // written in ts order (PC_BLOCK_F_SORTED) are binary-searched. series_id may be
+  // PC_SERIES_ANY. Committed data only.
+  // Returns PC_OK, PC_METRIC_UNKNOWN (no point at or before t) or PC_EINVAL.
+  pc_result_t pc_query_asof(pc_db_t *db, uint16_t metric_id, uint16_t series_id, uint32_t t,
+                            float *out_value, uint32_t *out_ts);
+
+  // The newest (up to) n points of a metric, returned in ascending ts order.
+  // out_ts/out_val must hold n entries; *out_n receives how many were filled.
+  // Only the tail of the log is decoded. PC_METRIC_UNKNOWN if none found.
+  pc_result_t pc_query_tail(pc_db_t *db, uint16_t metric_id, uint32_t n,
+                            uint32_t *out_ts, float *out_val, uint32_t *out_n);
+
+  // pc_query_tail with an explicit read mode.
+  pc_result_t pc_query_tail_ex(pc_db_t *db, uint16_t metric_id, pc_read_mode_t mode, uint32_t n,
+                               uint32_t *out_ts, float *out_val, uint32_t *out_n);
+
+  // Per-metric result of pc_query_latest_many
+  typedef struct
+  {
+    uint32_t ts;
+    float value;
+    bool found;
+  } pc_latest_t;
+
+  // Latest value of each metrics[i] into out[i], decoding each block at most once.
+  // Blocks are routed to their request slot through a small hash map, so the cost
+  // is O(data) no matter how many metrics are asked for. Committed data only.
+  // Returns PC_OK (check out[i].found), PC_EINVAL (also n > INT32_MAX), or
+  // PC_NO_SPACE (map allocation); or, after answering from the rest, the error of
+  // a segment the walk needed but could not read (e.g. PC_CORRUPT).
+  pc_result_t pc_query_latest_many(pc_db_t *db, const uint16_t *metrics, size_t n, pc_latest_t *out);
+
+  // Caller-sized output of a range query
+  typedef struct
+  {
+    uint32_t *ts;   // [cap]
+    float *val;     // [cap]
+    uint32_t cap;   // capacity of ts/val
+    uint32_t count; // filled entries (<= cap), ascending ts
+    uint32_t total; // matching points seen; total > count means truncated
+  } pc_range_buf_t;
+
+  // All points of each metrics[i] with t0 <= ts <= t1 into out[i], in one pass over
+  // the segments overlapping [t0, t1]. When a buffer is too small it keeps the
+  // earliest-written matches. Returns PC_OK, PC_INVALID_RANGE (t0 > t1), PC_EINVAL
+  // (also n > INT32_MAX) or PC_NO_SPACE (map / sort allocation); or, with out
+  // filled from the rest, the error of a segment that could not be read.
+  pc_result_t pc_query_range_many(pc_db_t *db, const uint16_t *metrics, size_t n,
+                                  uint32_t t0, uint32_t t1, pc_range_buf_t *out);
+
+  // Single-metric convenience over pc_query_range_many. PC_METRIC_UNKNOWN if no match.
+  pc_result_t pc_query_range(pc_db_t *db, uint16_t metric_id, uint32_t t0, uint32_t t1,
+                             uint32_t *out_ts, float *out_val, uint32_t cap, uint32_t *out_n);
+
+  // Downsample [t0, t1] of (metric, series) into buckets of bucket_secs:
+  // bucket k covers [t0 + k*bucket_secs, t0 + (k+1)*bucket_secs).
+  // Needs nbuckets >= (t1 - t0) / bucket_secs + 1. Blocks that carry a summary and
+  // fall inside one bucket are folded without decoding their points; others are
+  // decoded straight into the bucket accumulators. Empty buckets have count 0.
+  // Fields not in agg_mask are zeroed. series_id may be PC_SERIES_ANY.
+  // Returns PC_OK, PC_INVALID_RANGE (t0 > t1) or PC_EINVAL; or, as pc_query_scan,
+  // the error of a segment that could not be read (e.g. PC_CORRUPT), with the
+  // buckets filled from the rest.
+  pc_result_t pc_query_aggregate(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                                 uint32_t t0, uint32_t t1, uint32_t bucket_secs,
+                                 uint32_t agg_mask, pc_bucket_t *out, uint32_t nbuckets);
+
+  // Derived series of one (metric, series) over [t0, t1], in one streaming pass:
+  // each point after the first becomes its change since the previous point
+  // (PC_DERIVE_DELTA) or that change per second (PC_DERIVE_RATE). With
+  // PC_DERIVE_COUNTER a drop is taken as a counter reset (the delta is the new
+  // value). Points that are not newer than their predecessor are dropped. Block
+  // and segment boundaries do not interrupt the series. Committed data only.
+  // Fills up to cap points (ascending ts); *out_n receives how many.
+  // Returns PC_OK, PC_METRIC_UNKNOWN (fewer than two points), PC_INVALID_RANGE or
+  // PC_EINVAL (including wildcard metric/series); or the error of a segment that
+  // could not be read (e.g. PC_CORRUPT), in which case out still holds the
+  // derived points, but one of them may span the missing data.
+  pc_result_t pc_query_derive(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                              uint32_t t0, uint32_t t1, uint32_t flags,
+                              uint32_t *out_ts, float *out_val, uint32_t cap, uint32_t *out_n);
+
+  // Per-second rate of a monotonic counter, robust to resets
+  // (pc_query_derive with PC_DERIVE_RATE | PC_DERIVE_COUNTER).
+  pc_result_t pc_query_rate(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                            uint32_t t0, uint32_t t1,
+                            uint32_t *out_ts, float *out_val, uint32_t cap, uint32_t *out_n);
+
+  // Values of series[0..n) on the grid t0, t0 + step, ... <= t1, written row-major
+  // into out_matrix[row * n + i] (nrows >= (t1 - t0) / step + 1 rows). A sample
+  // exactly on a grid time is used as is; otherwise 'fill' decides, from the
+  // samples inside [t0, t1]: PC_FILL_LOCF carries the last earlier value forward,
+  // PC_FILL_LINEAR interpolates between the nearest samples on each side. Cells
+  // with nothing to fill from are NaN. All series are read in one pass over the
+  // overlapping segments. Committed data only.
+  // Returns PC_OK, PC_INVALID_RANGE, PC_EINVAL or PC_NO_SPACE (grid scratch); or
+  // the error of a segment that could not be read (e.g. PC_CORRUPT), when the
+  // matrix is filled across the missing data and must not be taken as complete.
+  pc_result_t pc_query_align(pc_db_t *db, const pc_series_t *series, size_t n,
+                             uint32_t t0, uint32_t t1, uint32_t step, pc_fill_t fill,
+                             float *out_matrix, uint32_t nrows);
+
+  // Approximate quantiles of (metric, series) over [t0, t1]: out[k] for qs[k] in [0, 1].
+  // Blocks that carry a sketch (db->sketch_blocks) and lie inside the window are
+  // merged without decoding; all other points are binned one by one into the
+  // same log histogram. Each answer is within PC_SKETCH_REL_ERROR (relative) of
+  // the exact value at rank floor(q * (count - 1)). NaN/Inf samples are ignored.
+  // *out_count (optional) receives the number of samples considered.
+  // Returns PC_OK, PC_METRIC_UNKNOWN (no samples), PC_INVALID_RANGE or PC_EINVAL;
+  // or, after answering from the rest, the error of a segment that could not be
+  // read (e.g. PC_CORRUPT).
+  pc_result_t pc_query_quantile(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                                uint32_t t0, uint32_t t1, const float *qs, size_t nq,
+                                float *out, uint64_t *out_count);
+
+  // Tagged series carrying every tags[i] (key=value, ANDed), from the in-RAM
+  // inverted index (at most PC_TAGINDEX_SELECT_MAX pairs). out must be
+  // pc_series_set_init'ed; its contents are replaced.
+  // Returns PC_OK (out->count may be 0), PC_EINVAL or PC_NO_SPACE.
+  pc_result_t pc_series_select(const pc_db_t *db, const pc_tag_t *tags, size_t ntags, pc_series_set_t *out);
+
+  // pc_query_aggregate over every series in 'set' at once (one pass over the data).
+  pc_result_t pc_query_aggregate_set(pc_db_t *db, uint16_t metric_id, const pc_series_set_t *set,
+                                     uint32_t t0, uint32_t t1, uint32_t bucket_secs,
+                                     uint32_t agg_mask, pc_bucket_t *out, uint32_t nbuckets);
+
+// Points per callback batch; the executor's column batch (PC_EXEC_BATCH,
+// pc_exec.h) is sized from it
+#ifndef PC_QUERY_BATCH
+#define PC_QUERY_BATCH 256u
+#endif
+
+  // What pc_query_scan delivers
+  typedef struct
+  {
+    uint16_t metric_id;  // or PC_METRIC_ANY
+    uint16_t series_id;  // or PC_SERIES_ANY
+    uint32_t t0, t1;     // inclusive
+    uint64_t offset;     // matching points to skip first
+    uint64_t limit;      // max points delivered (0 = unlimited)
+    pc_read_mode_t mode; // PC_READ_YOUR_WRITES also streams the open segment + ring
+    const pc_series_set_t *series_set; // if set, replaces series_id (see pc_series_select)
+  } pc_query_filter_t;
+
+  // Receives one batch: n (1..PC_QUERY_BATCH) points of a single metric/series.
+  // The arrays are only valid during the call. Return false to stop the scan.
+  typedef bool (*pc_query_cb_t)(void *ctx, const uint32_t *ts, const float *val, uint32_t n,
+                                uint16_t metric_id, uint16_t series_id);
+
+  // Stream every matching point to cb in write order (oldest segment first, then,
+  // with PC_READ_YOUR_WRITES, the open segment and the ring). Points are not
+  // re-sorted: within one metric/series they come in the order they were written.
+  // Memory use is constant (one batch on the stack), whatever the range size.
+  // Returns PC_OK (also when cb stopped early or nothing matched),
+  // PC_INVALID_RANGE (t0 > t1) or PC_EINVAL. A segment or block that cannot be
+  // read (e.g. PC_CORRUPT for one that failed its deferred CRC check) is skipped
+  // and the rest still streamed, but its error is returned so the caller knows
+  // points are missing.
+  pc_result_t pc_query_scan(pc_db_t *db, const pc_query_filter_t *flt, pc_query_cb_t cb, void *ctx);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -2,7 +2,15 @@
 // - Writes any number of blocks into the pre-header region
 //   [ pc_block_hdr_t ][ pc_point_disk_t x N ] [ next block ] ...
 // - Maintains running ts_min / ts_max / record_count
+// - PR-016: blocks of >= PC_BLOCK_SUMMARY_MIN_POINTS points get a pc_block_summary_t
+// - PR-018: with 'sketch' set, summarized blocks of up to PC_SKETCH_MAX_POINTS
+//   points also get a quantile sketch
 // - Flushes program pages as needed, commits header last (atomic)
+// - PR-027: keeps a running CRC32C of every page it programs, so the commit is a
+//   single header-page program with no read-back. 'verify_commit' re-reads the
+//   pre-header before committing and refuses (PC_CORRUPT) if flash disagrees
+// - PR-034: pc_appender_open_erased skips the erase for sectors the allocator
+//   already erased off the write path
 // - Safe for a single writer (the flusher on Core1).
 //
 // Typical flow:
@@ -27,6 +35,7 @@
 #include "pc_flash.h"
 #include "pc_logseg.h"
 #include "pc_block.h"
+#include "pc_sketch.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -51,6 +60,10 @@ extern "C"
     uint32_t ts_max;
     uint32_t record_count;
 
+    bool sketch;        // write quantile sketches (off after open)
+    bool verify_commit; // paranoid: re-read and check the CRC before commit (off after open)
+    uint32_t crc;       // running CRC32C state over the pages programmed so far
+
     // bookkeeping
     uint32_t seqno;
     bool open; // true after open/erase, false after commit/close
@@ -60,6 +73,10 @@ extern "C"
   // This function erases the segment and initializes the context.
   pc_result_t pc_appender_open(pc_appender_t *a, pc_flash_t *f, size_t base, uint32_t seqno);
 
+  // pc_appender_open on a sector known to be fully erased: no erase, so no
+  // erase latency. Programming a sector that is not blank fails later.
+  pc_result_t pc_appender_open_erased(pc_appender_t *a, pc_flash_t *f, size_t base, uint32_t seqno);
+
   // Append one block (header + N points). Updates ts_min/max and record_count.
   // Returns PC_OK or PC_NO_SPACE if the block would not fit (nothing is written in that case).
   pc_result_t pc_appender_append_block(pc_appender_t *a,
@@ -69,6 +86,10 @@ extern "C"
                                        const float *val_array,
                                        uint32_t npoints);
 
+  // Append raw payload bytes (no block header, stats untouched). Used for
+  // non-DATA segments such as INDEX snapshots. Returns PC_NO_SPACE if it would not fit.
+  pc_result_t pc_appender_append_bytes(pc_appender_t *a, const void *data, size_t len);
+
   // Commit the segment (header-last) with accumulated stats; closes the appender.
   pc_result_t pc_appender_commit(pc_appender_t *a, uint16_t type);
 
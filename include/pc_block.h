@@ -7,12 +7,30 @@
 // - This PR is "one block per segment" to keep things simple.
 // - Only one metric/series per block.
 // - A later PR can add multiple blocks, per-metric grouping, compression, etc.
+//
+// PR-016: optional per-block summary
+// - The top byte of point_count carries flags (blocks written before this read as 0).
+// - PC_BLOCK_F_SUMMARY: a pc_block_summary_t follows the points:
+//     [ pc_block_hdr_t ][ pc_point_disk_t x N ][ pc_block_summary_t ]
+//   Aggregations use it instead of decoding the points when a block falls inside
+//   one bucket, and readers use its ts range to skip blocks.
+//
+// PR-018: optional per-block quantile sketch
+// - PC_BLOCK_F_SKETCH (only together with PC_BLOCK_F_SUMMARY): a pc_sketch
+//   (see pc_sketch.h) follows the summary:
+//     [ hdr ][ points ][ pc_block_summary_t ][ pc_sketch_hdr_t + bins ]
+//
+// PR-025: sorted blocks
+// - PC_BLOCK_F_SORTED: the appender found the points in non-decreasing ts order.
+//   "As of t" lookups binary-search such blocks (pc_block_find_asof) and scan
+//   the others linearly
 
 #ifndef PC_BLOCK_H
 #define PC_BLOCK_H
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include "pc_result.h"
 #include "pc_flash.h"
 #include "pc_logseg.h"
@@ -29,12 +47,36 @@ typedef struct __attribute__((packed)) {
     uint32_t point_count;   // number of points following
 } pc_block_hdr_t;
 
+#define PC_BLOCK_COUNT_MASK 0x00FFFFFFu // point_count bits that hold the count
+#define PC_BLOCK_F_SUMMARY 0x01000000u  // pc_block_summary_t follows the points
+#define PC_BLOCK_F_SKETCH 0x02000000u   // a quantile sketch follows the summary
+#define PC_BLOCK_F_SORTED 0x04000000u   // points are in non-decreasing ts order
+
+// Appender writes a summary for blocks of at least this many points.
+#ifndef PC_BLOCK_SUMMARY_MIN_POINTS
+#define PC_BLOCK_SUMMARY_MIN_POINTS 16u
+#endif
+
+// On-flash block summary (after the points when PC_BLOCK_F_SUMMARY is set)
+typedef struct __attribute__((packed)) {
+    uint32_t ts_min;        // earliest timestamp in the block
+    uint32_t ts_max;        // latest timestamp in the block
+    float    v_min;         // smallest value
+    float    v_max;         // largest value
+    double   v_sum;         // sum of values
+} pc_block_summary_t;
+
 // On-flash point payload (no metric/series here; stored in the header)
 typedef struct __attribute__((packed)) {
     uint32_t ts;            // unix seconds
     float    value;         // float32
 } pc_point_disk_t;
 
+// Index of the point an "as of t" lookup returns: greatest ts <= t, and among
+// equal timestamps the last one written. n if every point is newer than t.
+// O(log n) when sorted (PC_BLOCK_F_SORTED), one linear pass otherwise.
+uint32_t pc_block_find_asof(const pc_point_disk_t* pts, uint32_t n, bool sorted, uint32_t t);
+
 // One-shot helper: writes a single block into the pre-header region and commits
 // the segment header last (atomic). It:
 //  - erases the segment (base must be segment-aligned),
@@ -0,0 +1,85 @@
+// PR-021: Decoded-block LRU cache
+// - Keyed by (segment base, seqno, block offset); a reused sector gets a new
+//   seqno, so stale entries can never hit. Erasing a sector also drops its
+//   entries right away (pc_blockcache_invalidate_base) to free the memory
+// - Values are opaque byte runs: decoded block points, or a whole segment block
+//   directory under PC_BLOCKCACHE_DIR
+// - Bounded by max_bytes (payload bytes); least recently used entries are
+//   evicted first. max_bytes = 0 disables the cache
+// - Hit / miss / eviction counters for tuning
+//
+// Chained hash table + intrusive LRU list over a pool of entry slots.
+// Not thread-safe: owned by one reader (the db's scan context).
+
+#ifndef PC_BLOCKCACHE_H
+#define PC_BLOCKCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pc_result.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Payload budget when the db creates its cache. Embedded builds override it.
+#ifndef PC_BLOCKCACHE_BYTES_DEFAULT
+#define PC_BLOCKCACHE_BYTES_DEFAULT (64u * 1024u)
+#endif
+
+#define PC_BLOCKCACHE_DIR 0xFFFFFFFFu // offset key for a segment's block directory
+
+  typedef struct
+  {
+    size_t base;
+    uint32_t seqno;
+    uint32_t off;
+    void *data;
+    size_t len;
+    int32_t hnext;      // hash chain
+    int32_t prev, next; // LRU list (head = most recent)
+  } pc_blockcache_ent_t;
+
+  typedef struct
+  {
+    pc_blockcache_ent_t *ents; // slot pool
+    size_t nents;
+    int32_t free_head; // unused slots (chained through hnext)
+
+    int32_t *buckets; // heads of hash chains (-1 = empty)
+    size_t nbuckets;  // power of two
+
+    int32_t lru_head, lru_tail;
+    size_t count;
+    size_t bytes;
+    size_t max_bytes;
+
+    // Counters
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t invalidations;
+  } pc_blockcache_t;
+
+  // Empty cache holding at most max_bytes of payload (0 = disabled).
+  void pc_blockcache_init(pc_blockcache_t *c, size_t max_bytes);
+  void pc_blockcache_free(pc_blockcache_t *c);
+
+  // Cached bytes for the key (and mark them most recently used), or NULL.
+  // The pointer stays valid until the next put/invalidate.
+  const void *pc_blockcache_get(pc_blockcache_t *c, size_t base, uint32_t seqno, uint32_t off, size_t *out_len);
+
+  // Copy len bytes in under the key, evicting LRU entries to make room.
+  // Runs larger than max_bytes are not cached (PC_NO_SPACE); so is an allocation failure.
+  pc_result_t pc_blockcache_put(pc_blockcache_t *c, size_t base, uint32_t seqno, uint32_t off,
+                                const void *data, size_t len);
+
+  // Drop every entry of the segment at 'base' (call when the sector is erased).
+  void pc_blockcache_invalidate_base(pc_blockcache_t *c, size_t base);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_BLOCKCACHE_H
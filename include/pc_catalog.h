@@ -0,0 +1,72 @@
+// PR-011: In-RAM segment catalog
+// - One pc_seg_summary_t per committed DATA segment
+// - Kept sorted by seqno (oldest first), so "newest" is the tail
+// - At most one entry per base address (a reused sector replaces its old entry)
+// - PR-012: running max of ts_max in seqno order, so newest-first scans can
+//   stop once nothing older can beat what they already found
+//
+// Built at mount (from an INDEX snapshot + a scan of newer segments) and
+// updated by the flusher on every commit. Queries walk the catalog instead of
+// rescanning the device.
+
+#ifndef PC_CATALOG_H
+#define PC_CATALOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+#include "pc_recover.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef struct
+  {
+    pc_seg_summary_t *segs; // sorted by seqno ascending
+    uint32_t *ts_max_upto;  // ts_max_upto[i] = max(segs[0..i].ts_max)
+    size_t count;
+    size_t cap;
+  } pc_catalog_t;
+
+  // Initialize an empty catalog (no allocation until the first add).
+  void pc_catalog_init(pc_catalog_t *c);
+
+  // Free internal storage. Safe on a zeroed struct.
+  void pc_catalog_free(pc_catalog_t *c);
+
+  // Drop all entries (keeps storage).
+  static inline void pc_catalog_clear(pc_catalog_t *c) { c->count = 0; }
+
+  // Insert a summary in seqno order. An existing entry with the same base is replaced.
+  // Returns PC_OK or PC_NO_SPACE if the catalog cannot grow.
+  pc_result_t pc_catalog_add(pc_catalog_t *c, const pc_seg_summary_t *s);
+
+  // Remove the entry for 'base' (if any). Returns true if one was removed.
+  bool pc_catalog_remove_base(pc_catalog_t *c, size_t base);
+
+  // Lookup by base address (NULL if not present).
+  const pc_seg_summary_t *pc_catalog_find_base(const pc_catalog_t *c, size_t base);
+
+  // Lookup by seqno (binary search; NULL if not present).
+  const pc_seg_summary_t *pc_catalog_find_seq(const pc_catalog_t *c, uint32_t seqno);
+
+  // Highest seqno in the catalog (0 if empty).
+  static inline uint32_t pc_catalog_max_seq(const pc_catalog_t *c)
+  {
+    return c->count ? c->segs[c->count - 1].seqno : 0u;
+  }
+
+  // Largest ts_max among entries 0..i (i.e. entry i and everything older).
+  static inline uint32_t pc_catalog_ts_max_upto(const pc_catalog_t *c, size_t i)
+  {
+    return c->ts_max_upto[i];
+  }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_CATALOG_H
@@ -7,11 +7,20 @@
 //
 // One-shot usage:
 //   uint32_t final = pc_crc32c(buf, len);          // does seed+update+finalize
+//
+// PR-026: accelerated implementations, picked once (on the first call)
+// - x86-64 with SSE4.2: crc32 instruction, three independent streams per chunk
+//   (hides the instruction latency) joined with precomputed shift tables
+// - AArch64 with the CRC extension: crc32c instructions, 8 bytes at a time
+// - otherwise: slicing-by-8 tables (portable C)
+// The byte-at-a-time table loop stays as the reference. Build with
+// PC_CRC32C_HW=0 to never use the instructions.
 #ifndef PC_CRC32C_H
 #define PC_CRC32C_H
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -22,9 +31,33 @@ extern "C"
 #define PC_CRC32C_SEED 0xFFFFFFFFu
 #define PC_CRC32C_FINALIZE(x) ((uint32_t)~(x))
 
+#ifndef PC_CRC32C_HW
+#define PC_CRC32C_HW 1
+#endif
+
+  typedef enum
+  {
+    PC_CRC32C_IMPL_TABLE = 0,  // byte-at-a-time reference
+    PC_CRC32C_IMPL_SLICE8 = 1, // slicing-by-8
+    PC_CRC32C_IMPL_HW = 2,     // SSE4.2 or ARMv8 CRC instructions
+    PC_CRC32C_IMPL_COUNT
+  } pc_crc32c_impl_t;
+
   // Streaming update: takes current CRC state (seeded) and returns new state (not finalized).
+  // Uses the fastest implementation available on this CPU.
   uint32_t pc_crc32c_update(uint32_t crc, const void *data, size_t len);
 
+  // pc_crc32c_update through one specific implementation (tests, benchmarks).
+  // Falls back to the reference loop if 'impl' is not available.
+  uint32_t pc_crc32c_update_with(pc_crc32c_impl_t impl, uint32_t crc, const void *data, size_t len);
+
+  // Can 'impl' run here?
+  bool pc_crc32c_available(pc_crc32c_impl_t impl);
+
+  // The implementation pc_crc32c_update dispatches to, and a short name for one.
+  pc_crc32c_impl_t pc_crc32c_active(void);
+  const char *pc_crc32c_impl_name(pc_crc32c_impl_t impl);
+
   // One-shot helper: computes CRC32C(buf,len) with standard seed and xor-out.
   static inline uint32_t pc_crc32c(const void *data, size_t len)
   {
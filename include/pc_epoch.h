@@ -0,0 +1,79 @@
+// PR-030: Epoch markers for bounded recovery
+// - An epoch is a PC_SEG_EPOCH segment recording where the log stood when it
+//   was written: next_seq, the allocator head and a bitmap of live sectors
+//   (catalogued DATA segments + the INDEX snapshot parts)
+// - Epochs live in a fixed superblock area (the first PC_EPOCH_SLOTS sectors,
+//   never handed out by the allocator) and alternate between the slots, so a
+//   crash while writing one leaves the previous epoch intact
+// - Mount picks the newest valid epoch, reads the commit headers of its live
+//   sectors and then walks forward from the allocator head, exactly as the
+//   allocator hands sectors out, until the first sector that was free at the
+//   epoch and still is. Everything else on the device is never read
+//
+//   [ slot 0 ][ slot 1 ][ ... live ... | head → new segments → first free ][ ... ]
+//
+// Typical flow:
+//   pc_epoch_t ep;
+//   if (pc_epoch_load(f, &ep, live, live_bytes) == PC_OK)
+//     pc_epoch_read_headers(f, &ep, live, hdrs, states, &end, NULL); // instead of pc_recover_read_headers
+
+#ifndef PC_EPOCH_H
+#define PC_EPOCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+#include "pc_flash.h"
+#include "pc_logseg.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PC_EPOCH_MAGIC 0x50434550u // 'P' 'C' 'E' 'P'
+#define PC_EPOCH_VERSION 1
+#define PC_EPOCH_SLOTS 2u // superblock sectors 0 .. PC_EPOCH_SLOTS-1
+
+  // Epoch payload, followed by (sector_count + 7) / 8 bytes of live bitmap
+  typedef struct __attribute__((packed))
+  {
+    uint32_t magic;        // PC_EPOCH_MAGIC
+    uint16_t version;      // PC_EPOCH_VERSION
+    uint16_t reserved;     // 0xFFFF
+    uint32_t seqno;        // of the epoch segment itself (set by pc_epoch_load)
+    uint32_t next_seq;     // first seqno not used when the epoch was written
+    uint32_t alloc_head;   // sector the allocator searches from next
+    uint32_t sector_count; // bits in the live bitmap
+  } pc_epoch_t;
+
+  // Bytes of live bitmap for this device
+  static inline size_t pc_epoch_live_bytes(const pc_flash_t *f) { return (pc_flash_sector_count(f) + 7) / 8; }
+
+  // Does an epoch (header + bitmap) fit in one segment of this device?
+  bool pc_epoch_fits(const pc_flash_t *f);
+
+  // Write an epoch into the slot not holding the newest one (erasing it first).
+  // 'seqno' is the epoch segment's own seqno; ep->next_seq must be greater.
+  // Returns PC_OK, PC_UNSUPPORTED (does not fit) or a flash error.
+  pc_result_t pc_epoch_write(pc_flash_t *f, const pc_epoch_t *ep, const uint8_t *live, uint32_t seqno);
+
+  // Newest valid epoch (CRC-checked) and its live bitmap ('live' holds live_bytes).
+  // Returns PC_OK, PC_METRIC_UNKNOWN (no epoch on the device) or PC_EINVAL.
+  pc_result_t pc_epoch_load(const pc_flash_t *f, pc_epoch_t *ep, uint8_t *live, size_t live_bytes);
+
+  // pc_recover_read_headers bounded by an epoch: states[] is filled for the
+  // live sectors and the forward walk from alloc_head; every other sector is
+  // PC_SECT_UNKNOWN. *end (optional) receives the sector the walk stopped at:
+  // the allocator must resume there for the next mount's walk to find what is
+  // written now. *headers_read (optional) counts the commit pages read.
+  pc_result_t pc_epoch_read_headers(const pc_flash_t *f, const pc_epoch_t *ep, const uint8_t *live,
+                                    pc_segment_hdr_t *hdrs, uint8_t *states,
+                                    size_t *end, size_t *headers_read);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_EPOCH_H
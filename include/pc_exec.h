@@ -0,0 +1,265 @@
+// PR-022: Batch-at-a-time query executor
+// - Source: walks catalog segments (ts pruning), their blocks (metric/series
+//   match + summary ts pruning) and decodes points into column batches of up
+//   to PC_EXEC_BATCH (ts[] and val[] arrays, one metric/series per batch)
+// - Operators form a push pipeline: each takes a batch, works on the columns
+//   in a tight loop and hands the result to 'next'
+//     source → time filter → value filter → aggregate | project
+// - Blocks with a summary are first offered whole (push_summary). Filters pass
+//   the offer on only if the whole block satisfies them; a sink that can fold
+//   the summary (aggregate) takes it and the block is never decoded
+//
+// New query types are new operators; the scanning/pruning stays in one place.
+//
+// PR-023: derivative operator (delta / per-second rate, optional counter-reset
+// handling). It keeps the previous point between batches, so block and segment
+// boundaries are invisible to it; a buffer sink collects derived points.
+//
+// PR-024: the source can select an explicit list of (metric, series) keys, and
+// an alignment sink scatters the points of each key into the slots of a common
+// time grid in the same single pass; a final sweep per key fills the grid
+// (last value carried forward or linear interpolation).
+//
+// Typical flow:
+//   pc_exec_agg_t agg;      pc_exec_agg_init(&agg, t0, bucket_secs, out, nbuckets);
+//   pc_exec_range_t tf;     pc_exec_range_init(&tf, t0, t1, &agg.op);
+//   pc_exec_src_t src;      pc_exec_src_init(&src, &spec, &tf.op);
+//   pc_exec_run_catalog(&src, &scan, &catalog);
+//   pc_exec_src_finish(&src);
+
+#ifndef PC_EXEC_H
+#define PC_EXEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+#include "pc_block.h"
+#include "pc_scan.h"
+#include "pc_catalog.h"
+#include "pc_tagindex.h"
+#include "pc_series.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Points per batch (two stack arrays of this size live in pc_exec_src_t).
+// Sized from PC_QUERY_BATCH, the most pc_query_scan hands its callback, so
+// overriding that one keeps the stack budget.
+#ifndef PC_QUERY_BATCH
+#define PC_QUERY_BATCH 256u
+#endif
+#ifndef PC_EXEC_BATCH
+#define PC_EXEC_BATCH PC_QUERY_BATCH
+#endif
+#if PC_EXEC_BATCH > PC_QUERY_BATCH
+#error "PC_EXEC_BATCH must not exceed PC_QUERY_BATCH"
+#endif
+
+#define PC_METRIC_ANY 0xFFFFu // metric wildcard
+#define PC_SERIES_ANY 0xFFFFu // series wildcard
+
+  // Column batch: n points of one metric/series
+  typedef struct
+  {
+    uint32_t n;
+    uint16_t metric_id;
+    uint16_t series_id;
+    uint32_t ts[PC_EXEC_BATCH];
+    float val[PC_EXEC_BATCH];
+  } pc_batch_t;
+
+  typedef struct pc_exec_op pc_exec_op_t;
+  struct pc_exec_op
+  {
+    // Consume a batch (filters compact it in place). Return false to stop the scan.
+    bool (*push)(pc_exec_op_t *op, pc_batch_t *b);
+    // Offer a whole block by its summary. Return true if it was consumed (the
+    // block is then not decoded). NULL = never.
+    bool (*push_summary)(pc_exec_op_t *op, const pc_block_summary_t *sum, uint32_t count,
+                         uint16_t metric_id, uint16_t series_id);
+    pc_exec_op_t *next;
+  };
+
+  // ---- Operators ----
+
+  // Keeps t0 <= ts <= t1
+  typedef struct
+  {
+    pc_exec_op_t op;
+    uint32_t t0, t1;
+  } pc_exec_range_t;
+  void pc_exec_range_init(pc_exec_range_t *f, uint32_t t0, uint32_t t1, pc_exec_op_t *next);
+
+  // Keeps lo <= val <= hi (NaN never passes)
+  typedef struct
+  {
+    pc_exec_op_t op;
+    float lo, hi;
+  } pc_exec_value_t;
+  void pc_exec_value_init(pc_exec_value_t *f, float lo, float hi, pc_exec_op_t *next);
+
+  // Aggregates for pc_exec_agg_t / pc_query_aggregate (bit mask)
+  enum
+  {
+    PC_AGG_MIN = 1u << 0,
+    PC_AGG_MAX = 1u << 1,
+    PC_AGG_SUM = 1u << 2,
+    PC_AGG_AVG = 1u << 3,
+    PC_AGG_COUNT = 1u << 4,
+    PC_AGG_ALL = 0x1Fu
+  };
+
+  typedef struct
+  {
+    uint32_t count; // always filled
+    float min;
+    float max;
+    double sum;
+    float avg;
+  } pc_bucket_t;
+
+  // Sink: folds points into buckets [t0 + k*bucket_secs, t0 + (k+1)*bucket_secs).
+  // Points outside the nbuckets buckets are ignored. out is zeroed at init.
+  typedef struct
+  {
+    pc_exec_op_t op;
+    uint32_t t0;
+    uint32_t bucket_secs;
+    pc_bucket_t *out;
+    uint32_t nbuckets;
+  } pc_exec_agg_t;
+  void pc_exec_agg_init(pc_exec_agg_t *a, uint32_t t0, uint32_t bucket_secs, pc_bucket_t *out, uint32_t nbuckets);
+  // Compute avg and zero the fields not in agg_mask.
+  void pc_exec_agg_finish(pc_exec_agg_t *a, uint32_t agg_mask);
+
+  // Sink: hands batches to a callback after skipping 'offset' points and stops
+  // after 'limit' points (0 = unlimited). The callback returns false to stop.
+  typedef bool (*pc_exec_cb_t)(void *ctx, const uint32_t *ts, const float *val, uint32_t n,
+                               uint16_t metric_id, uint16_t series_id);
+  typedef struct
+  {
+    pc_exec_op_t op;
+    pc_exec_cb_t cb;
+    void *ctx;
+    uint64_t skip;
+    uint64_t left;
+  } pc_exec_project_t;
+  void pc_exec_project_init(pc_exec_project_t *p, pc_exec_cb_t cb, void *ctx, uint64_t offset, uint64_t limit);
+
+  // Transform flags for pc_exec_deriv_t / pc_query_derive
+  enum
+  {
+    PC_DERIVE_DELTA = 0,        // v[i] - v[i-1]
+    PC_DERIVE_RATE = 1u << 0,   // (v[i] - v[i-1]) / (ts[i] - ts[i-1]), per second
+    PC_DERIVE_COUNTER = 1u << 1 // a drop is a counter reset: the delta is v[i] itself
+  };
+
+  // Replaces each point by its change since the previous point of the same
+  // metric/series, at the later timestamp. The first point has no predecessor and
+  // is dropped, as is any point not newer than its predecessor. The previous
+  // point is reset when a batch of another metric/series arrives.
+  typedef struct
+  {
+    pc_exec_op_t op;
+    uint32_t flags;
+    bool have_prev;
+    uint16_t metric_id, series_id;
+    uint32_t prev_ts;
+    float prev_val;
+  } pc_exec_deriv_t;
+  void pc_exec_deriv_init(pc_exec_deriv_t *d, uint32_t flags, pc_exec_op_t *next);
+
+  // Sink: copies points into caller arrays. Keeps the first 'cap'; 'total' counts all.
+  typedef struct
+  {
+    pc_exec_op_t op;
+    uint32_t *ts;
+    float *val;
+    uint32_t cap;
+    uint32_t count;
+    uint64_t total;
+  } pc_exec_buf_t;
+  void pc_exec_buf_init(pc_exec_buf_t *b, uint32_t *ts, float *val, uint32_t cap);
+
+  // How pc_exec_align_t fills a grid time with no sample exactly on it
+  typedef enum
+  {
+    PC_FILL_LOCF = 0,  // last sample at or before it (NaN before the first)
+    PC_FILL_LINEAR = 1 // interpolated between its neighbours (NaN outside them)
+  } pc_fill_t;
+
+  // Per key and grid slot [t0 + k*step, t0 + (k+1)*step): earliest + latest sample
+  typedef struct
+  {
+    uint32_t count;
+    uint32_t first_ts, last_ts;
+    float first_val, last_val;
+  } pc_align_slot_t;
+
+  // Sink: aligns the points of nkeys series on the grid t0 + k*step, k < nrows.
+  // Batches of other series and points outside the grid are ignored.
+  typedef struct
+  {
+    pc_exec_op_t op;
+    const pc_series_t *keys;
+    size_t nkeys;
+    uint32_t t0, step, nrows;
+    pc_align_slot_t *slots; // [nkeys][nrows]
+    size_t last_key;        // column of the previous batch (batches come in runs)
+  } pc_exec_align_t;
+  // Allocates the slots. PC_EINVAL / PC_NO_SPACE.
+  pc_result_t pc_exec_align_init(pc_exec_align_t *a, const pc_series_t *keys, size_t nkeys,
+                                 uint32_t t0, uint32_t step, uint32_t nrows);
+  // Fill out[row * nkeys + key] (row-major, nrows x nkeys) from the slots.
+  void pc_exec_align_finish(const pc_exec_align_t *a, pc_fill_t fill, float *out);
+  void pc_exec_align_free(pc_exec_align_t *a);
+
+  // ---- Source ----
+
+  // Which blocks the source reads (pruning only; filtering is up to the operators)
+  typedef struct
+  {
+    uint16_t metric_id;          // or PC_METRIC_ANY
+    uint16_t series_id;          // or PC_SERIES_ANY (ignored when series_set is set)
+    const pc_series_set_t *series_set;
+    uint32_t t0, t1;             // segments / summarized blocks outside are skipped
+    const pc_series_t *keys;     // if set, exactly these (metric, series) pairs
+    size_t nkeys;
+  } pc_exec_spec_t;
+
+  typedef struct
+  {
+    pc_exec_spec_t spec;
+    pc_exec_op_t *root;
+    bool stopped;
+    pc_result_t status; // first segment or block that failed to load (PC_OK = none)
+    pc_batch_t batch;   // pending points
+  } pc_exec_src_t;
+
+  void pc_exec_src_init(pc_exec_src_t *s, const pc_exec_spec_t *spec, pc_exec_op_t *root);
+
+  // Does the spec select (metric, series)?
+  bool pc_exec_src_match(const pc_exec_src_t *s, uint16_t metric_id, uint16_t series_id);
+
+  // Blocks of the segment currently loaded in 'sc' (committed or open). A block
+  // that fails to decode ends the segment and is recorded in s->status.
+  void pc_exec_run_blocks(pc_exec_src_t *s, pc_scan_t *sc);
+
+  // Every catalog segment overlapping [t0, t1], oldest first. Segments that fail
+  // to load are skipped and recorded in s->status; the walk goes on.
+  void pc_exec_run_catalog(pc_exec_src_t *s, pc_scan_t *sc, const pc_catalog_t *cat);
+
+  // One point from elsewhere (e.g. the ring), batched with its neighbours.
+  void pc_exec_src_point(pc_exec_src_t *s, uint16_t metric_id, uint16_t series_id, uint32_t ts, float val);
+
+  // Push the pending batch. Call once at the end.
+  void pc_exec_src_finish(pc_exec_src_t *s);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_EXEC_H
@@ -62,6 +62,12 @@ static inline size_t pc_flash_sector_count(const pc_flash_t* f){ return f->secto
 // Returns PC_OK or an error (PC_EINVAL for bounds, PC_FLASH_IO for bad sectors).
 pc_result_t pc_flash_read(const pc_flash_t* f, size_t addr, void* out, size_t len);
 
+// Zero-copy read-only view of [addr, addr+len). Same bounds/bad-sector checks as
+// pc_flash_read, done once for the whole range. The view reflects later programs
+// and is invalid after the sector is erased. Backends without memory-mapped flash
+// return PC_UNSUPPORTED; callers then fall back to pc_flash_read.
+pc_result_t pc_flash_map(const pc_flash_t* f, size_t addr, size_t len, const void** out);
+
 // Program len bytes at addr. Requirements:
 //  * addr and len must be multiples of prog_bytes
 //  * cannot set any bit 0 -> 1 (must have been erased)
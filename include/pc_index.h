@@ -0,0 +1,180 @@
+// PR-011: Persisted index snapshots (PC_SEG_INDEX) for fast mount
+//
+// A snapshot is a byte blob made of typed sections:
+//   [ pc_index_sec_hdr_t ][ body ] [ pc_index_sec_hdr_t ][ body ] ...
+// The blob is split across one or more INDEX segments ("parts"). Each part
+// starts with a pc_index_part_hdr_t, followed by its slice of the blob:
+//   [ pc_index_part_hdr_t ][ blob bytes ... ] ... (0xFF) [ commit header ]
+//
+// covered_seq is the watermark: every segment with seqno <= covered_seq that
+// is still live is described by the snapshot. Mount loads the newest complete
+// snapshot, trusts its catalog (after a header-only check that each sector
+// still holds the same seqno) and only CRC-verifies segments newer than the
+// watermark.
+//
+// PR-028: a lazy mount skips even that CRC pass. Newer segments are catalogued
+// from their commit header alone (magic, version, seqno) and reported in a
+// per-sector bitmap so the caller can verify them later.
+//
+// PR-030: with an epoch (pc_epoch.h) the header pass reads only the sectors
+// the epoch points at instead of every commit page on the device.
+//
+// Older snapshots are erased once a newer one is fully committed, so at most
+// one snapshot (plus a partial one after a crash) lives on flash.
+//
+// PR-034: with an erased pool (pc_alloc_t.pool_target) superseded parts are
+// only released; the pool refill erases them off the commit path, and mount
+// erases any it still finds.
+//
+// PR-035: the header pass's per-sector states are handed back (opts->states)
+// so the allocator starts with a complete free-space map.
+
+#ifndef PC_INDEX_H
+#define PC_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+#include "pc_flash.h"
+#include "pc_logseg.h"
+#include "pc_alloc.h"
+#include "pc_catalog.h"
+#include "pc_epoch.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define PC_INDEX_MAGIC 0x50434958u // 'P' 'C' 'I' 'X'
+#define PC_INDEX_VERSION 1
+
+  // Section kinds inside a snapshot blob
+  enum
+  {
+    PC_INDEX_SEC_CATALOG = 1, // pc_index_seg_rec_t[]
+    PC_INDEX_SEC_SERIES = 2   // series dictionary (pc_series.h)
+  };
+
+  typedef struct __attribute__((packed))
+  {
+    uint32_t magic;       // PC_INDEX_MAGIC
+    uint16_t version;     // PC_INDEX_VERSION
+    uint16_t part;        // 0 .. nparts-1
+    uint16_t nparts;      // parts in this snapshot
+    uint16_t reserved;    // 0xFFFF
+    uint32_t snap_seq;    // seqno of part 0 (identifies the snapshot)
+    uint32_t covered_seq; // watermark (see above)
+    uint32_t blob_bytes;  // total blob size
+    uint32_t part_bytes;  // blob bytes carried by this part
+  } pc_index_part_hdr_t;
+
+  typedef struct __attribute__((packed))
+  {
+    uint16_t kind;  // PC_INDEX_SEC_*
+    uint16_t flags; // reserved (0)
+    uint32_t bytes; // body length
+  } pc_index_sec_hdr_t;
+
+  // Catalog record (one per live DATA segment)
+  typedef struct __attribute__((packed))
+  {
+    uint32_t base;
+    uint32_t seqno;
+    uint32_t ts_min;
+    uint32_t ts_max;
+    uint32_t record_count;
+    uint16_t type;
+    uint16_t reserved;
+  } pc_index_seg_rec_t;
+
+  // Growable snapshot blob
+  typedef struct
+  {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+  } pc_index_blob_t;
+
+  void pc_index_blob_init(pc_index_blob_t *b);
+  void pc_index_blob_free(pc_index_blob_t *b);
+
+  // Append a section header and reserve 'bytes' for its body.
+  // Returns a pointer to the body (valid until the next append) or NULL on OOM.
+  uint8_t *pc_index_blob_section(pc_index_blob_t *b, uint16_t kind, size_t bytes);
+
+  // Find the first section of 'kind'. Returns PC_OK, PC_METRIC_UNKNOWN (absent) or PC_CORRUPT.
+  pc_result_t pc_index_blob_find(const pc_index_blob_t *b, uint16_t kind,
+                                 const uint8_t **out_body, size_t *out_bytes);
+
+  // Catalog <-> section
+  pc_result_t pc_index_put_catalog(pc_index_blob_t *b, const pc_catalog_t *c);
+
+  // The snapshot currently live on flash
+  typedef struct
+  {
+    size_t *bases; // part bases, in part order
+    size_t nparts;
+    uint32_t snap_seq;
+    uint32_t covered_seq;
+  } pc_index_t;
+
+  void pc_index_init(pc_index_t *ix);
+  void pc_index_free(pc_index_t *ix);
+
+  // Write 'blob' as a new snapshot, consuming seqnos from *next_seq. On success
+  // the previous snapshot is erased (released to the pool refill if 'a' keeps
+  // one) and 'ix' describes the new one. On failure
+  // any partially written parts are erased and the previous snapshot is kept.
+  pc_result_t pc_index_write(pc_index_t *ix, pc_flash_t *f, pc_alloc_t *a,
+                             const pc_index_blob_t *blob,
+                             uint32_t covered_seq, uint32_t *next_seq);
+
+  typedef struct
+  {
+    bool used_index;          // a valid snapshot was loaded
+    uint32_t covered_seq;     // its watermark (0 if none)
+    size_t headers_read;      // commit pages read (one per good sector)
+    size_t segments_trusted;  // catalog entries taken from the snapshot
+    size_t segments_verified; // segments fully CRC-verified during mount
+    size_t segments_deferred; // segments catalogued unverified (lazy mount)
+    uint32_t max_seqno;       // highest seqno in any commit header read (0 = none)
+    size_t newest_sector;     // sector holding it
+  } pc_mount_stats_t;
+
+  // Rebuild 'cat' from flash: newest complete snapshot + verify newer DATA segments.
+  // 'blob' receives the loaded snapshot (empty if none) so callers can read other
+  // sections. Stale INDEX parts (superseded or incomplete) are erased.
+  pc_result_t pc_index_mount(pc_index_t *ix, pc_flash_t *f, pc_catalog_t *cat,
+                             pc_index_blob_t *blob, pc_mount_stats_t *stats);
+
+  // Optional pc_index_mount_ex behaviour (zero = pc_index_mount)
+  typedef struct
+  {
+    // Lazy: DATA segments newer than the watermark are catalogued without their
+    // CRC check and bit (base / sector) is set here (sector_count bits, zeroed
+    // by the caller). NULL = verify now.
+    uint64_t *unverified;
+    // Bounded: read only the headers this epoch and its live bitmap point at.
+    const pc_epoch_t *epoch;
+    const uint8_t *epoch_live;
+    size_t epoch_end; // out: where the epoch walk stopped (see pc_epoch_read_headers)
+    // Out (optional, sector_count bytes): pc_sector_state_t of every sector as
+    // mount leaves it (sectors it erased read PC_SECT_FREE), to seed the allocator.
+    uint8_t *states;
+    // Threads for the header pass and the CRC pass (pc_recover_read_headers_mt,
+    // pc_recover_verify_sectors); 0 or 1 = the calling thread only, as do builds
+    // without PC_THREADS. Epoch mounts read their headers serially.
+    unsigned threads;
+  } pc_mount_opts_t;
+
+  pc_result_t pc_index_mount_ex(pc_index_t *ix, pc_flash_t *f, pc_catalog_t *cat,
+                                pc_index_blob_t *blob, pc_mount_stats_t *stats,
+                                pc_mount_opts_t *opts);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_INDEX_H
@@ -77,19 +77,39 @@ pc_result_t pc_logseg_program_data(pc_flash_t* f, size_t base, size_t offset, co
 pc_result_t pc_logseg_crc32c_region(const pc_flash_t* f, size_t base, uint32_t* out_crc);
 
 // Write the commit header (last step). This is the atomic "commit".
+// Reads the pre-header back to compute its CRC.
 pc_result_t pc_logseg_commit(pc_flash_t* f, size_t base,
                              uint16_t type, uint32_t seqno,
                              uint32_t ts_min, uint32_t ts_max, uint32_t record_count);
 
+// pc_logseg_commit with the (finalized) pre-header CRC supplied by a writer that
+// tracked it while programming: one page program, no reads.
+pc_result_t pc_logseg_commit_with_crc(pc_flash_t* f, size_t base,
+                                      uint16_t type, uint32_t seqno,
+                                      uint32_t ts_min, uint32_t ts_max, uint32_t record_count,
+                                      uint32_t crc32c);
+
 // Read & verify a segment. Returns:
 //   PC_OK       → committed and CRC is valid (out_hdr filled)
 //   PC_CORRUPT  → header present but CRC mismatch or bad magic/version
 //   PC_EINVAL   → bad alignment/args
 pc_result_t pc_logseg_verify(const pc_flash_t* f, size_t base, pc_segment_hdr_t* out_hdr);
 
+// CRC check of a segment whose header is already in hand (pc_logseg_read_header):
+// reads only the pre-header. PC_OK, PC_CORRUPT (mismatch) or a flash error.
+pc_result_t pc_logseg_verify_crc(const pc_flash_t* f, size_t base, const pc_segment_hdr_t* hdr);
+
 // Helper: is the commit page still erased (no header written)?
 bool pc_logseg_header_erased(const pc_flash_t* f, size_t base);
 
+// Read the commit header only (one page read, no CRC). Returns:
+//   PC_OK       → *out_erased=false and out_hdr filled (magic/version valid)
+//   PC_OK       → *out_erased=true when the commit page is still erased
+//   PC_CORRUPT  → page programmed but magic/version invalid
+//   PC_EINVAL / PC_FLASH_IO on bad args or unreadable sector
+pc_result_t pc_logseg_read_header(const pc_flash_t* f, size_t base,
+                                  pc_segment_hdr_t* out_hdr, bool* out_erased);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
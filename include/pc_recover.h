@@ -6,6 +6,13 @@
 //  - Otherwise → return a small summary for the caller.
 //
 // Matches README: "Forward recovery (linear, idempotent)".
+//
+// PR-029: pc_recover_scan_all_parallel splits the sector range across worker
+// threads (PC_THREADS builds), each verifying its share independently, then
+// hands every valid segment to a callback in seqno order (no output limit).
+// The mount path uses the same split for its header pass and its CRC pass
+// (pc_recover_read_headers_mt / pc_recover_verify_sectors, driven by
+// pc_mount_opts_t.threads and pc_db_config_t.mount_threads).
 
 #ifndef PC_RECOVER_H
 #define PC_RECOVER_H
@@ -20,6 +27,11 @@
 #ifdef __cplusplus
 extern "C"
 {
+#endif
+
+// Worker threads for the parallel scan (CMake option PC_THREADS sets 1)
+#ifndef PC_THREADS
+#define PC_THREADS 0
 #endif
 
   typedef struct
@@ -41,6 +53,47 @@ extern "C"
                                   size_t max_out,
                                   size_t *found);
 
+  // Receives one valid segment. Return false to stop.
+  typedef bool (*pc_recover_cb_t)(void *ctx, const pc_seg_summary_t *seg);
+
+  // pc_recover_scan_all on 'nthreads' threads (0 = 1). Each thread verifies a
+  // contiguous run of sectors; the results are merged and passed to 'cb' sorted
+  // by seqno (ties by address). *found (optional) = valid segments on the device.
+  // nthreads <= 1 runs on the calling thread. Returns PC_OK, PC_EINVAL,
+  // PC_NO_SPACE (allocation) or PC_UNSUPPORTED (nthreads > 1 without PC_THREADS).
+  pc_result_t pc_recover_scan_all_parallel(const pc_flash_t *f, unsigned nthreads,
+                                           pc_recover_cb_t cb, void *ctx, size_t *found);
+
+  // Per-sector state from a header-only pass (no CRC).
+  typedef enum
+  {
+    PC_SECT_FREE = 0,      // commit page erased (never committed / partial)
+    PC_SECT_COMMITTED = 1, // header present, magic/version valid (CRC not checked)
+    PC_SECT_CORRUPT = 2,   // commit page programmed but not a valid header
+    PC_SECT_BAD = 3,       // bad sector / unreadable
+    PC_SECT_UNKNOWN = 4    // not read (bounded mount from an epoch)
+  } pc_sector_state_t;
+
+  // State of one sector from its commit page; *hdr is set when COMMITTED.
+  pc_sector_state_t pc_recover_sector_state(const pc_flash_t *f, size_t idx, pc_segment_hdr_t *hdr);
+
+  // Read every commit header once. 'hdrs' and 'states' must hold sector_count entries;
+  // hdrs[i] is only meaningful when states[i] == PC_SECT_COMMITTED.
+  pc_result_t pc_recover_read_headers(const pc_flash_t *f,
+                                      pc_segment_hdr_t *hdrs,
+                                      uint8_t *states);
+
+  // pc_recover_read_headers with the sectors split across 'nthreads' threads.
+  // Without PC_THREADS (or nthreads <= 1) it runs on the calling thread.
+  pc_result_t pc_recover_read_headers_mt(const pc_flash_t *f, pc_segment_hdr_t *hdrs, uint8_t *states,
+                                         unsigned nthreads);
+
+  // CRC-check every sector whose verdict[i] is nonzero against hdrs[i] (from a
+  // header pass), on 'nthreads' threads as above. On return verdict[i] is 1 for
+  // a valid segment, 0 otherwise. Returns PC_OK, PC_EINVAL or PC_NO_SPACE.
+  pc_result_t pc_recover_verify_sectors(const pc_flash_t *f, const pc_segment_hdr_t *hdrs, uint8_t *verdict,
+                                        unsigned nthreads);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
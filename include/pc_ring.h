@@ -101,6 +101,11 @@ extern "C"
   // Valid until the slot is popped/overwritten.
   const void *pc_ring_peek(const pc_ring_t *r);
 
+  // Consumer convenience: pointer to the i-th queued element (0 = oldest), or NULL
+  // if i >= size. Lets the consumer read pending elements without popping them;
+  // the producer keeps pushing behind head and never touches these slots.
+  const void *pc_ring_peek_at(const pc_ring_t *r, uint32_t i);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
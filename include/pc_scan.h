@@ -0,0 +1,121 @@
+// PR-012: Segment block directory (reader side)
+// - Hops block headers to list every block of a segment without touching points
+// - Lets queries walk blocks newest-first and skip other metrics' points
+// - Owns reusable scratch (directory + segment image) sized from geometry
+// - PR-013: can also decode the open (uncommitted) segment from an in-RAM image:
+//   programmed pages read back from flash + the appender's staging page
+// - PR-015: segments are parsed from memory. The pre-header is mapped zero-copy
+//   with pc_flash_map when the backend supports it; otherwise whole program
+//   pages are read into the image on first touch (one bus transaction per run
+//   of missing pages, never one per header or point)
+// - PR-021: with a pc_blockcache_t attached, segments loaded by pc_scan_load_seg
+//   in page-read mode reuse cached directories and block points, so repeated
+//   queries over the same recent blocks issue no flash reads. Mapped segments
+//   are already zero-copy and bypass the cache
+// - PR-028: an optional 'check' hook runs before pc_scan_load_seg decodes a
+//   segment; the db uses it to CRC-verify lazily mounted segments on first read
+//
+// Typical flow:
+//   pc_scan_t sc;
+//   pc_scan_init(&sc, flash);
+//   pc_scan_load_dir(&sc, seg->base, seg->record_count);
+//   for (size_t b = sc.nblocks; b-- > 0;) {           // newest block first
+//     if (sc.dir[b].hdr.metric_id != m) continue;    // points never read
+//     const pc_point_disk_t *pts;
+//     pc_scan_block_points(&sc, b, &pts);
+//   }
+//
+// Not thread-safe: one pc_scan_t per reader.
+
+#ifndef PC_SCAN_H
+#define PC_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+#include "pc_flash.h"
+#include "pc_block.h"
+#include "pc_appender.h"
+#include "pc_recover.h"
+#include "pc_blockcache.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef struct
+  {
+    uint32_t off;           // offset of the block header inside the pre-header
+    pc_block_hdr_t hdr;     // copy of the header (point_count with flag bits stripped)
+    uint32_t flags;         // PC_BLOCK_F_* from the header
+    pc_block_summary_t sum; // valid when flags & PC_BLOCK_F_SUMMARY
+    uint32_t sketch_off;    // encoded sketch (when flags & PC_BLOCK_F_SKETCH)
+    uint32_t sketch_len;
+  } pc_blockdir_ent_t;
+
+  typedef struct
+  {
+    const pc_flash_t *f;
+    size_t preH;
+    size_t prog;
+
+    pc_blockdir_ent_t *dir; // blocks of the loaded segment, in write order
+    size_t dir_cap;
+    size_t nblocks;
+
+    // View of the loaded segment's pre-header: either mapped flash or seg_buf.
+    const uint8_t *mem;
+    size_t mem_len;
+    uint8_t *seg_buf;    // preH bytes
+    uint8_t *page_valid; // per program page of seg_buf (page-read mode)
+    size_t lazy_base;    // segment base being paged in (page-read mode)
+    bool lazy;           // seg_buf is filled on demand from flash
+    bool use_map;        // try pc_flash_map first (default true)
+
+    pc_blockcache_t *cache; // optional (not owned)
+    uint32_t seqno;         // of the loaded segment; 0 = not cacheable
+
+    // Optional gate for pc_scan_load_seg: anything but PC_OK is returned as is
+    // and the segment is not loaded.
+    pc_result_t (*check)(void *ctx, const pc_seg_summary_t *seg);
+    void *check_ctx;
+
+    // Work counters (for tests / tuning)
+    size_t dirs_loaded;
+    size_t blocks_read;
+    size_t flash_reads; // pc_flash_read / pc_flash_map calls issued
+  } pc_scan_t;
+
+  // Allocate scratch for the device geometry. Returns PC_EINVAL / PC_NO_SPACE on failure.
+  pc_result_t pc_scan_init(pc_scan_t *s, const pc_flash_t *f);
+
+  // Free scratch. Safe on a zeroed struct.
+  void pc_scan_free(pc_scan_t *s);
+
+  // Build the block directory of the segment at 'base' holding 'record_count' points.
+  // Returns PC_OK, PC_CORRUPT (headers run past the pre-header) or a flash error.
+  pc_result_t pc_scan_load_dir(pc_scan_t *s, size_t base, uint32_t record_count);
+
+  // pc_scan_load_dir for a catalog entry; its seqno makes the blocks cacheable.
+  // Runs the 'check' hook first when one is set.
+  pc_result_t pc_scan_load_seg(pc_scan_t *s, const pc_seg_summary_t *seg);
+
+  // Build the block directory of an open appender's segment (blocks appended so
+  // far, including those still in the staging page). Consumer/flusher thread only.
+  pc_result_t pc_scan_load_open(pc_scan_t *s, const pc_appender_t *a);
+
+  // Points of block 'idx' of the loaded directory. The pointer aliases the segment
+  // view or a cache entry (no copy) and stays valid until the next pc_scan call.
+  pc_result_t pc_scan_block_points(pc_scan_t *s, size_t idx, const pc_point_disk_t **out_pts);
+
+  // Encoded quantile sketch of block 'idx' (aliases the view like the points).
+  // PC_METRIC_UNKNOWN if the block has none.
+  pc_result_t pc_scan_block_sketch(pc_scan_t *s, size_t idx, const uint8_t **out, size_t *out_len);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_SCAN_H
@@ -0,0 +1,125 @@
+// PR-019: Series dictionary (metric names + tags → ids)
+// - A series is a metric name plus an optional tag set ("k=v" pairs). Its
+//   canonical key is the name followed by the tags sorted by key:
+//     name [ '\0' key '=' value ]...
+//   so the same tags in any order resolve to the same ids
+// - metric_id is allocated per distinct name (from 1); series_id per distinct
+//   tagged series (from 1). An untagged series keeps series_id 0, as before
+// - Forward lookup: open-addressing table of {hash, entry} pairs (linear
+//   probing, load factor <= 1/2), so a probe touches one cache line
+// - Reverse lookup: metric_id / series_id → entry, for describing ids
+// - Persisted as the PC_INDEX_SEC_SERIES section of INDEX snapshots
+// - PR-020: keeps a tag inverted index (pc_tagindex.h) of its tagged series
+//
+// Resolve once, then write through the returned pc_series_t handle: hot-path
+// writes carry the ids and never hash.
+//
+// Not thread-safe: resolve/describe and snapshots share one thread (the flusher
+// in firmware, or the producer before it starts). Handles can be used anywhere.
+
+#ifndef PC_SERIES_H
+#define PC_SERIES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+#include "pc_index.h"
+#include "pc_tagindex.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef PC_SERIES_CAPACITY_DEFAULT
+#define PC_SERIES_CAPACITY_DEFAULT 256u // entries (metric names + tagged series)
+#endif
+#define PC_SERIES_CAPACITY_MAX 0xFFFEu  // ids are uint16_t
+#define PC_SERIES_MAX_TAGS 8u
+#define PC_SERIES_MAX_KEY 255u // canonical key bytes
+
+  // Interned handle: the ids a series resolved to.
+  typedef struct
+  {
+    uint16_t metric_id;
+    uint16_t series_id;
+  } pc_series_t;
+
+  typedef struct
+  {
+    uint32_t hash;
+    uint16_t metric_id;
+    uint16_t series_id; // 0 for a metric name entry
+    uint32_t key_off;   // into keys
+    uint16_t key_len;
+    uint16_t ntags;
+  } pc_series_ent_t;
+
+  typedef struct
+  {
+    pc_series_ent_t *ents; // in creation order
+    size_t count;
+    size_t capacity; // max entries
+
+    // Forward table: 2^k slots of {hash, entry index + 1 (0 = empty)}
+    uint32_t *slots;
+    size_t nslots;
+
+    // Reverse: id → entry index (sized capacity + 1)
+    uint16_t *by_metric;
+    uint16_t *by_series;
+    uint16_t next_metric;
+    uint16_t next_series;
+
+    // Canonical keys, back to back
+    char *keys;
+    size_t keys_len, keys_cap;
+
+    bool dirty; // changed since the last snapshot
+
+    pc_tagindex_t tags; // "k=v" → tagged series ids
+  } pc_series_dict_t;
+
+  // Allocate a dictionary for 'capacity' entries (1..PC_SERIES_CAPACITY_MAX).
+  pc_result_t pc_series_dict_init(pc_series_dict_t *d, size_t capacity);
+  void pc_series_dict_free(pc_series_dict_t *d);
+
+  // Raise the capacity (rehashes). PC_EINVAL if below the current count or the max.
+  pc_result_t pc_series_dict_reserve(pc_series_dict_t *d, size_t capacity);
+
+  // Ids for (name, tags), creating them on first use.
+  // Returns PC_OK, PC_TOO_MANY_SERIES (dictionary full), PC_EINVAL (empty name,
+  // duplicate tag key, '=' in a tag key, too many tags, key too long) or PC_NO_SPACE.
+  pc_result_t pc_series_dict_resolve(pc_series_dict_t *d, const char *name,
+                                     const pc_tag_t *tags, size_t ntags, pc_series_t *out);
+
+  // Lookup without creating. PC_METRIC_UNKNOWN if absent.
+  pc_result_t pc_series_dict_find(const pc_series_dict_t *d, const char *name,
+                                  const pc_tag_t *tags, size_t ntags, pc_series_t *out);
+
+  // Canonical key of (metric_id, series_id). PC_METRIC_UNKNOWN if not in the dictionary.
+  pc_result_t pc_series_dict_key(const pc_series_dict_t *d, pc_series_t s,
+                                 const char **out_key, size_t *out_len);
+
+  // Format ids as "name" or "name{k=v,k2=v2}" into buf (NUL-terminated).
+  // PC_METRIC_UNKNOWN if unknown, PC_NO_SPACE if buf is too small.
+  pc_result_t pc_series_dict_describe(const pc_series_dict_t *d, pc_series_t s, char *buf, size_t cap);
+
+  // Snapshot section <-> dictionary. Load replaces the contents (growing the
+  // capacity if the snapshot holds more) and clears 'dirty'.
+  pc_result_t pc_series_dict_save(const pc_series_dict_t *d, pc_index_blob_t *b);
+  pc_result_t pc_series_dict_load(pc_series_dict_t *d, const uint8_t *body, size_t bytes);
+
+  // Tagged series matching every tags[i] (see pc_tagindex_select).
+  static inline pc_result_t pc_series_dict_select(const pc_series_dict_t *d, const pc_tag_t *tags,
+                                                  size_t ntags, pc_series_set_t *out)
+  {
+    return d ? pc_tagindex_select(&d->tags, tags, ntags, out) : PC_EINVAL;
+  }
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_SERIES_H
@@ -0,0 +1,109 @@
+// PR-018: Mergeable quantile sketch (fixed-bucket log histogram)
+// - A value's bucket is its float exponent plus the top PC_SKETCH_SUB_BITS bits
+//   of its mantissa, so binning is a few bit operations (no libm)
+// - Every bucket spans at most 2^-PC_SKETCH_SUB_BITS of its lower bound; answering
+//   with the bucket midpoint gives relative error <= PC_SKETCH_REL_ERROR
+// - Negative values use a mirrored set of buckets; zero and subnormals share one
+//   zero bucket; NaN / +-Inf are ignored
+//
+// On flash (after a block's summary when PC_BLOCK_F_SKETCH is set):
+//   [ pc_sketch_hdr_t ][ pc_sketch_bin_t x nneg ][ pc_sketch_bin_t x npos ]
+// Bins are sorted by key and only non-empty buckets are stored.
+//
+// Typical flow (reader side):
+//   pc_sketch_acc_t acc;
+//   pc_sketch_acc_init(&acc);
+//   pc_sketch_acc_merge(&acc, encoded, len);   // per block with a sketch
+//   pc_sketch_acc_add(&acc, value);            // per raw point otherwise
+//   pc_sketch_acc_quantile(&acc, 0.99f, &p99);
+//   pc_sketch_acc_free(&acc);
+
+#ifndef PC_SKETCH_H
+#define PC_SKETCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "pc_result.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Mantissa bits per bucket: 6 → 64 buckets per power of two.
+#ifndef PC_SKETCH_SUB_BITS
+#define PC_SKETCH_SUB_BITS 6u
+#endif
+#if PC_SKETCH_SUB_BITS < 1 || PC_SKETCH_SUB_BITS > 8
+#error "PC_SKETCH_SUB_BITS must be in 1..8"
+#endif
+
+// Guaranteed relative error of a quantile answer (midpoint of the bucket).
+#define PC_SKETCH_REL_ERROR (1.0 / (double)(2u << PC_SKETCH_SUB_BITS))
+
+// Largest block the appender sketches (keys are sorted on the stack).
+#ifndef PC_SKETCH_MAX_POINTS
+#define PC_SKETCH_MAX_POINTS 256u
+#endif
+
+  typedef struct __attribute__((packed))
+  {
+    uint8_t sub_bits;    // PC_SKETCH_SUB_BITS of the writer
+    uint8_t reserved;    // 0
+    uint16_t nneg;       // bins for negative values
+    uint16_t npos;       // bins for positive values
+    uint16_t reserved2;  // 0
+    uint32_t zero_count; // values in the zero bucket
+  } pc_sketch_hdr_t;
+
+  typedef struct __attribute__((packed))
+  {
+    uint16_t key;   // bucket of |v|
+    uint16_t count; // values in it (a full bucket is split over several bins)
+  } pc_sketch_bin_t;
+
+// Worst-case encoded size (PC_SKETCH_MAX_POINTS distinct buckets).
+#define PC_SKETCH_MAX_BYTES (sizeof(pc_sketch_hdr_t) + PC_SKETCH_MAX_POINTS * sizeof(pc_sketch_bin_t))
+
+  // Encode a sketch of val[0..n) into out (cap bytes). n <= PC_SKETCH_MAX_POINTS.
+  // Returns the encoded size, or 0 on bad arguments / not enough room.
+  size_t pc_sketch_encode(const float *val, uint32_t n, uint8_t *out, size_t cap);
+
+  // Encoded size of the sketch at p (reads only the header). 0 if p is not a sketch.
+  size_t pc_sketch_encoded_bytes(const uint8_t *p, size_t avail);
+
+  // Per-sign dense counters over [lo, lo + n) keys, grown on demand.
+  typedef struct
+  {
+    uint64_t *cnt;
+    uint32_t lo;
+    uint32_t n;
+  } pc_sketch_side_t;
+
+  // In-RAM merge target for any number of sketches and raw values.
+  typedef struct
+  {
+    pc_sketch_side_t neg, pos;
+    uint64_t zero;
+    uint64_t total;
+  } pc_sketch_acc_t;
+
+  void pc_sketch_acc_init(pc_sketch_acc_t *acc);
+  void pc_sketch_acc_free(pc_sketch_acc_t *acc);
+
+  // Add one raw value (binned exactly like the encoder does). PC_NO_SPACE on allocation failure.
+  pc_result_t pc_sketch_acc_add(pc_sketch_acc_t *acc, float v);
+
+  // Merge one encoded sketch. PC_CORRUPT if malformed, PC_UNSUPPORTED if it was
+  // written with different PC_SKETCH_SUB_BITS (callers then fall back to raw points).
+  pc_result_t pc_sketch_acc_merge(pc_sketch_acc_t *acc, const uint8_t *p, size_t len);
+
+  // Value at quantile q in [0, 1] (rank floor(q * (total - 1)), ascending).
+  // PC_EINVAL for a bad q, PC_METRIC_UNKNOWN if the accumulator is empty.
+  pc_result_t pc_sketch_acc_quantile(const pc_sketch_acc_t *acc, float q, float *out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_SKETCH_H
@@ -0,0 +1,109 @@
+// PR-020: Tag inverted index ("k=v" → series ids)
+// - One posting per distinct tag pair. A posting starts as a sorted uint16_t id
+//   array and switches to a bitset once the bitset is smaller (card * 16 >= ids
+//   spanned), the usual array/bitmap container split of compressed bitmaps
+// - A selector (k1=v1 AND k2=v2 ...) is answered smallest posting first: the
+//   first one is expanded into a pc_series_set_t, the others are ANDed into it
+//   64 ids per word
+// - Owned and fed by the series dictionary; it is rebuilt from the dictionary's
+//   snapshot section at mount, so nothing extra is persisted
+
+#ifndef PC_TAGINDEX_H
+#define PC_TAGINDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "pc_result.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Most key=value pairs in one selector (pc_tagindex_select keeps a pointer
+// per pair on the stack)
+#define PC_TAGINDEX_SELECT_MAX 16u
+
+  // FNV-1a over n bytes. The series dictionary's key table and the posting
+  // table both hash with it, so the two stay consistent.
+  static inline uint32_t pc_fnv1a(const char *p, size_t n)
+  {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i)
+    {
+      h ^= (uint8_t)p[i];
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  typedef struct
+  {
+    const char *key;
+    const char *value;
+  } pc_tag_t;
+
+  // Set of series ids (bit i = series_id i)
+  typedef struct
+  {
+    uint64_t *words;
+    size_t nwords;
+    size_t count; // ids in the set
+  } pc_series_set_t;
+
+  void pc_series_set_init(pc_series_set_t *s);
+  void pc_series_set_free(pc_series_set_t *s);
+
+  static inline bool pc_series_set_has(const pc_series_set_t *s, uint16_t id)
+  {
+    size_t w = id >> 6;
+    return w < s->nwords && ((s->words[w] >> (id & 63u)) & 1u);
+  }
+
+  typedef struct
+  {
+    uint32_t hash;
+    uint32_t str_off; // "k=v" in the index's string arena
+    uint16_t str_len;
+    bool dense;       // words (bitset) instead of ids (array)
+    uint32_t card;
+    uint16_t *ids;    // array form: sorted ids
+    uint32_t ids_cap;
+    uint64_t *words;  // bitset form
+    size_t nwords;
+  } pc_tag_posting_t;
+
+  typedef struct
+  {
+    pc_tag_posting_t *posts;
+    size_t count, cap;
+    uint32_t *slots; // open addressing: posting index + 1 (0 = empty)
+    size_t nslots;
+    char *strs;
+    size_t strs_len, strs_cap;
+  } pc_tagindex_t;
+
+  void pc_tagindex_init(pc_tagindex_t *ix);
+  void pc_tagindex_free(pc_tagindex_t *ix);
+  void pc_tagindex_clear(pc_tagindex_t *ix);
+
+  // Record that series_id carries tag "k=v" (kv_len bytes). Ids must be added in
+  // increasing order per posting (the dictionary hands them out that way).
+  pc_result_t pc_tagindex_add(pc_tagindex_t *ix, const char *kv, size_t kv_len, uint16_t series_id);
+
+  // Undo pc_tagindex_add: drop series_id from the posting of "k=v" (the posting
+  // itself stays, possibly empty). Used to roll back a failed insert.
+  void pc_tagindex_remove(pc_tagindex_t *ix, const char *kv, size_t kv_len, uint16_t series_id);
+
+  // Series carrying every key=value in tags[0..ntags) (1 <= ntags <=
+  // PC_TAGINDEX_SELECT_MAX) into out (replacing its contents). Unknown pairs
+  // give an empty set. Returns PC_OK, PC_EINVAL or PC_NO_SPACE.
+  pc_result_t pc_tagindex_select(const pc_tagindex_t *ix, const pc_tag_t *tags, size_t ntags,
+                                 pc_series_set_t *out);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PC_TAGINDEX_H
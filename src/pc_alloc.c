@@ -1,4 +1,47 @@
 #include "pc_alloc.h"
+#include "pc_recover.h"
+#include <stdlib.h>
+
+// Bitmap words to search: free (incl. unknown), erased, or free but not erased
+typedef enum
+{
+  MAP_FREE,
+  MAP_ERASED,
+  MAP_DIRTY
+} map_kind_t;
+
+static uint64_t map_word(const pc_alloc_t *a, size_t w, map_kind_t kind)
+{
+  switch (kind)
+  {
+  case MAP_ERASED:
+    return a->erased_map[w];
+  case MAP_DIRTY:
+    return a->free_map[w] & ~a->erased_map[w];
+  default:
+    return a->free_map[w];
+  }
+}
+
+// First set bit in [from, end), or end: one ctz per word with a candidate.
+static size_t next_set(const pc_alloc_t *a, map_kind_t kind, size_t from, size_t end)
+{
+  if (from >= end)
+    return end;
+  size_t w = from / 64;
+  uint64_t bits = map_word(a, w, kind) & (~0ull << (from % 64));
+  for (;;)
+  {
+    if (bits)
+    {
+      const size_t idx = w * 64 + (size_t)__builtin_ctzll(bits);
+      return idx < end ? idx : end;
+    }
+    if (++w * 64 >= end)
+      return end;
+    bits = map_word(a, w, kind);
+  }
+}
 
 pc_result_t pc_alloc_init(pc_alloc_t *a, pc_flash_t *f)
 {
@@ -11,31 +54,266 @@ pc_result_t pc_alloc_init(pc_alloc_t *a, pc_flash_t *f)
     return PC_EINVAL;
   a->sector_count = pc_flash_total(f) / a->seg_bytes;
   a->next_index = 0;
+  a->first_index = 0;
+  a->policy = PC_ALLOC_NEXT;
+  a->wear_limit = 0;
+  a->pool_target = 0;
+  a->erased = 0;
+  a->pool_misses = 0;
+  const size_t words = (a->sector_count + 63) / 64;
+  a->state = (uint8_t *)calloc(a->sector_count ? a->sector_count : 1, 1);
+  a->free_map = (uint64_t *)calloc(words ? words : 1, sizeof(uint64_t));
+  a->erased_map = (uint64_t *)calloc(words ? words : 1, sizeof(uint64_t));
+  if (!a->state || !a->free_map || !a->erased_map)
+  {
+    pc_alloc_deinit(a);
+    return PC_NO_SPACE;
+  }
+  // Unknown sectors are candidates until probed.
+  for (size_t i = 0; i < a->sector_count; ++i)
+    a->free_map[i / 64] |= 1ull << (i % 64);
   return PC_OK;
 }
 
+void pc_alloc_deinit(pc_alloc_t *a)
+{
+  if (!a)
+    return;
+  free(a->state);
+  free(a->free_map);
+  free(a->erased_map);
+  a->state = NULL;
+  a->free_map = NULL;
+  a->erased_map = NULL;
+  a->erased = 0;
+}
+
+static void set_state(pc_alloc_t *a, size_t idx, pc_alloc_state_t st)
+{
+  const uint64_t bit = 1ull << (idx % 64);
+  if (a->state[idx] == PC_ALLOC_FREE_ERASED)
+    a->erased--;
+  if (st == PC_ALLOC_FREE_ERASED)
+    a->erased++;
+  a->state[idx] = (uint8_t)st;
+  if (st == PC_ALLOC_UNKNOWN || st == PC_ALLOC_FREE_DIRTY || st == PC_ALLOC_FREE_ERASED)
+    a->free_map[idx / 64] |= bit;
+  else
+    a->free_map[idx / 64] &= ~bit;
+  if (st == PC_ALLOC_FREE_ERASED)
+    a->erased_map[idx / 64] |= bit;
+  else
+    a->erased_map[idx / 64] &= ~bit;
+}
+
+void pc_alloc_load_states(pc_alloc_t *a, const uint8_t *states, pc_alloc_state_t unknown_as)
+{
+  if (!a || !a->state || !states)
+    return;
+  for (size_t i = 0; i < a->sector_count; ++i)
+  {
+    switch (states[i])
+    {
+    case PC_SECT_FREE:
+      set_state(a, i, PC_ALLOC_FREE_DIRTY);
+      break;
+    case PC_SECT_BAD:
+      set_state(a, i, PC_ALLOC_BAD);
+      break;
+    case PC_SECT_UNKNOWN:
+      set_state(a, i, unknown_as);
+      break;
+    default: // committed, or a header that never becomes free again
+      set_state(a, i, PC_ALLOC_COMMITTED);
+      break;
+    }
+  }
+}
+
+pc_alloc_state_t pc_alloc_state(pc_alloc_t *a, size_t idx)
+{
+  if (!a || !a->state || idx >= a->sector_count)
+    return PC_ALLOC_BAD;
+  if (pc_flash_is_bad(a->f, idx))
+  {
+    set_state(a, idx, PC_ALLOC_BAD);
+    return PC_ALLOC_BAD;
+  }
+  if (a->state[idx] == PC_ALLOC_UNKNOWN)
+  {
+    // "Free" means commit page is fully erased (no header); the pages before
+    // it may still hold a torn write.
+    const bool is_free = pc_logseg_header_erased(a->f, idx * a->seg_bytes);
+    set_state(a, idx, is_free ? PC_ALLOC_FREE_DIRTY : PC_ALLOC_COMMITTED);
+  }
+  return (pc_alloc_state_t)a->state[idx];
+}
+
+static bool retired(const pc_alloc_t *a, size_t idx)
+{
+  return a->wear_limit && a->f->wear[idx] >= a->wear_limit;
+}
+
 pc_result_t pc_alloc_acquire(pc_alloc_t *a, size_t *out_base)
 {
-  if (!a || !out_base)
+  if (!a)
+    return PC_EINVAL;
+  return pc_alloc_acquire_policy(a, a->policy, out_base);
+}
+
+pc_result_t pc_alloc_acquire_policy(pc_alloc_t *a, pc_alloc_policy_t policy, size_t *out_base)
+{
+  return pc_alloc_acquire_ex(a, policy, out_base, NULL);
+}
+
+// Free sector the policy picks among the 'kind' bits, or sector_count.
+static size_t pick_in(pc_alloc_t *a, pc_alloc_policy_t policy, map_kind_t kind, bool *worn_out)
+{
+  const size_t start = a->next_index < a->first_index || a->next_index >= a->sector_count ? a->first_index
+                                                                                            : a->next_index;
+  // Circular order: [start, count) then [first_index, start)
+  const size_t from[2] = {start, a->first_index};
+  const size_t end[2] = {a->sector_count, start};
+  size_t best = a->sector_count;
+  for (int r = 0; r < 2; ++r)
+  {
+    for (size_t idx = next_set(a, kind, from[r], end[r]); idx < end[r]; idx = next_set(a, kind, idx + 1, end[r]))
+    {
+      // Probes unknown sectors (never after pc_alloc_load_states) and bad ones.
+      const pc_alloc_state_t st = pc_alloc_state(a, idx);
+      if (st != PC_ALLOC_FREE_DIRTY && st != PC_ALLOC_FREE_ERASED)
+        continue;
+      if (retired(a, idx))
+      {
+        if (worn_out)
+          *worn_out = true;
+        continue;
+      }
+      if (policy == PC_ALLOC_NEXT)
+        return idx;
+      // Strict comparison: equal wear keeps the earlier sector in circular order.
+      if (best == a->sector_count ||
+          (policy == PC_ALLOC_LEAST_WORN && a->f->wear[idx] < a->f->wear[best]) ||
+          (policy == PC_ALLOC_MOST_WORN && a->f->wear[idx] > a->f->wear[best]))
+        best = idx;
+    }
+  }
+  return best;
+}
+
+// Free sector the policy picks, or sector_count. Erased sectors win over dirty
+// ones when 'prefer_erased'; 'dirty_only' skips erased ones (pool refill).
+static size_t pick(pc_alloc_t *a, pc_alloc_policy_t policy, bool prefer_erased, bool dirty_only, bool *worn_out)
+{
+  if (dirty_only)
+    return pick_in(a, policy, MAP_DIRTY, NULL);
+  if (prefer_erased && a->erased && policy != PC_ALLOC_NEXT)
+  {
+    const size_t idx = pick_in(a, policy, MAP_ERASED, worn_out);
+    if (idx < a->sector_count)
+      return idx;
+  }
+  return pick_in(a, policy, MAP_FREE, worn_out);
+}
+
+pc_result_t pc_alloc_acquire_ex(pc_alloc_t *a, pc_alloc_policy_t policy, size_t *out_base, bool *pre_erased)
+{
+  if (!a || !out_base || !a->state)
     return PC_EINVAL;
-  if (a->sector_count == 0)
+  if (a->first_index >= a->sector_count)
     return PC_EINVAL;
 
-  for (size_t step = 0; step < a->sector_count; ++step)
+  bool worn_out = false;
+  const size_t best = pick(a, policy, a->pool_target != 0, false, &worn_out);
+  if (best == a->sector_count)
+    return worn_out ? PC_FLASH_WEAR : PC_NO_SPACE;
+
+  const bool erased = a->state[best] == PC_ALLOC_FREE_ERASED;
+  if (!erased && a->pool_target)
+    a->pool_misses++;
+  set_state(a, best, PC_ALLOC_OPEN);
+
+  // Choose this one and advance pointer for next time
+  a->next_index = best + 1 < a->sector_count ? best + 1 : a->first_index;
+  *out_base = best * a->seg_bytes;
+  if (pre_erased)
+    *pre_erased = erased;
+  return PC_OK;
+}
+
+void pc_alloc_commit(pc_alloc_t *a, size_t base)
+{
+  if (a && a->state && base / a->seg_bytes < a->sector_count)
+    set_state(a, base / a->seg_bytes, PC_ALLOC_COMMITTED);
+}
+
+void pc_alloc_release(pc_alloc_t *a, size_t base, bool erased)
+{
+  if (a && a->state && base / a->seg_bytes < a->sector_count)
+    set_state(a, base / a->seg_bytes, erased ? PC_ALLOC_FREE_ERASED : PC_ALLOC_FREE_DIRTY);
+}
+
+// Does the whole sector read back as erased?
+static bool blank(const pc_alloc_t *a, size_t idx)
+{
+  uint8_t buf[256];
+  for (size_t off = 0; off < a->seg_bytes; off += sizeof buf)
   {
-    size_t idx = (a->next_index + step) % a->sector_count;
-    if (pc_flash_is_bad(a->f, idx))
-      continue;
+    const size_t n = a->seg_bytes - off < sizeof buf ? a->seg_bytes - off : sizeof buf;
+    if (pc_flash_read(a->f, idx * a->seg_bytes + off, buf, n) != PC_OK)
+      return false;
+    for (size_t k = 0; k < n; ++k)
+      if (buf[k] != a->f->erased_val)
+        return false;
+  }
+  return true;
+}
 
-    size_t base = idx * a->seg_bytes;
-    // "Free" means commit page is fully erased (no header)
-    if (pc_logseg_header_erased(a->f, base))
+pc_result_t pc_alloc_refill_step(pc_alloc_t *a, size_t max_erases, size_t *erased)
+{
+  if (!a || !a->state)
+    return PC_EINVAL;
+  size_t n = 0;
+  pc_result_t st = PC_OK;
+  // Dirty sectors in the order acquire would take them.
+  while (a->erased < a->pool_target && n < max_erases && a->first_index < a->sector_count)
+  {
+    const size_t idx = pick(a, a->policy, false, true, NULL);
+    if (idx == a->sector_count)
+      break;
+    if (!blank(a, idx))
     {
-      // Choose this one and advance pointer for next time
-      a->next_index = (idx + 1) % a->sector_count;
-      *out_base = base;
-      return PC_OK;
+      st = pc_flash_erase_sector(a->f, idx);
+      if (st != PC_OK)
+        break;
+      n++;
     }
+    set_state(a, idx, PC_ALLOC_FREE_ERASED);
+  }
+  if (erased)
+    *erased = n;
+  return st;
+}
+
+pc_result_t pc_alloc_cold_sector(const pc_alloc_t *a, const uint64_t *in_use,
+                                 uint32_t wear_delta, size_t *out_index)
+{
+  if (!a || !in_use || !out_index)
+    return PC_EINVAL;
+  uint32_t hottest = 0;
+  size_t cold = a->sector_count;
+  for (size_t idx = a->first_index; idx < a->sector_count; ++idx)
+  {
+    if (pc_flash_is_bad(a->f, idx) || retired(a, idx))
+      continue;
+    const uint32_t w = a->f->wear[idx];
+    if (w > hottest)
+      hottest = w;
+    if (((in_use[idx / 64] >> (idx % 64)) & 1u) && (cold == a->sector_count || w < a->f->wear[cold]))
+      cold = idx;
   }
-  return PC_NO_SPACE;
+  if (cold == a->sector_count || hottest - a->f->wear[cold] <= wear_delta)
+    return PC_ITER_END;
+  *out_index = cold;
+  return PC_OK;
 }
@@ -4,11 +4,99 @@
 
 // Internal limits to keep code tiny & safe
 #define PC_BLOCK_MAX_POINTS 128u // one block per flush (cap)
-#define PC_READBUF_PAGE 256u     // expected program granularity
+
+static bool bit_get(const uint64_t *bits, size_t i) { return (bits[i / 64] >> (i % 64)) & 1u; }
+static void bit_set(uint64_t *bits, size_t i) { bits[i / 64] |= 1ull << (i % 64); }
+static void bit_clear(uint64_t *bits, size_t i) { bits[i / 64] &= ~(1ull << (i % 64)); }
+
+// CRC-check a lazily mounted segment once. A mismatch quarantines it: its cache
+// entries go and it stays out of every later query. I/O errors leave it pending.
+static pc_result_t db_verify_seg(pc_db_t *db, const pc_seg_summary_t *seg)
+{
+  const size_t i = seg->base / pc_flash_sector_bytes(db->flash);
+  pc_segment_hdr_t hdr;
+  pc_result_t st = pc_logseg_verify(db->flash, seg->base, &hdr);
+  if (st == PC_OK && hdr.seqno != seg->seqno)
+    st = PC_CORRUPT;
+  if (st != PC_OK && st != PC_CORRUPT)
+    return st;
+  bit_clear(db->unverified, i);
+  db->unverified_count--;
+  if (st == PC_CORRUPT)
+  {
+    bit_set(db->quarantined, i);
+    db->quarantined_count++;
+    db->quarantine_pending = true;
+    pc_blockcache_invalidate_base(&db->cache, seg->base);
+  }
+  return st;
+}
+
+// pc_scan_t check hook: gate every committed segment the query paths load.
+static pc_result_t db_check_seg(void *ctx, const pc_seg_summary_t *seg)
+{
+  pc_db_t *db = (pc_db_t *)ctx;
+  const size_t i = seg->base / pc_flash_sector_bytes(db->flash);
+  if (bit_get(db->quarantined, i))
+    return PC_CORRUPT;
+  if (!bit_get(db->unverified, i))
+    return PC_OK;
+  return db_verify_seg(db, seg);
+}
+
+// Queries iterate the catalog while the hook runs, so quarantined entries are
+// removed later, from the flusher entry points.
+static void db_purge_quarantine(pc_db_t *db)
+{
+  if (!db->quarantine_pending)
+    return;
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  for (size_t k = db->catalog.count; k-- > 0;)
+  {
+    size_t base = db->catalog.segs[k].base;
+    if (bit_get(db->quarantined, base / seg))
+      (void)pc_catalog_remove_base(&db->catalog, base);
+  }
+  db->quarantine_pending = false;
+}
+
+// Epoch of the current state: catalog + snapshot parts live, allocator head.
+static pc_result_t db_write_epoch(pc_db_t *db)
+{
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  uint8_t *live = (uint8_t *)calloc(pc_epoch_live_bytes(db->flash), 1);
+  if (!live)
+    return PC_NO_SPACE;
+  for (size_t k = 0; k < db->catalog.count; ++k)
+  {
+    size_t i = db->catalog.segs[k].base / seg;
+    live[i / 8] |= (uint8_t)(1u << (i % 8));
+  }
+  for (size_t k = 0; k < db->index.nparts; ++k)
+  {
+    size_t i = db->index.bases[k] / seg;
+    live[i / 8] |= (uint8_t)(1u << (i % 8));
+  }
+  pc_epoch_t ep;
+  memset(&ep, 0, sizeof(ep));
+  const uint32_t seqno = db->next_seq++;
+  ep.next_seq = db->next_seq;
+  ep.alloc_head = (uint32_t)db->alloc.next_index;
+  pc_result_t st = pc_epoch_write(db->flash, &ep, live, seqno);
+  free(live);
+  return st;
+}
 
 pc_result_t pc_db_init(pc_db_t *db, pc_flash_t *flash,
                        uint32_t ring_capacity_elems,
                        uint32_t seq_start)
+{
+  return pc_db_init_ex(db, flash, ring_capacity_elems, seq_start, PC_MOUNT_VERIFY);
+}
+
+// pc_db_init_ex with the mount's thread count (pc_mount_opts_t.threads)
+static pc_result_t db_init(pc_db_t *db, pc_flash_t *flash, uint32_t ring_capacity_elems,
+                           uint32_t seq_start, pc_mount_mode_t mode, unsigned mount_threads)
 {
   if (!db || !flash || ring_capacity_elems == 0)
     return PC_EINVAL;
@@ -29,8 +117,138 @@ pc_result_t pc_db_init(pc_db_t *db, pc_flash_t *flash,
   db->next_seq = seq_start;
   db->app_open = false;
   // init segment allocator
-  if (pc_alloc_init(&db->alloc, flash) != PC_OK)
+  pc_result_t ast = pc_alloc_init(&db->alloc, flash);
+  if (ast != PC_OK)
+  {
+    free(db->ring_storage);
+    db->ring_storage = NULL;
+    return ast;
+  }
+
+  // Mount: catalog from the newest snapshot + newer segments
+  pc_catalog_init(&db->catalog);
+  pc_index_init(&db->index);
+  db->index_interval = PC_DB_INDEX_INTERVAL_DEFAULT;
+  pc_blockcache_init(&db->cache, PC_BLOCKCACHE_BYTES_DEFAULT);
+  const size_t words = (pc_flash_sector_count(flash) + 63) / 64;
+  db->unverified = (uint64_t *)calloc(words ? words : 1, sizeof(uint64_t));
+  db->quarantined = (uint64_t *)calloc(words ? words : 1, sizeof(uint64_t));
+  if (pc_scan_init(&db->scan, flash) != PC_OK ||
+      pc_series_dict_init(&db->series, PC_SERIES_CAPACITY_DEFAULT) != PC_OK ||
+      !db->unverified || !db->quarantined)
+  {
+    pc_db_deinit(db);
     return PC_EINVAL;
+  }
+  db->scan.cache = &db->cache;
+  db->scan.check = db_check_seg;
+  db->scan.check_ctx = db;
+  pc_index_blob_t blob;
+  pc_index_blob_init(&blob);
+  pc_mount_opts_t mo = {0};
+  mo.unverified = mode == PC_MOUNT_LAZY ? db->unverified : NULL;
+  mo.threads = mount_threads;
+  pc_epoch_t ep;
+  uint8_t *live = pc_epoch_fits(flash) ? (uint8_t *)calloc(pc_epoch_live_bytes(flash), 1) : NULL;
+  if (live && pc_epoch_load(flash, &ep, live, pc_epoch_live_bytes(flash)) == PC_OK)
+  {
+    db->epochs = true;
+    db->alloc.first_index = PC_EPOCH_SLOTS;
+    mo.epoch = &ep;
+    mo.epoch_live = live;
+  }
+  mo.states = (uint8_t *)malloc(pc_flash_sector_count(flash) ? pc_flash_sector_count(flash) : 1);
+  pc_result_t st = mo.states ? pc_index_mount_ex(&db->index, flash, &db->catalog, &blob, &db->mount, &mo)
+                             : PC_NO_SPACE;
+  // Free-space map from the same header pass: opening segments reads no flash.
+  // Sectors an epoch mount skipped hold nothing live.
+  if (st == PC_OK)
+    pc_alloc_load_states(&db->alloc, mo.states, db->epochs ? PC_ALLOC_FREE_DIRTY : PC_ALLOC_UNKNOWN);
+  free(mo.states);
+  free(live);
+  db->unverified_count = db->mount.segments_deferred;
+  const uint8_t *body = NULL;
+  size_t bytes = 0;
+  if (st == PC_OK && pc_index_blob_find(&blob, PC_INDEX_SEC_SERIES, &body, &bytes) == PC_OK)
+    st = pc_series_dict_load(&db->series, body, bytes);
+  pc_index_blob_free(&blob);
+  if (st == PC_OK && db->epochs)
+  {
+    // Keep the allocation order the next mount will walk, and seqnos above
+    // everything the epoch knows about.
+    db->alloc.next_index = mo.epoch_end;
+    uint32_t seen = ep.next_seq;
+    if (pc_catalog_max_seq(&db->catalog) + 1u > seen)
+      seen = pc_catalog_max_seq(&db->catalog) + 1u;
+    if (db->index.nparts && db->index.snap_seq + (uint32_t)db->index.nparts > seen)
+      seen = db->index.snap_seq + (uint32_t)db->index.nparts;
+    if (db->next_seq < seen)
+      db->next_seq = seen;
+    // Segments past the old head: restart the chain from here.
+    if (mo.epoch_end != ep.alloc_head)
+      st = db_write_epoch(db);
+  }
+  if (st != PC_OK)
+  {
+    pc_db_deinit(db);
+    return st;
+  }
+  return PC_OK;
+}
+
+pc_result_t pc_db_init_ex(pc_db_t *db, pc_flash_t *flash,
+                          uint32_t ring_capacity_elems,
+                          uint32_t seq_start, pc_mount_mode_t mode)
+{
+  return db_init(db, flash, ring_capacity_elems, seq_start, mode, 1);
+}
+
+void pc_db_config_default(pc_db_config_t *cfg)
+{
+  if (!cfg)
+    return;
+  cfg->ring_capacity = PC_DB_RING_CAPACITY_DEFAULT;
+  cfg->mount = PC_MOUNT_VERIFY;
+  cfg->index_interval = PC_DB_INDEX_INTERVAL_DEFAULT;
+  cfg->sketch_blocks = false;
+  cfg->verify_commits = false;
+  memset(&cfg->retention, 0, sizeof(cfg->retention));
+  cfg->alloc_policy = PC_ALLOC_NEXT;
+  cfg->wear_limit = 0;
+  cfg->wear_delta = 0;
+  cfg->erased_pool = 0;
+  cfg->mount_threads = 1;
+}
+
+pc_result_t pc_db_open(pc_db_t *db, pc_flash_t *flash, const pc_db_config_t *cfg)
+{
+  pc_db_config_t def;
+  if (!cfg)
+  {
+    pc_db_config_default(&def);
+    cfg = &def;
+  }
+  pc_result_t st = db_init(db, flash, cfg->ring_capacity, 1, cfg->mount, cfg->mount_threads);
+  if (st != PC_OK)
+    return st;
+  db->index_interval = cfg->index_interval;
+  db->sketch_blocks = cfg->sketch_blocks;
+  db->verify_commits = cfg->verify_commits;
+  db->retention = cfg->retention;
+  db->wear_delta = cfg->wear_delta;
+  db->alloc.wear_limit = cfg->wear_limit;
+  db->alloc.pool_target = cfg->erased_pool;
+  // The epoch walk follows circular allocation order.
+  db->alloc.policy = db->epochs ? PC_ALLOC_NEXT : cfg->alloc_policy;
+
+  // An epoch mount has already placed the allocator where its walk ended.
+  if (db->mount.max_seqno && db->mount.max_seqno + 1u > db->next_seq)
+    db->next_seq = db->mount.max_seqno + 1u;
+  if (db->mount.max_seqno && !db->epochs)
+  {
+    const size_t next = db->mount.newest_sector + 1;
+    db->alloc.next_index = next < db->alloc.sector_count ? next : db->alloc.first_index;
+  }
   return PC_OK;
 }
 
@@ -43,6 +261,405 @@ void pc_db_deinit(pc_db_t *db)
   free(db->ring_storage);
   db->ring_storage = NULL;
   memset(&db->ring, 0, sizeof(db->ring));
+  pc_catalog_free(&db->catalog);
+  pc_index_free(&db->index);
+  pc_scan_free(&db->scan);
+  pc_blockcache_free(&db->cache);
+  pc_series_dict_free(&db->series);
+  pc_alloc_deinit(&db->alloc);
+  free(db->unverified);
+  free(db->quarantined);
+  db->unverified = NULL;
+  db->quarantined = NULL;
+}
+
+pc_result_t pc_db_verify_step(pc_db_t *db, size_t max_segments, size_t *remaining)
+{
+  if (!db || !db->unverified)
+    return PC_EINVAL;
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  pc_result_t st = PC_OK;
+  for (size_t k = db->catalog.count; k-- > 0 && max_segments && db->unverified_count;)
+  {
+    const pc_seg_summary_t s = db->catalog.segs[k];
+    if (!bit_get(db->unverified, s.base / seg))
+      continue;
+    max_segments--;
+    st = db_verify_seg(db, &s);
+    if (st == PC_CORRUPT)
+      st = PC_OK;
+    if (st != PC_OK)
+      break;
+  }
+  db_purge_quarantine(db);
+  if (remaining)
+    *remaining = db->unverified_count;
+  return st;
+}
+
+pc_result_t pc_db_write_index(pc_db_t *db)
+{
+  if (!db)
+    return PC_EINVAL;
+  if (db->app_open)
+    return PC_BUSY;
+  // A snapshot vouches for every segment it lists: finish a lazy mount first.
+  pc_result_t st = pc_db_verify_step(db, SIZE_MAX, NULL);
+  if (st != PC_OK)
+    return st;
+
+  pc_index_blob_t blob;
+  pc_index_blob_init(&blob);
+  st = pc_index_put_catalog(&blob, &db->catalog);
+  if (st == PC_OK)
+    st = pc_series_dict_save(&db->series, &blob);
+  if (st == PC_OK)
+    st = pc_index_write(&db->index, db->flash, &db->alloc, &blob, db->next_seq - 1u, &db->next_seq);
+  pc_index_blob_free(&blob);
+  if (st == PC_OK)
+  {
+    db->commits_since_index = 0;
+    db->series.dirty = false;
+  }
+  // Even without a new snapshot the epoch must describe the sectors in use.
+  if (db->epochs)
+  {
+    pc_result_t es = db_write_epoch(db);
+    if (st == PC_OK)
+      st = es;
+  }
+  return st;
+}
+
+pc_result_t pc_db_enable_epochs(pc_db_t *db)
+{
+  if (!db)
+    return PC_EINVAL;
+  if (db->epochs)
+    return PC_OK;
+  if (db->app_open)
+    return PC_BUSY;
+  if (!pc_epoch_fits(db->flash))
+    return PC_UNSUPPORTED;
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  for (size_t s = 0; s < PC_EPOCH_SLOTS; ++s)
+    if (pc_flash_is_bad(db->flash, s) || !pc_logseg_header_erased(db->flash, s * seg))
+      return PC_BUSY;
+  db->alloc.first_index = PC_EPOCH_SLOTS;
+  db->alloc.policy = PC_ALLOC_NEXT;
+  if (db->alloc.next_index < PC_EPOCH_SLOTS)
+    db->alloc.next_index = PC_EPOCH_SLOTS;
+  db->epochs = true;
+  return pc_db_write_index(db);
+}
+
+pc_result_t pc_series_resolve(pc_db_t *db, const char *name,
+                              const pc_tag_t *tags, size_t ntags, pc_series_t *out)
+{
+  if (!db)
+    return PC_EINVAL;
+  return pc_series_dict_resolve(&db->series, name, tags, ntags, out);
+}
+
+pc_result_t pc_series_describe(const pc_db_t *db, pc_series_t s, char *buf, size_t cap)
+{
+  if (!db)
+    return PC_EINVAL;
+  return pc_series_dict_describe(&db->series, s, buf, cap);
+}
+
+pc_result_t pc_db_series_capacity(pc_db_t *db, size_t capacity)
+{
+  if (!db)
+    return PC_EINVAL;
+  return pc_series_dict_reserve(&db->series, capacity);
+}
+
+// Commit the open DATA segment, record it in the catalog, and snapshot periodically.
+static pc_result_t db_commit_open(pc_db_t *db)
+{
+  pc_result_t st = pc_appender_commit(&db->app, PC_SEG_DATA);
+  if (st != PC_OK)
+    return st;
+  db->app_open = false;
+  pc_alloc_commit(&db->alloc, db->app.base);
+
+  pc_seg_summary_t s;
+  s.base = db->app.base;
+  s.type = PC_SEG_DATA;
+  s.seqno = db->app.seqno;
+  s.ts_min = db->app.ts_min == 0xFFFFFFFFu ? 0u : db->app.ts_min;
+  s.ts_max = db->app.ts_max;
+  s.record_count = db->app.record_count;
+  st = pc_catalog_add(&db->catalog, &s);
+  if (st != PC_OK)
+    return st;
+
+  // New series ids must be on flash before a remount could hand them out again.
+  const bool periodic = db->index_interval && ++db->commits_since_index >= db->index_interval;
+  if (db->series.dirty)
+    return pc_db_write_index(db);
+  if (periodic)
+  {
+    // A periodic snapshot only speeds up mount; a full device just postpones it.
+    st = pc_db_write_index(db);
+    if (st == PC_NO_SPACE)
+      st = PC_OK;
+  }
+  return st;
+}
+
+size_t pc_db_free_segments(const pc_db_t *db)
+{
+  if (!db)
+    return 0;
+  size_t usable = 0;
+  for (size_t i = db->alloc.first_index; i < db->alloc.sector_count; ++i)
+    usable += !pc_flash_is_bad(db->flash, i);
+  const size_t used = db->catalog.count + db->index.nparts + db->quarantined_count + (db->app_open ? 1u : 0u);
+  return usable > used ? usable - used : 0;
+}
+
+// Erase a segment retention gave up on and forget everything about it.
+static pc_result_t db_reclaim(pc_db_t *db, size_t base)
+{
+  const size_t i = base / pc_flash_sector_bytes(db->flash);
+  pc_result_t st = pc_logseg_erase(db->flash, base);
+  if (st != PC_OK)
+    return st;
+  pc_alloc_release(&db->alloc, base, true);
+  (void)pc_catalog_remove_base(&db->catalog, base);
+  pc_blockcache_invalidate_base(&db->cache, base);
+  if (bit_get(db->unverified, i))
+  {
+    bit_clear(db->unverified, i);
+    db->unverified_count--;
+  }
+  if (bit_get(db->quarantined, i))
+  {
+    bit_clear(db->quarantined, i);
+    db->quarantined_count--;
+  }
+  db->segments_reclaimed++;
+  return PC_OK;
+}
+
+// Does the policy give up the oldest catalogued segment?
+static bool db_retention_due(const pc_db_t *db)
+{
+  const pc_retention_t *r = &db->retention;
+  const pc_catalog_t *c = &db->catalog;
+  if (c->count == 0)
+    return false;
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  if (r->keep_segments && c->count > r->keep_segments)
+    return true;
+  if (r->max_bytes && (uint64_t)c->count * seg > r->max_bytes)
+    return true;
+  if (r->max_age_secs)
+  {
+    const uint32_t newest = pc_catalog_ts_max_upto(c, c->count - 1);
+    if (newest > c->segs[0].ts_max && newest - c->segs[0].ts_max > r->max_age_secs)
+      return true;
+  }
+  return r->min_free_segments && pc_db_free_segments(db) < r->min_free_segments;
+}
+
+pc_result_t pc_db_reclaim_step(pc_db_t *db, size_t max_segments, size_t *reclaimed)
+{
+  if (!db || !db->quarantined)
+    return PC_EINVAL;
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  size_t n = 0;
+  pc_result_t st = PC_OK;
+  db_purge_quarantine(db);
+
+  // Quarantined segments hold nothing readable.
+  for (size_t i = db->alloc.first_index; i < db->alloc.sector_count && n < max_segments && db->quarantined_count; ++i)
+  {
+    if (!bit_get(db->quarantined, i))
+      continue;
+    st = db_reclaim(db, i * seg);
+    if (st != PC_OK)
+      break;
+    n++;
+  }
+
+  while (st == PC_OK && n < max_segments && db_retention_due(db))
+  {
+    st = db_reclaim(db, db->catalog.segs[0].base);
+    n += st == PC_OK;
+  }
+
+  // An erased sector the last epoch did not list would end its walk early.
+  if (n && db->epochs)
+  {
+    pc_result_t es = db_write_epoch(db);
+    if (st == PC_OK)
+      st = es;
+  }
+  if (reclaimed)
+    *reclaimed = n;
+  return st;
+}
+
+// Copy a committed segment to another sector under the same seqno, then erase
+// the original. A crash in between leaves two identical copies; mount keeps one.
+static pc_result_t db_relocate(pc_db_t *db, pc_seg_summary_t s)
+{
+  pc_result_t st = db_check_seg(db, &s);
+  if (st != PC_OK)
+    return st;
+  size_t base = 0;
+  bool erased = false;
+  st = pc_alloc_acquire_ex(&db->alloc, db->epochs ? PC_ALLOC_NEXT : PC_ALLOC_MOST_WORN, &base, &erased);
+  if (st != PC_OK)
+    return st;
+
+  const size_t preH = pc_logseg_preheader_bytes(db->flash);
+  const size_t prog = pc_flash_prog_bytes(db->flash);
+  uint8_t *img = (uint8_t *)malloc(preH);
+  if (!img)
+  {
+    pc_alloc_release(&db->alloc, base, erased);
+    return PC_NO_SPACE;
+  }
+  st = pc_flash_read(db->flash, s.base, img, preH);
+  // Pages past the last programmed one stay erased (the CRC covers them as such).
+  size_t len = preH;
+  while (st == PC_OK && len)
+  {
+    size_t k = 0;
+    while (k < prog && img[len - prog + k] == db->flash->erased_val)
+      k++;
+    if (k < prog)
+      break;
+    len -= prog;
+  }
+
+  pc_appender_t app;
+  if (st == PC_OK)
+    st = erased ? pc_appender_open_erased(&app, db->flash, base, s.seqno)
+                : pc_appender_open(&app, db->flash, base, s.seqno);
+  if (st == PC_OK)
+    st = pc_appender_append_bytes(&app, img, len);
+  free(img);
+  if (st == PC_OK)
+  {
+    app.ts_min = s.ts_min;
+    app.ts_max = s.ts_max;
+    app.record_count = s.record_count;
+    st = pc_appender_commit(&app, PC_SEG_DATA);
+  }
+  if (st != PC_OK)
+  {
+    pc_alloc_release(&db->alloc, base, pc_logseg_erase(db->flash, base) == PC_OK);
+    return st;
+  }
+  pc_alloc_commit(&db->alloc, base);
+
+  (void)pc_catalog_remove_base(&db->catalog, s.base);
+  pc_blockcache_invalidate_base(&db->cache, s.base);
+  const size_t old = s.base;
+  s.base = base;
+  st = pc_catalog_add(&db->catalog, &s);
+  if (st != PC_OK)
+    return st;
+  db->segments_relocated++;
+  st = pc_logseg_erase(db->flash, old);
+  pc_alloc_release(&db->alloc, old, st == PC_OK);
+  return st;
+}
+
+pc_result_t pc_db_erase_step(pc_db_t *db, size_t max_erases, size_t *erased)
+{
+  if (!db || !db->quarantined)
+    return PC_EINVAL;
+  size_t n = 0;
+  pc_result_t st = pc_alloc_refill_step(&db->alloc, max_erases, &n);
+  // An erased sector the last epoch did not list would end its walk early.
+  if (n && db->epochs)
+  {
+    pc_result_t es = db_write_epoch(db);
+    if (st == PC_OK)
+      st = es;
+  }
+  if (erased)
+    *erased = n;
+  return st;
+}
+
+pc_result_t pc_db_wear_level_step(pc_db_t *db, size_t max_moves, size_t *moved)
+{
+  if (!db || !db->quarantined)
+    return PC_EINVAL;
+  const size_t seg = pc_flash_sector_bytes(db->flash);
+  const size_t words = (pc_flash_sector_count(db->flash) + 63) / 64;
+  uint64_t *in_use = (uint64_t *)calloc(words ? words : 1, sizeof(uint64_t));
+  if (!in_use)
+    return PC_NO_SPACE;
+  db_purge_quarantine(db);
+
+  size_t n = 0;
+  pc_result_t st = PC_OK;
+  while (db->wear_delta && n < max_moves)
+  {
+    memset(in_use, 0, words * sizeof(uint64_t));
+    for (size_t k = 0; k < db->catalog.count; ++k)
+      bit_set(in_use, db->catalog.segs[k].base / seg);
+    size_t cold = 0;
+    if (pc_alloc_cold_sector(&db->alloc, in_use, db->wear_delta, &cold) != PC_OK)
+      break;
+    const pc_seg_summary_t *s = pc_catalog_find_base(&db->catalog, cold * seg);
+    st = s ? db_relocate(db, *s) : PC_EINVAL;
+    if (st != PC_OK)
+      break;
+    n++;
+  }
+  free(in_use);
+
+  // The old snapshot (and epoch) still point at the sectors just erased.
+  if (n)
+  {
+    pc_result_t ws = pc_db_write_index(db);
+    if (st == PC_OK && ws != PC_NO_SPACE && ws != PC_BUSY)
+      st = ws;
+  }
+  if (moved)
+    *moved = n;
+  return st;
+}
+
+// Acquire a sector and open the appender on it. A full device configured as a
+// ring log gives up its oldest segment here rather than stopping ingest.
+static pc_result_t db_open_segment(pc_db_t *db)
+{
+  size_t base = 0;
+  bool erased = false;
+  pc_result_t st = pc_alloc_acquire_ex(&db->alloc, db->alloc.policy, &base, &erased);
+  if (st == PC_NO_SPACE && db->retention.min_free_segments && db->catalog.count)
+  {
+    st = db_reclaim(db, db->catalog.segs[0].base);
+    if (st == PC_OK && db->epochs)
+      st = db_write_epoch(db);
+    if (st == PC_OK)
+      st = pc_alloc_acquire_ex(&db->alloc, db->alloc.policy, &base, &erased);
+  }
+  if (st != PC_OK)
+    return st; // PC_NO_SPACE if full
+  pc_blockcache_invalidate_base(&db->cache, base);
+  // A pre-erased sector keeps the erase off the flush path.
+  st = erased ? pc_appender_open_erased(&db->app, db->flash, base, db->next_seq++)
+              : pc_appender_open(&db->app, db->flash, base, db->next_seq++);
+  if (st != PC_OK)
+  {
+    pc_alloc_release(&db->alloc, base, false);
+    return st;
+  }
+  db->app.sketch = db->sketch_blocks;
+  db->app.verify_commit = db->verify_commits;
+  db->app_open = true;
+  return PC_OK;
 }
 
 pc_result_t pc_write(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
@@ -96,6 +713,7 @@ pc_result_t pc_db_flush_once(pc_db_t *db)
 {
   if (!db)
     return PC_EINVAL;
+  db_purge_quarantine(db);
 
   if (pc_ring_is_empty(&db->ring))
   {
@@ -103,18 +721,21 @@ pc_result_t pc_db_flush_once(pc_db_t *db)
     return PC_OK;
   }
 
-  // Open appender lazily
-  if (!db->app_open)
+  // New series ids reach flash before any block that may carry them: the open
+  // segment is committed first (its commit snapshots the dictionary).
+  if (db->series.dirty)
   {
-    size_t base = 0;
-    pc_result_t st = pc_alloc_acquire(&db->alloc, &base);
+    pc_result_t st = db->app_open ? db_commit_open(db) : pc_db_write_index(db);
     if (st != PC_OK)
-      return st; // PC_NO_SPACE if full
-    st = pc_appender_open(&db->app, db->flash, base, db->next_seq++);
+      return st;
+  }
 
+  // Open appender lazily
+  if (!db->app_open)
+  {
+    pc_result_t st = db_open_segment(db);
     if (st != PC_OK)
       return st;
-    db->app_open = true;
   }
 
   // Drain one block worth of same (metric, series)
@@ -141,20 +762,13 @@ pc_result_t pc_db_flush_once(pc_db_t *db)
   if (st == PC_NO_SPACE)
   {
     // Commit current, open new, then append
-    pc_result_t rc = pc_appender_commit(&db->app, PC_SEG_DATA);
+    pc_result_t rc = db_commit_open(db);
     if (rc != PC_OK)
       return rc;
-    db->app_open = false;
 
-    rc = pc_appender_open(&db->app, db->flash, /*base*/ 0 + 0, db->next_seq++);
-    size_t base2 = 0;
-    rc = pc_alloc_acquire(&db->alloc, &base2);
-    if (rc != PC_OK)
-      return rc;
-    rc = pc_appender_open(&db->app, db->flash, base2, db->next_seq++);
+    rc = db_open_segment(db);
     if (rc != PC_OK)
       return rc;
-    db->app_open = true;
 
     st = pc_appender_append_block(&db->app, metric, series, ts, val, n);
   }
@@ -176,115 +790,178 @@ pc_result_t pc_db_flush_until_empty(pc_db_t *db)
   // If an appender is open, commit it to finalize the segment.
   if (db->app_open)
   {
-    st = pc_appender_commit(&db->app, PC_SEG_DATA);
+    st = db_commit_open(db);
     if (st != PC_OK)
       return st;
-    db->app_open = false;
   }
   return PC_OK;
 }
 
-// ---- Reader helpers for query_latest ----
+// ---- Reader helpers (newest-first) ----
+//
+// Sources are visited newest to oldest: ring (PC_READ_YOUR_WRITES only, newest
+// element first), open segment (same), then committed segments from the highest
+// seqno down. Blocks go from the last one written, points from the end of the
+// block. A sink's floor() tells the walker that only points strictly newer than
+// the floor can still matter, which lets it skip or stop on segment ts_max.
 
-// Decode blocks sequentially until we've consumed 'record_count' points.
-static pc_result_t scan_segment_latest(const pc_flash_t *f, size_t base,
-                                       uint32_t record_count, uint16_t metric_id,
-                                       uint32_t *out_ts, float *out_val)
+typedef struct pt_sink pt_sink_t;
+struct pt_sink
 {
-  const size_t prog = pc_flash_prog_bytes(f);
-  const size_t preH = pc_flash_sector_bytes(f) - prog;
-
-  size_t off = 0; // offset into pre-header
-  uint32_t seen = 0;
-  uint32_t best_ts = 0;
-  float best_val = 0.0f;
-
-  uint8_t pg[PC_READBUF_PAGE];
-  if (prog > sizeof(pg))
-    return PC_EINVAL;
+  void (*offer)(pt_sink_t *s, uint32_t ts, float val);
+  bool (*floor)(const pt_sink_t *s, uint32_t *out_ts);
+};
 
-  while (seen < record_count && off < preH)
+static pc_result_t walk_blocks(pc_scan_t *sc, uint16_t metric_id, pt_sink_t *sink)
+{
+  uint32_t floor_ts = 0;
+  for (size_t b = sc->nblocks; b-- > 0;)
   {
-    // Read block header
-    pc_block_hdr_t bh;
-    if (off + sizeof(bh) > preH)
-      break;
-    // We can read header even if it crosses page boundary by assembling bytes.
-    // For simplicity, read header in one go (flash_read handles splitting across sectors/pages).
-    pc_result_t st = pc_flash_read(f, base + off, &bh, sizeof(bh));
+    if (sc->dir[b].hdr.metric_id != metric_id)
+      continue;
+    if ((sc->dir[b].flags & PC_BLOCK_F_SUMMARY) && sink->floor(sink, &floor_ts) &&
+        sc->dir[b].sum.ts_max <= floor_ts)
+      continue; // summary says nothing in here can win
+    const pc_point_disk_t *pts = NULL;
+    pc_result_t st = pc_scan_block_points(sc, b, &pts);
     if (st != PC_OK)
       return st;
-    off += sizeof(bh);
+    for (uint32_t i = sc->dir[b].hdr.point_count; i-- > 0;)
+      sink->offer(sink, pts[i].ts, pts[i].value);
+  }
+  return PC_OK;
+}
 
-    // Read points for this block
-    for (uint32_t i = 0; i < bh.point_count; ++i)
-    {
-      pc_point_disk_t pt;
-      if (off + sizeof(pt) > preH)
-        return PC_CORRUPT;
-      st = pc_flash_read(f, base + off, &pt, sizeof(pt));
-      if (st != PC_OK)
-        return st;
-      off += sizeof(pt);
+static void walk_newest_first(pc_db_t *db, uint16_t metric_id, pc_read_mode_t mode, pt_sink_t *sink)
+{
+  uint32_t floor_ts = 0;
 
-      if (bh.metric_id == metric_id)
-      {
-        if (pt.ts >= best_ts)
-        {
-          best_ts = pt.ts;
-          best_val = pt.value;
-        }
-      }
-      seen++;
-      if (seen >= record_count)
-        break;
+  if (mode == PC_READ_YOUR_WRITES)
+  {
+    // Points the producer has published so far; later pushes are not seen.
+    for (uint32_t i = pc_ring_size(&db->ring); i-- > 0;)
+    {
+      const pc_point_ram_t *p = (const pc_point_ram_t *)pc_ring_peek_at(&db->ring, i);
+      if (p && p->metric_id == metric_id)
+        sink->offer(sink, p->ts, p->value);
     }
+    if (db->app_open && db->app.record_count &&
+        !(sink->floor(sink, &floor_ts) && db->app.ts_max <= floor_ts) &&
+        pc_scan_load_open(&db->scan, &db->app) == PC_OK)
+      (void)walk_blocks(&db->scan, metric_id, sink);
   }
 
-  if (best_ts == 0 && record_count > 0)
+  // Catalog entries were verified at mount or written by us.
+  for (size_t i = db->catalog.count; i-- > 0;)
   {
-    return PC_METRIC_UNKNOWN; // metric not found in this segment
+    bool have_floor = sink->floor(sink, &floor_ts);
+    if (have_floor && pc_catalog_ts_max_upto(&db->catalog, i) <= floor_ts)
+      break; // nothing older can be newer
+    const pc_seg_summary_t *seg = &db->catalog.segs[i];
+    if (have_floor && seg->ts_max <= floor_ts)
+      continue;
+    // A segment that fails to decode is skipped, like a corrupt one at mount.
+    if (pc_scan_load_seg(&db->scan, seg) == PC_OK)
+      (void)walk_blocks(&db->scan, metric_id, sink);
   }
-  *out_ts = best_ts;
-  *out_val = best_val;
+}
+
+// ---- Latest: keep the strictly newest point ----
+
+typedef struct
+{
+  pt_sink_t base;
+  bool found;
+  uint32_t ts;
+  float val;
+} latest_sink_t;
+
+static void latest_offer(pt_sink_t *s, uint32_t ts, float val)
+{
+  latest_sink_t *l = (latest_sink_t *)s;
+  if (!l->found || ts > l->ts)
+  {
+    l->ts = ts;
+    l->val = val;
+    l->found = true;
+  }
+}
+
+static bool latest_floor(const pt_sink_t *s, uint32_t *out_ts)
+{
+  const latest_sink_t *l = (const latest_sink_t *)s;
+  *out_ts = l->ts;
+  return l->found;
+}
+
+pc_result_t pc_query_latest_ex(pc_db_t *db, uint16_t metric_id, pc_read_mode_t mode,
+                               float *out_value, uint32_t *out_ts)
+{
+  if (!db || !out_value || !out_ts)
+    return PC_EINVAL;
+
+  latest_sink_t l = {{latest_offer, latest_floor}, false, 0u, 0.0f};
+  walk_newest_first(db, metric_id, mode, &l.base);
+
+  if (!l.found)
+    return PC_METRIC_UNKNOWN;
+  *out_ts = l.ts;
+  *out_value = l.val;
   return PC_OK;
 }
 
 pc_result_t pc_query_latest(pc_db_t *db, uint16_t metric_id,
                             float *out_value, uint32_t *out_ts)
+{
+  return pc_query_latest_ex(db, metric_id, PC_READ_COMMITTED, out_value, out_ts);
+}
+
+// Series filter shared by the single-series and tag-selector queries.
+static bool series_ok(uint16_t want, const pc_series_set_t *set, uint16_t id)
+{
+  if (set)
+    return pc_series_set_has(set, id);
+  return want == PC_SERIES_ANY || want == id;
+}
+
+// ---- As-of: newest point at or before t ----
+
+pc_result_t pc_query_asof(pc_db_t *db, uint16_t metric_id, uint16_t series_id, uint32_t t,
+                          float *out_value, uint32_t *out_ts)
 {
   if (!db || !out_value || !out_ts)
     return PC_EINVAL;
 
-  // Scan all committed segments via recovery
-  pc_seg_summary_t segs[16];
-  size_t n = 0;
-  pc_result_t st = pc_recover_scan_all(db->flash, segs, 16, &n);
-  if (st != PC_OK)
-    return st;
-
+  bool found = false;
   uint32_t best_ts = 0;
   float best_val = 0.0f;
-  bool found = false;
-
-  for (size_t i = 0; i < n; ++i)
+  for (size_t i = db->catalog.count; i-- > 0;)
   {
-    // Verify header to get record_count (already in summary) and sanity
-    pc_segment_hdr_t hdr;
-    st = pc_logseg_verify(db->flash, segs[i].base, &hdr);
-    if (st != PC_OK)
+    if (found && pc_catalog_ts_max_upto(&db->catalog, i) <= best_ts)
+      break; // nothing older can be newer
+    const pc_seg_summary_t *seg = &db->catalog.segs[i];
+    if (seg->ts_min > t || (found && seg->ts_max <= best_ts))
+      continue;
+    if (pc_scan_load_seg(&db->scan, seg) != PC_OK)
       continue;
 
-    uint32_t ts;
-    float val;
-    st = scan_segment_latest(db->flash, segs[i].base, hdr.record_count, metric_id, &ts, &val);
-    if (st == PC_OK)
+    // Newest block first; within a block, binary search when it is sorted.
+    for (size_t b = db->scan.nblocks; b-- > 0;)
     {
-      if (!found || ts >= best_ts)
+      const pc_blockdir_ent_t *e = &db->scan.dir[b];
+      if (e->hdr.metric_id != metric_id || !series_ok(series_id, NULL, e->hdr.series_id))
+        continue;
+      if ((e->flags & PC_BLOCK_F_SUMMARY) && (e->sum.ts_min > t || (found && e->sum.ts_max <= best_ts)))
+        continue;
+      const pc_point_disk_t *pts = NULL;
+      if (pc_scan_block_points(&db->scan, b, &pts) != PC_OK)
+        break;
+      uint32_t k = pc_block_find_asof(pts, e->hdr.point_count, (e->flags & PC_BLOCK_F_SORTED) != 0, t);
+      if (k < e->hdr.point_count && (!found || pts[k].ts > best_ts))
       {
-        best_ts = ts;
-        best_val = val;
         found = true;
+        best_ts = pts[k].ts;
+        best_val = pts[k].value;
       }
     }
   }
@@ -295,3 +972,636 @@ pc_result_t pc_query_latest(pc_db_t *db, uint16_t metric_id,
   *out_value = best_val;
   return PC_OK;
 }
+
+// ---- Tail: bounded min-heap on ts over the caller's arrays ----
+
+typedef struct
+{
+  pt_sink_t base;
+  uint32_t *ts;
+  float *val;
+  uint32_t cap;
+  uint32_t n;
+} tail_sink_t;
+
+static void heap_swap(uint32_t *ts, float *val, uint32_t a, uint32_t b)
+{
+  uint32_t t = ts[a];
+  ts[a] = ts[b];
+  ts[b] = t;
+  float v = val[a];
+  val[a] = val[b];
+  val[b] = v;
+}
+
+static void heap_sift_down(uint32_t *ts, float *val, uint32_t n, uint32_t i)
+{
+  for (;;)
+  {
+    uint32_t l = 2 * i + 1, r = l + 1, m = i;
+    if (l < n && ts[l] < ts[m])
+      m = l;
+    if (r < n && ts[r] < ts[m])
+      m = r;
+    if (m == i)
+      return;
+    heap_swap(ts, val, i, m);
+    i = m;
+  }
+}
+
+static void tail_offer(pt_sink_t *s, uint32_t ts, float val)
+{
+  tail_sink_t *t = (tail_sink_t *)s;
+  if (t->n < t->cap)
+  {
+    uint32_t i = t->n++;
+    t->ts[i] = ts;
+    t->val[i] = val;
+    while (i > 0 && t->ts[(i - 1) / 2] > t->ts[i])
+    {
+      heap_swap(t->ts, t->val, i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+  else if (ts > t->ts[0])
+  {
+    t->ts[0] = ts;
+    t->val[0] = val;
+    heap_sift_down(t->ts, t->val, t->n, 0);
+  }
+}
+
+static bool tail_floor(const pt_sink_t *s, uint32_t *out_ts)
+{
+  const tail_sink_t *t = (const tail_sink_t *)s;
+  if (t->n < t->cap)
+    return false;
+  *out_ts = t->ts[0]; // every older point loses to the current oldest kept
+  return true;
+}
+
+pc_result_t pc_query_tail_ex(pc_db_t *db, uint16_t metric_id, pc_read_mode_t mode, uint32_t n,
+                             uint32_t *out_ts, float *out_val, uint32_t *out_n)
+{
+  if (!db || !out_ts || !out_val || !out_n || n == 0)
+    return PC_EINVAL;
+
+  tail_sink_t t = {{tail_offer, tail_floor}, out_ts, out_val, n, 0u};
+  walk_newest_first(db, metric_id, mode, &t.base);
+
+  // Heap-sort (min-heap → descending), then reverse to ascending.
+  for (uint32_t end = t.n; end > 1; --end)
+  {
+    heap_swap(out_ts, out_val, 0, end - 1);
+    heap_sift_down(out_ts, out_val, end - 1, 0);
+  }
+  for (uint32_t a = 0, z = t.n ? t.n - 1 : 0; a < z; ++a, --z)
+    heap_swap(out_ts, out_val, a, z);
+
+  *out_n = t.n;
+  return t.n ? PC_OK : PC_METRIC_UNKNOWN;
+}
+
+pc_result_t pc_query_tail(pc_db_t *db, uint16_t metric_id, uint32_t n,
+                          uint32_t *out_ts, float *out_val, uint32_t *out_n)
+{
+  return pc_query_tail_ex(db, metric_id, PC_READ_COMMITTED, n, out_ts, out_val, out_n);
+}
+
+// ---- Batch queries: one pass, blocks scattered through a metric -> slot map ----
+
+typedef struct
+{
+  uint16_t *keys;
+  int32_t *slot; // -1 = empty
+  uint32_t mask;
+} metric_map_t;
+
+static uint32_t metric_hash(uint16_t m) { return (uint32_t)m * 0x9E3779B1u; }
+
+// Map each distinct metric to the first request slot that asked for it.
+// Slots are int32_t, so n is capped; the table is sized for the distinct keys
+// (at most 65536), not for n.
+static pc_result_t metric_map_build(metric_map_t *mm, const uint16_t *metrics, size_t n)
+{
+  if (n > (size_t)INT32_MAX)
+    return PC_EINVAL;
+  const size_t keys = n < 65536u ? n : 65536u;
+  uint32_t cap = 8;
+  while (cap < 2 * keys)
+    cap <<= 1;
+  mm->keys = (uint16_t *)malloc(cap * sizeof(uint16_t));
+  mm->slot = (int32_t *)malloc(cap * sizeof(int32_t));
+  mm->mask = cap - 1;
+  if (!mm->keys || !mm->slot)
+  {
+    free(mm->keys);
+    free(mm->slot);
+    return PC_NO_SPACE;
+  }
+  for (uint32_t i = 0; i < cap; ++i)
+    mm->slot[i] = -1;
+  for (size_t i = 0; i < n; ++i)
+  {
+    uint32_t h = (metric_hash(metrics[i]) >> 16) & mm->mask;
+    while (mm->slot[h] >= 0 && mm->keys[h] != metrics[i])
+      h = (h + 1) & mm->mask;
+    if (mm->slot[h] < 0)
+    {
+      mm->keys[h] = metrics[i];
+      mm->slot[h] = (int32_t)i;
+    }
+  }
+  return PC_OK;
+}
+
+static int32_t metric_map_get(const metric_map_t *mm, uint16_t m)
+{
+  uint32_t h = (metric_hash(m) >> 16) & mm->mask;
+  while (mm->slot[h] >= 0)
+  {
+    if (mm->keys[h] == m)
+      return mm->slot[h];
+    h = (h + 1) & mm->mask;
+  }
+  return -1;
+}
+
+static void metric_map_free(metric_map_t *mm)
+{
+  free(mm->keys);
+  free(mm->slot);
+}
+
+pc_result_t pc_query_latest_many(pc_db_t *db, const uint16_t *metrics, size_t n, pc_latest_t *out)
+{
+  if (!db || (!metrics && n) || (!out && n))
+    return PC_EINVAL;
+  if (n == 0)
+    return PC_OK;
+
+  metric_map_t mm;
+  pc_result_t st = metric_map_build(&mm, metrics, n);
+  if (st != PC_OK)
+    return st;
+  for (size_t i = 0; i < n; ++i)
+    out[i].found = false;
+
+  size_t distinct = 0;
+  for (size_t i = 0; i < n; ++i)
+    distinct += metric_map_get(&mm, metrics[i]) == (int32_t)i;
+
+  size_t found = 0;
+  uint32_t floor_ts = 0; // min best ts over slots, valid once all are found
+  pc_result_t load_st = PC_OK; // first segment / block that could not be read
+  for (size_t i = db->catalog.count; i-- > 0;)
+  {
+    if (found == distinct && pc_catalog_ts_max_upto(&db->catalog, i) <= floor_ts)
+      break;
+    const pc_seg_summary_t *seg = &db->catalog.segs[i];
+    if (found == distinct && seg->ts_max <= floor_ts)
+      continue;
+    pc_result_t lst = pc_scan_load_seg(&db->scan, seg);
+    if (lst != PC_OK)
+    {
+      if (load_st == PC_OK)
+        load_st = lst;
+      continue;
+    }
+
+    for (size_t b = db->scan.nblocks; b-- > 0;)
+    {
+      int32_t k = metric_map_get(&mm, db->scan.dir[b].hdr.metric_id);
+      if (k < 0)
+        continue;
+      const pc_point_disk_t *pts = NULL;
+      lst = pc_scan_block_points(&db->scan, b, &pts);
+      if (lst != PC_OK)
+      {
+        if (load_st == PC_OK)
+          load_st = lst;
+        break;
+      }
+      pc_latest_t *o = &out[k];
+      for (uint32_t p = db->scan.dir[b].hdr.point_count; p-- > 0;)
+      {
+        if (!o->found || pts[p].ts > o->ts)
+        {
+          found += !o->found;
+          o->found = true;
+          o->ts = pts[p].ts;
+          o->value = pts[p].value;
+        }
+      }
+    }
+
+    if (found == distinct)
+    {
+      floor_ts = UINT32_MAX;
+      for (size_t k = 0; k < n; ++k)
+        if (out[k].found && out[k].ts < floor_ts)
+          floor_ts = out[k].ts;
+    }
+  }
+
+  // Duplicated metrics share the first slot's answer.
+  for (size_t i = 0; i < n; ++i)
+  {
+    int32_t k = metric_map_get(&mm, metrics[i]);
+    if (k != (int32_t)i)
+      out[i] = out[k];
+  }
+  metric_map_free(&mm);
+  return load_st;
+}
+
+typedef struct
+{
+  uint32_t ts;
+  uint32_t pos; // write order: ties keep it (stable sort)
+  float val;
+} ts_point_t;
+
+static int cmp_ts_point(const void *a, const void *b)
+{
+  const ts_point_t *x = (const ts_point_t *)a;
+  const ts_point_t *y = (const ts_point_t *)b;
+  if (x->ts != y->ts)
+    return x->ts < y->ts ? -1 : 1;
+  return (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+// Stable sort by ts. Results usually arrive sorted already (one segment after
+// another); otherwise qsort on (ts, write position). PC_OK or PC_NO_SPACE.
+static pc_result_t sort_by_ts(uint32_t *ts, float *val, uint32_t n)
+{
+  uint32_t i = 1;
+  while (i < n && ts[i - 1] <= ts[i])
+    i++;
+  if (i >= n)
+    return PC_OK;
+  ts_point_t *tmp = (ts_point_t *)malloc(n * sizeof(*tmp));
+  if (!tmp)
+    return PC_NO_SPACE;
+  for (i = 0; i < n; ++i)
+    tmp[i] = (ts_point_t){ts[i], i, val[i]};
+  qsort(tmp, n, sizeof(*tmp), cmp_ts_point);
+  for (i = 0; i < n; ++i)
+  {
+    ts[i] = tmp[i].ts;
+    val[i] = tmp[i].val;
+  }
+  free(tmp);
+  return PC_OK;
+}
+
+pc_result_t pc_query_range_many(pc_db_t *db, const uint16_t *metrics, size_t n,
+                                uint32_t t0, uint32_t t1, pc_range_buf_t *out)
+{
+  if (!db || (!metrics && n) || (!out && n))
+    return PC_EINVAL;
+  if (t0 > t1)
+    return PC_INVALID_RANGE;
+  if (n == 0)
+    return PC_OK;
+
+  metric_map_t mm;
+  pc_result_t st = metric_map_build(&mm, metrics, n);
+  if (st != PC_OK)
+    return st;
+  for (size_t i = 0; i < n; ++i)
+    out[i].count = out[i].total = 0;
+
+  // Oldest first, so truncated results keep the earliest writes.
+  pc_result_t load_st = PC_OK; // first segment / block that could not be read
+  for (size_t i = 0; i < db->catalog.count; ++i)
+  {
+    const pc_seg_summary_t *seg = &db->catalog.segs[i];
+    if (seg->ts_max < t0 || seg->ts_min > t1)
+      continue;
+    pc_result_t lst = pc_scan_load_seg(&db->scan, seg);
+    if (lst != PC_OK)
+    {
+      if (load_st == PC_OK)
+        load_st = lst;
+      continue;
+    }
+
+    for (size_t b = 0; b < db->scan.nblocks; ++b)
+    {
+      const pc_blockdir_ent_t *e = &db->scan.dir[b];
+      int32_t k = metric_map_get(&mm, e->hdr.metric_id);
+      if (k < 0)
+        continue;
+      if ((e->flags & PC_BLOCK_F_SUMMARY) && (e->sum.ts_max < t0 || e->sum.ts_min > t1))
+        continue;
+      const pc_point_disk_t *pts = NULL;
+      lst = pc_scan_block_points(&db->scan, b, &pts);
+      if (lst != PC_OK)
+      {
+        if (load_st == PC_OK)
+          load_st = lst;
+        break;
+      }
+      pc_range_buf_t *o = &out[k];
+      for (uint32_t p = 0; p < db->scan.dir[b].hdr.point_count; ++p)
+      {
+        if (pts[p].ts < t0 || pts[p].ts > t1)
+          continue;
+        if (o->count < o->cap)
+        {
+          o->ts[o->count] = pts[p].ts;
+          o->val[o->count] = pts[p].value;
+          o->count++;
+        }
+        o->total++;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    int32_t k = metric_map_get(&mm, metrics[i]);
+    if (k == (int32_t)i)
+    {
+      st = sort_by_ts(out[i].ts, out[i].val, out[i].count);
+      if (st != PC_OK)
+        break;
+      continue;
+    }
+    uint32_t c = out[k].count < out[i].cap ? out[k].count : out[i].cap;
+    memcpy(out[i].ts, out[k].ts, c * sizeof(uint32_t));
+    memcpy(out[i].val, out[k].val, c * sizeof(float));
+    out[i].count = c;
+    out[i].total = out[k].total;
+  }
+  metric_map_free(&mm);
+  return st != PC_OK ? st : load_st;
+}
+
+pc_result_t pc_query_range(pc_db_t *db, uint16_t metric_id, uint32_t t0, uint32_t t1,
+                           uint32_t *out_ts, float *out_val, uint32_t cap, uint32_t *out_n)
+{
+  if (!out_n)
+    return PC_EINVAL;
+  pc_range_buf_t b = {out_ts, out_val, cap, 0u, 0u};
+  pc_result_t st = pc_query_range_many(db, &metric_id, 1, t0, t1, &b);
+  *out_n = b.count;
+  if (st != PC_OK)
+    return st;
+  return b.total ? PC_OK : PC_METRIC_UNKNOWN;
+}
+
+// ---- Time-bucketed aggregation ----
+
+static pc_result_t aggregate(pc_db_t *db, uint16_t metric_id, uint16_t series_id, const pc_series_set_t *set,
+                             uint32_t t0, uint32_t t1, uint32_t bucket_secs,
+                             uint32_t agg_mask, pc_bucket_t *out, uint32_t nbuckets)
+{
+  if (!db || !out || bucket_secs == 0 || agg_mask == 0)
+    return PC_EINVAL;
+  if (t0 > t1)
+    return PC_INVALID_RANGE;
+  // 64-bit: the full uint32 range with 1s buckets needs 2^32 of them.
+  const uint64_t need64 = (uint64_t)(t1 - t0) / bucket_secs + 1u;
+  if (need64 > nbuckets)
+    return PC_EINVAL;
+  const uint32_t need = (uint32_t)need64;
+
+  // source → time filter → buckets; summarized blocks inside one bucket are
+  // folded by the aggregate without being decoded.
+  pc_exec_agg_t agg;
+  pc_exec_agg_init(&agg, t0, bucket_secs, out, need);
+  pc_exec_range_t tf;
+  pc_exec_range_init(&tf, t0, t1, &agg.op);
+  pc_exec_spec_t spec = {metric_id, series_id, set, t0, t1, NULL, 0};
+  pc_exec_src_t src;
+  pc_exec_src_init(&src, &spec, &tf.op);
+  pc_exec_run_catalog(&src, &db->scan, &db->catalog);
+  pc_exec_src_finish(&src);
+  pc_exec_agg_finish(&agg, agg_mask);
+  return src.status; // buckets still hold everything readable
+}
+
+pc_result_t pc_query_aggregate(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                               uint32_t t0, uint32_t t1, uint32_t bucket_secs,
+                               uint32_t agg_mask, pc_bucket_t *out, uint32_t nbuckets)
+{
+  return aggregate(db, metric_id, series_id, NULL, t0, t1, bucket_secs, agg_mask, out, nbuckets);
+}
+
+pc_result_t pc_query_aggregate_set(pc_db_t *db, uint16_t metric_id, const pc_series_set_t *set,
+                                   uint32_t t0, uint32_t t1, uint32_t bucket_secs,
+                                   uint32_t agg_mask, pc_bucket_t *out, uint32_t nbuckets)
+{
+  if (!set)
+    return PC_EINVAL;
+  return aggregate(db, metric_id, PC_SERIES_ANY, set, t0, t1, bucket_secs, agg_mask, out, nbuckets);
+}
+
+pc_result_t pc_series_select(const pc_db_t *db, const pc_tag_t *tags, size_t ntags, pc_series_set_t *out)
+{
+  if (!db)
+    return PC_EINVAL;
+  return pc_series_dict_select(&db->series, tags, ntags, out);
+}
+
+// ---- Derived series ----
+
+pc_result_t pc_query_derive(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                            uint32_t t0, uint32_t t1, uint32_t flags,
+                            uint32_t *out_ts, float *out_val, uint32_t cap, uint32_t *out_n)
+{
+  if (!db || !out_n || (cap && (!out_ts || !out_val)))
+    return PC_EINVAL;
+  if (metric_id == PC_METRIC_ANY || series_id == PC_SERIES_ANY)
+    return PC_EINVAL; // a derivative is only meaningful within one series
+  if (t0 > t1)
+    return PC_INVALID_RANGE;
+
+  // source → time filter → derivative → caller arrays. The derivative keeps the
+  // previous point across batches, hence across blocks and segments.
+  pc_exec_buf_t buf;
+  pc_exec_buf_init(&buf, out_ts, out_val, cap);
+  pc_exec_deriv_t d;
+  pc_exec_deriv_init(&d, flags, &buf.op);
+  pc_exec_range_t tf;
+  pc_exec_range_init(&tf, t0, t1, &d.op);
+  pc_exec_spec_t spec = {metric_id, series_id, NULL, t0, t1, NULL, 0};
+  pc_exec_src_t src;
+  pc_exec_src_init(&src, &spec, &tf.op);
+  pc_exec_run_catalog(&src, &db->scan, &db->catalog);
+  pc_exec_src_finish(&src);
+
+  *out_n = buf.count;
+  // A skipped segment leaves a gap the derivative steps over: say so.
+  if (src.status != PC_OK)
+    return src.status;
+  return buf.total ? PC_OK : PC_METRIC_UNKNOWN;
+}
+
+pc_result_t pc_query_rate(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                          uint32_t t0, uint32_t t1,
+                          uint32_t *out_ts, float *out_val, uint32_t cap, uint32_t *out_n)
+{
+  return pc_query_derive(db, metric_id, series_id, t0, t1, PC_DERIVE_RATE | PC_DERIVE_COUNTER,
+                         out_ts, out_val, cap, out_n);
+}
+
+// ---- Grid alignment ----
+
+pc_result_t pc_query_align(pc_db_t *db, const pc_series_t *series, size_t n,
+                           uint32_t t0, uint32_t t1, uint32_t step, pc_fill_t fill,
+                           float *out_matrix, uint32_t nrows)
+{
+  if (!db || !series || n == 0 || !out_matrix || step == 0)
+    return PC_EINVAL;
+  if (fill != PC_FILL_LOCF && fill != PC_FILL_LINEAR)
+    return PC_EINVAL;
+  if (t0 > t1)
+    return PC_INVALID_RANGE;
+  const uint64_t need64 = (uint64_t)(t1 - t0) / step + 1u;
+  if (need64 > nrows)
+    return PC_EINVAL;
+  const uint32_t need = (uint32_t)need64;
+
+  // One pass: every selected block is decoded once and its points scattered
+  // into their series' grid slots, whatever order the series are stored in.
+  pc_exec_align_t al;
+  pc_result_t st = pc_exec_align_init(&al, series, n, t0, step, need);
+  if (st != PC_OK)
+    return st;
+  pc_exec_range_t tf;
+  pc_exec_range_init(&tf, t0, t1, &al.op);
+  pc_exec_spec_t spec = {PC_METRIC_ANY, PC_SERIES_ANY, NULL, t0, t1, series, n};
+  pc_exec_src_t src;
+  pc_exec_src_init(&src, &spec, &tf.op);
+  pc_exec_run_catalog(&src, &db->scan, &db->catalog);
+  pc_exec_src_finish(&src);
+  pc_exec_align_finish(&al, fill, out_matrix);
+  pc_exec_align_free(&al);
+  // Fill would otherwise paper over a segment that could not be read.
+  return src.status;
+}
+
+// ---- Quantiles ----
+
+pc_result_t pc_query_quantile(pc_db_t *db, uint16_t metric_id, uint16_t series_id,
+                              uint32_t t0, uint32_t t1, const float *qs, size_t nq,
+                              float *out, uint64_t *out_count)
+{
+  if (!db || (!qs && nq) || (!out && nq))
+    return PC_EINVAL;
+  if (t0 > t1)
+    return PC_INVALID_RANGE;
+  for (size_t k = 0; k < nq; ++k)
+    if (!(qs[k] >= 0.0f && qs[k] <= 1.0f))
+      return PC_EINVAL;
+
+  pc_sketch_acc_t acc;
+  pc_sketch_acc_init(&acc);
+  pc_result_t st = PC_OK;
+  pc_result_t load_st = PC_OK; // first segment / block that could not be read
+  for (size_t i = 0; i < db->catalog.count && st == PC_OK; ++i)
+  {
+    const pc_seg_summary_t *seg = &db->catalog.segs[i];
+    if (seg->ts_max < t0 || seg->ts_min > t1)
+      continue;
+    pc_result_t lst = pc_scan_load_seg(&db->scan, seg);
+    if (lst != PC_OK)
+    {
+      if (load_st == PC_OK)
+        load_st = lst;
+      continue;
+    }
+
+    for (size_t b = 0; b < db->scan.nblocks && st == PC_OK; ++b)
+    {
+      const pc_blockdir_ent_t *e = &db->scan.dir[b];
+      if (e->hdr.metric_id != metric_id)
+        continue;
+      if (!series_ok(series_id, NULL, e->hdr.series_id))
+        continue;
+      if (e->flags & PC_BLOCK_F_SUMMARY)
+      {
+        if (e->sum.ts_max < t0 || e->sum.ts_min > t1)
+          continue;
+        const uint8_t *sk = NULL;
+        size_t sk_len = 0;
+        if (e->sum.ts_min >= t0 && e->sum.ts_max <= t1 &&
+            pc_scan_block_sketch(&db->scan, b, &sk, &sk_len) == PC_OK)
+        {
+          st = pc_sketch_acc_merge(&acc, sk, sk_len);
+          if (st != PC_UNSUPPORTED)
+            continue;
+          st = PC_OK; // other bucket layout: use the raw points
+        }
+      }
+      const pc_point_disk_t *pts = NULL;
+      lst = pc_scan_block_points(&db->scan, b, &pts);
+      if (lst != PC_OK)
+      {
+        if (load_st == PC_OK)
+          load_st = lst;
+        break;
+      }
+      for (uint32_t p = 0; p < e->hdr.point_count && st == PC_OK; ++p)
+        if (pts[p].ts >= t0 && pts[p].ts <= t1)
+          st = pc_sketch_acc_add(&acc, pts[p].value);
+    }
+  }
+
+  if (out_count)
+    *out_count = acc.total;
+  if (st == PC_OK && acc.total == 0)
+    st = PC_METRIC_UNKNOWN;
+  for (size_t k = 0; k < nq && st == PC_OK; ++k)
+    st = pc_sketch_acc_quantile(&acc, qs[k], &out[k]);
+  pc_sketch_acc_free(&acc);
+  // Answers from the readable data stand, but not as the whole window.
+  if (load_st != PC_OK && (st == PC_OK || st == PC_METRIC_UNKNOWN))
+    return load_st;
+  return st;
+}
+
+// ---- Streaming scan ----
+
+pc_result_t pc_query_scan(pc_db_t *db, const pc_query_filter_t *flt, pc_query_cb_t cb, void *ctx)
+{
+  if (!db || !flt || !cb)
+    return PC_EINVAL;
+  if (flt->t0 > flt->t1)
+    return PC_INVALID_RANGE;
+
+  pc_exec_project_t proj;
+  pc_exec_project_init(&proj, cb, ctx, flt->offset, flt->limit);
+  pc_exec_range_t tf;
+  pc_exec_range_init(&tf, flt->t0, flt->t1, &proj.op);
+  pc_exec_spec_t spec = {flt->metric_id, flt->series_id, flt->series_set, flt->t0, flt->t1, NULL, 0};
+  pc_exec_src_t src;
+  pc_exec_src_init(&src, &spec, &tf.op);
+  pc_exec_run_catalog(&src, &db->scan, &db->catalog);
+
+  if (flt->mode == PC_READ_YOUR_WRITES && !src.stopped)
+  {
+    if (db->app_open && db->app.record_count)
+    {
+      pc_result_t st = pc_scan_load_open(&db->scan, &db->app);
+      if (st == PC_OK)
+        pc_exec_run_blocks(&src, &db->scan);
+      else if (src.status == PC_OK)
+        src.status = st;
+    }
+    // Oldest published point first.
+    uint32_t n = pc_ring_size(&db->ring);
+    for (uint32_t i = 0; i < n && !src.stopped; ++i)
+    {
+      const pc_point_ram_t *p = (const pc_point_ram_t *)pc_ring_peek_at(&db->ring, i);
+      if (p && pc_exec_src_match(&src, p->metric_id, p->series_id))
+        pc_exec_src_point(&src, p->metric_id, p->series_id, p->ts, p->value);
+    }
+  }
+  pc_exec_src_finish(&src);
+  return src.status;
+}
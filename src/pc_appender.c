@@ -1,4 +1,5 @@
 #include "pc_appender.h"
+#include "pc_crc32c.h"
 #include <string.h>
 
 static int is_pow2(size_t x) { return x && ((x & (x - 1)) == 0); }
@@ -11,6 +12,8 @@ static pc_result_t flush_page(pc_appender_t *a)
   if ((addr % a->prog) != 0)
     return PC_EINVAL;
   pc_result_t rc = pc_flash_program(a->f, addr, a->page, a->prog);
+  // The whole page goes to flash, 0xFF tail included: the CRC covers it as is.
+  a->crc = pc_crc32c_update(a->crc, a->page, a->prog);
   memset(a->page, 0xFF, a->prog);
   a->page_off = 0;
   return rc;
@@ -44,7 +47,7 @@ static pc_result_t emit_bytes(pc_appender_t *a, const void *src, size_t len)
   return PC_OK;
 }
 
-pc_result_t pc_appender_open(pc_appender_t *a, pc_flash_t *f, size_t base, uint32_t seqno)
+static pc_result_t open_seg(pc_appender_t *a, pc_flash_t *f, size_t base, uint32_t seqno, bool erase)
 {
   if (!a || !f)
     return PC_EINVAL;
@@ -65,10 +68,13 @@ pc_result_t pc_appender_open(pc_appender_t *a, pc_flash_t *f, size_t base, uint3
 
   a->preH = a->seg - a->prog;
 
-  // erase segment
-  pc_result_t st = pc_logseg_erase(f, base);
-  if (st != PC_OK)
-    return st;
+  // erase segment (unless the caller keeps it erased already)
+  if (erase)
+  {
+    pc_result_t st = pc_logseg_erase(f, base);
+    if (st != PC_OK)
+      return st;
+  }
 
   memset(a->page, 0xFF, a->prog);
   a->page_off = 0;
@@ -76,11 +82,24 @@ pc_result_t pc_appender_open(pc_appender_t *a, pc_flash_t *f, size_t base, uint3
   a->ts_min = 0xFFFFFFFFu;
   a->ts_max = 0u;
   a->record_count = 0u;
+  a->sketch = false;
+  a->verify_commit = false;
+  a->crc = PC_CRC32C_SEED;
   a->seqno = seqno;
   a->open = true;
   return PC_OK;
 }
 
+pc_result_t pc_appender_open(pc_appender_t *a, pc_flash_t *f, size_t base, uint32_t seqno)
+{
+  return open_seg(a, f, base, seqno, true);
+}
+
+pc_result_t pc_appender_open_erased(pc_appender_t *a, pc_flash_t *f, size_t base, uint32_t seqno)
+{
+  return open_seg(a, f, base, seqno, false);
+}
+
 pc_result_t pc_appender_append_block(pc_appender_t *a,
                                      uint16_t metric_id,
                                      uint16_t series_id,
@@ -93,8 +112,19 @@ pc_result_t pc_appender_append_block(pc_appender_t *a,
   if (npoints == 0)
     return PC_EINVAL;
 
+  if (npoints > PC_BLOCK_COUNT_MASK)
+    return PC_EINVAL;
+  const bool summary = PC_BLOCK_SUMMARY_MIN_POINTS && npoints >= PC_BLOCK_SUMMARY_MIN_POINTS;
+
+  // The sketch is built up front: its size decides whether the block fits.
+  uint8_t sketch[PC_SKETCH_MAX_BYTES];
+  size_t sketch_len = 0;
+  if (summary && a->sketch && npoints <= PC_SKETCH_MAX_POINTS)
+    sketch_len = pc_sketch_encode(val_array, npoints, sketch, sizeof(sketch));
+
   // Compute how many bytes the block needs.
-  const size_t need = sizeof(pc_block_hdr_t) + (size_t)npoints * sizeof(pc_point_disk_t);
+  const size_t need = sizeof(pc_block_hdr_t) + (size_t)npoints * sizeof(pc_point_disk_t) +
+                      (summary ? sizeof(pc_block_summary_t) : 0) + sketch_len;
 
   // Check fit conservatively: we may need to flush the partially filled page at the end,
   // which always programs a full page. Because preH is a multiple of prog, the last
@@ -104,17 +134,30 @@ pc_result_t pc_appender_append_block(pc_appender_t *a,
     return PC_NO_SPACE;
   }
 
+  // Readers binary-search blocks that arrived in ts order.
+  bool sorted = true;
+  for (uint32_t i = 1; i < npoints && sorted; ++i)
+    sorted = ts_array[i] >= ts_array[i - 1];
+
   // Write block header
   pc_block_hdr_t hdr;
   hdr.metric_id = metric_id;
   hdr.series_id = series_id;
   hdr.start_ts = ts_array[0];
-  hdr.point_count = npoints;
+  hdr.point_count = npoints | (summary ? PC_BLOCK_F_SUMMARY : 0u) | (sketch_len ? PC_BLOCK_F_SKETCH : 0u) |
+                    (sorted ? PC_BLOCK_F_SORTED : 0u);
 
   pc_result_t st = emit_bytes(a, &hdr, sizeof(hdr));
   if (st != PC_OK)
     return st;
 
+  pc_block_summary_t sum;
+  sum.ts_min = 0xFFFFFFFFu;
+  sum.ts_max = 0u;
+  sum.v_min = val_array[0];
+  sum.v_max = val_array[0];
+  sum.v_sum = 0.0;
+
   // Write points
   for (uint32_t i = 0; i < npoints; ++i)
   {
@@ -122,20 +165,52 @@ pc_result_t pc_appender_append_block(pc_appender_t *a,
     pt.ts = ts_array[i];
     pt.value = val_array[i];
 
-    if (pt.ts < a->ts_min)
-      a->ts_min = pt.ts;
-    if (pt.ts > a->ts_max)
-      a->ts_max = pt.ts;
+    if (pt.ts < sum.ts_min)
+      sum.ts_min = pt.ts;
+    if (pt.ts > sum.ts_max)
+      sum.ts_max = pt.ts;
+    if (pt.value < sum.v_min)
+      sum.v_min = pt.value;
+    if (pt.value > sum.v_max)
+      sum.v_max = pt.value;
+    sum.v_sum += pt.value;
 
     st = emit_bytes(a, &pt, sizeof(pt));
     if (st != PC_OK)
       return st;
   }
 
+  if (sum.ts_min < a->ts_min)
+    a->ts_min = sum.ts_min;
+  if (sum.ts_max > a->ts_max)
+    a->ts_max = sum.ts_max;
+
+  if (summary)
+  {
+    st = emit_bytes(a, &sum, sizeof(sum));
+    if (st != PC_OK)
+      return st;
+  }
+  if (sketch_len)
+  {
+    st = emit_bytes(a, sketch, sketch_len);
+    if (st != PC_OK)
+      return st;
+  }
+
   a->record_count += npoints;
   return PC_OK;
 }
 
+pc_result_t pc_appender_append_bytes(pc_appender_t *a, const void *data, size_t len)
+{
+  if (!a || !a->open || (!data && len > 0))
+    return PC_EINVAL;
+  if (a->seg_off + len > a->preH)
+    return PC_NO_SPACE;
+  return emit_bytes(a, data, len);
+}
+
 pc_result_t pc_appender_commit(pc_appender_t *a, uint16_t type)
 {
   if (!a || !a->open)
@@ -150,10 +225,28 @@ pc_result_t pc_appender_commit(pc_appender_t *a, uint16_t type)
       return st;
   }
 
-  pc_result_t rc = pc_logseg_commit(a->f, a->base, type, a->seqno,
-                                    a->ts_min == 0xFFFFFFFFu ? 0u : a->ts_min,
-                                    a->ts_max,
-                                    a->record_count);
+  // Pages never programmed still hold the erased value.
+  uint32_t crc = a->crc;
+  uint8_t erased[512];
+  memset(erased, a->f->erased_val, a->prog);
+  for (size_t off = (a->seg_off + a->prog - 1) / a->prog * a->prog; off < a->preH; off += a->prog)
+    crc = pc_crc32c_update(crc, erased, a->prog);
+  crc = PC_CRC32C_FINALIZE(crc);
+
+  if (a->verify_commit)
+  {
+    uint32_t on_flash = 0;
+    pc_result_t st = pc_logseg_crc32c_region(a->f, a->base, &on_flash);
+    if (st != PC_OK)
+      return st;
+    if (on_flash != crc)
+      return PC_CORRUPT; // flash does not hold what was staged: leave uncommitted
+  }
+
+  pc_result_t rc = pc_logseg_commit_with_crc(a->f, a->base, type, a->seqno,
+                                             a->ts_min == 0xFFFFFFFFu ? 0u : a->ts_min,
+                                             a->ts_max,
+                                             a->record_count, crc);
   if (rc == PC_OK)
     a->open = false;
   return rc;
@@ -167,3 +167,28 @@ pc_result_t pc_block_write_segment(pc_flash_t *f,
   // Commit the segment header last (atomic).
   return pc_logseg_commit(f, base, PC_SEG_DATA, seqno, ts_min, ts_max, npoints);
 }
+
+uint32_t pc_block_find_asof(const pc_point_disk_t *pts, uint32_t n, bool sorted, uint32_t t)
+{
+  if (!pts || n == 0)
+    return n;
+  if (sorted)
+  {
+    // First index with ts > t; the point before it is the answer.
+    uint32_t lo = 0, hi = n;
+    while (lo < hi)
+    {
+      uint32_t mid = lo + (hi - lo) / 2;
+      if (pts[mid].ts <= t)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo ? lo - 1 : n;
+  }
+  uint32_t best = n;
+  for (uint32_t i = 0; i < n; ++i)
+    if (pts[i].ts <= t && (best == n || pts[i].ts >= pts[best].ts))
+      best = i;
+  return best;
+}
@@ -0,0 +1,205 @@
+#include "pc_blockcache.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t key_hash(size_t base, uint32_t seqno, uint32_t off)
+{
+  uint32_t h = (uint32_t)base * 0x9E3779B1u;
+  h ^= seqno * 0x85EBCA6Bu;
+  h ^= off * 0xC2B2AE35u;
+  return h ^ (h >> 15);
+}
+
+void pc_blockcache_init(pc_blockcache_t *c, size_t max_bytes)
+{
+  if (!c)
+    return;
+  memset(c, 0, sizeof(*c));
+  c->free_head = -1;
+  c->lru_head = c->lru_tail = -1;
+  c->max_bytes = max_bytes;
+}
+
+void pc_blockcache_free(pc_blockcache_t *c)
+{
+  if (!c)
+    return;
+  for (size_t i = 0; i < c->nents; ++i)
+    free(c->ents[i].data);
+  free(c->ents);
+  free(c->buckets);
+  pc_blockcache_init(c, 0);
+}
+
+static int32_t *chain_of(pc_blockcache_t *c, size_t base, uint32_t seqno, uint32_t off)
+{
+  return &c->buckets[key_hash(base, seqno, off) & (c->nbuckets - 1)];
+}
+
+static void lru_unlink(pc_blockcache_t *c, int32_t i)
+{
+  pc_blockcache_ent_t *e = &c->ents[i];
+  if (e->prev >= 0)
+    c->ents[e->prev].next = e->next;
+  else
+    c->lru_head = e->next;
+  if (e->next >= 0)
+    c->ents[e->next].prev = e->prev;
+  else
+    c->lru_tail = e->prev;
+  e->prev = e->next = -1;
+}
+
+static void lru_push_front(pc_blockcache_t *c, int32_t i)
+{
+  pc_blockcache_ent_t *e = &c->ents[i];
+  e->prev = -1;
+  e->next = c->lru_head;
+  if (c->lru_head >= 0)
+    c->ents[c->lru_head].prev = i;
+  c->lru_head = i;
+  if (c->lru_tail < 0)
+    c->lru_tail = i;
+}
+
+// Unlink slot i from its chain + the LRU list and return it to the pool.
+static void drop(pc_blockcache_t *c, int32_t i)
+{
+  pc_blockcache_ent_t *e = &c->ents[i];
+  int32_t *pp = chain_of(c, e->base, e->seqno, e->off);
+  while (*pp != i)
+    pp = &c->ents[*pp].hnext;
+  *pp = e->hnext;
+  lru_unlink(c, i);
+  c->bytes -= e->len;
+  c->count--;
+  free(e->data);
+  e->data = NULL;
+  e->len = 0;
+  e->hnext = c->free_head;
+  c->free_head = i;
+}
+
+static pc_result_t grow(pc_blockcache_t *c)
+{
+  size_t n = c->nents ? c->nents * 2 : 32;
+  pc_blockcache_ent_t *ents = (pc_blockcache_ent_t *)realloc(c->ents, n * sizeof(*ents));
+  if (!ents)
+    return PC_NO_SPACE;
+  c->ents = ents;
+  for (size_t i = n; i-- > c->nents;)
+  {
+    memset(&ents[i], 0, sizeof(ents[i]));
+    ents[i].hnext = c->free_head;
+    c->free_head = (int32_t)i;
+  }
+  c->nents = n;
+
+  // One bucket per slot; re-chain the live entries.
+  int32_t *b = (int32_t *)malloc(n * sizeof(*b));
+  if (!b)
+    return PC_NO_SPACE;
+  for (size_t i = 0; i < n; ++i)
+    b[i] = -1;
+  free(c->buckets);
+  c->buckets = b;
+  c->nbuckets = n;
+  for (int32_t i = c->lru_head; i >= 0; i = ents[i].next)
+  {
+    int32_t *head = chain_of(c, ents[i].base, ents[i].seqno, ents[i].off);
+    ents[i].hnext = *head;
+    *head = i;
+  }
+  return PC_OK;
+}
+
+static int32_t find(pc_blockcache_t *c, size_t base, uint32_t seqno, uint32_t off)
+{
+  if (!c->nbuckets)
+    return -1;
+  for (int32_t i = *chain_of(c, base, seqno, off); i >= 0; i = c->ents[i].hnext)
+  {
+    const pc_blockcache_ent_t *e = &c->ents[i];
+    if (e->base == base && e->seqno == seqno && e->off == off)
+      return i;
+  }
+  return -1;
+}
+
+const void *pc_blockcache_get(pc_blockcache_t *c, size_t base, uint32_t seqno, uint32_t off, size_t *out_len)
+{
+  if (!c || !c->max_bytes)
+    return NULL;
+  int32_t i = find(c, base, seqno, off);
+  if (i < 0)
+  {
+    c->misses++;
+    return NULL;
+  }
+  c->hits++;
+  lru_unlink(c, i);
+  lru_push_front(c, i);
+  if (out_len)
+    *out_len = c->ents[i].len;
+  return c->ents[i].data;
+}
+
+pc_result_t pc_blockcache_put(pc_blockcache_t *c, size_t base, uint32_t seqno, uint32_t off,
+                              const void *data, size_t len)
+{
+  if (!c || (!data && len))
+    return PC_EINVAL;
+  if (len == 0 || len > c->max_bytes)
+    return PC_NO_SPACE;
+
+  int32_t old = find(c, base, seqno, off);
+  if (old >= 0)
+    drop(c, old);
+  while (c->bytes + len > c->max_bytes && c->lru_tail >= 0)
+  {
+    drop(c, c->lru_tail);
+    c->evictions++;
+  }
+
+  void *copy = malloc(len);
+  if (!copy)
+    return PC_NO_SPACE;
+  if (c->free_head < 0 && grow(c) != PC_OK)
+  {
+    free(copy);
+    return PC_NO_SPACE;
+  }
+  memcpy(copy, data, len);
+
+  int32_t i = c->free_head;
+  pc_blockcache_ent_t *e = &c->ents[i];
+  c->free_head = e->hnext;
+  e->base = base;
+  e->seqno = seqno;
+  e->off = off;
+  e->data = copy;
+  e->len = len;
+  int32_t *head = chain_of(c, base, seqno, off);
+  e->hnext = *head;
+  *head = i;
+  lru_push_front(c, i);
+  c->bytes += len;
+  c->count++;
+  return PC_OK;
+}
+
+void pc_blockcache_invalidate_base(pc_blockcache_t *c, size_t base)
+{
+  if (!c)
+    return;
+  for (int32_t i = c->lru_head; i >= 0;)
+  {
+    int32_t next = c->ents[i].next;
+    if (c->ents[i].base == base)
+    {
+      drop(c, i);
+      c->invalidations++;
+    }
+    i = next;
+  }
+}
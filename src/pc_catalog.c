@@ -0,0 +1,120 @@
+#include "pc_catalog.h"
+#include <stdlib.h>
+#include <string.h>
+
+void pc_catalog_init(pc_catalog_t *c)
+{
+  if (!c)
+    return;
+  c->segs = NULL;
+  c->ts_max_upto = NULL;
+  c->count = 0;
+  c->cap = 0;
+}
+
+void pc_catalog_free(pc_catalog_t *c)
+{
+  if (!c)
+    return;
+  free(c->segs);
+  free(c->ts_max_upto);
+  c->segs = NULL;
+  c->ts_max_upto = NULL;
+  c->count = 0;
+  c->cap = 0;
+}
+
+static pc_result_t grow(pc_catalog_t *c)
+{
+  size_t cap = c->cap ? c->cap * 2 : 16;
+  pc_seg_summary_t *p = (pc_seg_summary_t *)realloc(c->segs, cap * sizeof(*p));
+  if (!p)
+    return PC_NO_SPACE;
+  c->segs = p;
+  uint32_t *m = (uint32_t *)realloc(c->ts_max_upto, cap * sizeof(*m));
+  if (!m)
+    return PC_NO_SPACE;
+  c->ts_max_upto = m;
+  c->cap = cap;
+  return PC_OK;
+}
+
+// Recompute the running ts_max from entry 'from' onwards.
+static void refresh_upto(pc_catalog_t *c, size_t from)
+{
+  for (size_t i = from; i < c->count; ++i)
+  {
+    uint32_t prev = i ? c->ts_max_upto[i - 1] : 0u;
+    c->ts_max_upto[i] = c->segs[i].ts_max > prev ? c->segs[i].ts_max : prev;
+  }
+}
+
+pc_result_t pc_catalog_add(pc_catalog_t *c, const pc_seg_summary_t *s)
+{
+  if (!c || !s)
+    return PC_EINVAL;
+
+  (void)pc_catalog_remove_base(c, s->base);
+
+  if (c->count == c->cap)
+  {
+    pc_result_t st = grow(c);
+    if (st != PC_OK)
+      return st;
+  }
+
+  // Commits arrive in seqno order, so the common case is an append.
+  size_t pos = c->count;
+  while (pos > 0 && c->segs[pos - 1].seqno > s->seqno)
+    pos--;
+  memmove(&c->segs[pos + 1], &c->segs[pos], (c->count - pos) * sizeof(*s));
+  c->segs[pos] = *s;
+  c->count++;
+  refresh_upto(c, pos);
+  return PC_OK;
+}
+
+bool pc_catalog_remove_base(pc_catalog_t *c, size_t base)
+{
+  if (!c)
+    return false;
+  for (size_t i = 0; i < c->count; ++i)
+  {
+    if (c->segs[i].base == base)
+    {
+      memmove(&c->segs[i], &c->segs[i + 1], (c->count - i - 1) * sizeof(c->segs[0]));
+      c->count--;
+      refresh_upto(c, i);
+      return true;
+    }
+  }
+  return false;
+}
+
+const pc_seg_summary_t *pc_catalog_find_base(const pc_catalog_t *c, size_t base)
+{
+  if (!c)
+    return NULL;
+  for (size_t i = 0; i < c->count; ++i)
+  {
+    if (c->segs[i].base == base)
+      return &c->segs[i];
+  }
+  return NULL;
+}
+
+const pc_seg_summary_t *pc_catalog_find_seq(const pc_catalog_t *c, uint32_t seqno)
+{
+  if (!c)
+    return NULL;
+  size_t lo = 0, hi = c->count;
+  while (lo < hi)
+  {
+    size_t mid = lo + (hi - lo) / 2;
+    if (c->segs[mid].seqno < seqno)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo < c->count && c->segs[lo].seqno == seqno ? &c->segs[lo] : NULL;
+}
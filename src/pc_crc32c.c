@@ -1,6 +1,20 @@
 // CRC32C (Castagnoli) table-driven implementation (simple & readable).
 // Polynomial: 0x1EDC6F41, reflected input/output, seed=0xFFFFFFFF, xor-out=~crc.
+// PR-026: slicing-by-8 and CRC-instruction paths, chosen once at first use.
 #include "pc_crc32c.h"
+#include <string.h>
+
+#if PC_CRC32C_HW && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PC_CRC_X86 1
+#include <nmmintrin.h>
+#elif PC_CRC32C_HW && defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define PC_CRC_ARM 1
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#define POLY 0x82F63B78u // reflected 0x1EDC6F41
 
 static const uint32_t kCrc32cTable[256] = {
     /* 256-entry table generated for poly 0x1EDC6F41 (reflected). */
@@ -37,7 +51,7 @@ static const uint32_t kCrc32cTable[256] = {
     0xF36E6F75u, 0x0105EC76u, 0x12551F82u, 0xE03E9C81u, 0x34F4F86Au, 0xC69F7B69u, 0xD5CF889Du, 0x27A40B9Eu,
     0x79B737BAu, 0x8BDCB4B9u, 0x988C474Du, 0x6AE7C44Eu, 0xBE2DA0A5u, 0x4C4623A6u, 0x5F16D052u, 0xAD7D5351u};
 
-uint32_t pc_crc32c_update(uint32_t crc, const void *data, size_t len)
+static uint32_t crc_table(uint32_t crc, const void *data, size_t len)
 {
   const uint8_t *p = (const uint8_t *)data;
   while (len--)
@@ -47,3 +61,249 @@ uint32_t pc_crc32c_update(uint32_t crc, const void *data, size_t len)
   }
   return crc; // not finalized; caller may xor-out with ~crc
 }
+
+// ---- Slicing-by-8 ----
+
+static uint32_t slice8[8][256]; // slice8[0] == kCrc32cTable
+
+static void slice8_init(void)
+{
+  for (int i = 0; i < 256; ++i)
+    slice8[0][i] = kCrc32cTable[i];
+  for (int k = 1; k < 8; ++k)
+    for (int i = 0; i < 256; ++i)
+      slice8[k][i] = (slice8[k - 1][i] >> 8) ^ slice8[0][slice8[k - 1][i] & 0xFFu];
+}
+
+static uint32_t crc_slice8(uint32_t crc, const void *data, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  while (len >= 8)
+  {
+    // Byte-wise assembly keeps this endian-neutral; compilers fuse it into loads.
+    uint32_t lo = crc ^ ((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+    uint32_t hi = (uint32_t)p[4] | (uint32_t)p[5] << 8 | (uint32_t)p[6] << 16 | (uint32_t)p[7] << 24;
+    crc = slice8[7][lo & 0xFFu] ^ slice8[6][(lo >> 8) & 0xFFu] ^ slice8[5][(lo >> 16) & 0xFFu] ^
+          slice8[4][lo >> 24] ^ slice8[3][hi & 0xFFu] ^ slice8[2][(hi >> 8) & 0xFFu] ^
+          slice8[1][(hi >> 16) & 0xFFu] ^ slice8[0][hi >> 24];
+    p += 8;
+    len -= 8;
+  }
+  return crc_table(crc, p, len);
+}
+
+// ---- SSE4.2 ----
+
+#if PC_CRC_X86
+
+// Three streams of CHUNK bytes run side by side, then the first two are shifted
+// over the bytes that followed them (crc(A|B) = crc(A) * x^(8|B|) ^ crc0(B)).
+#define CHUNK_LONG 1024u
+#define CHUNK_SHORT 128u
+
+static uint32_t shift_long[4][256], shift_short[4][256];
+
+// a * b mod P (reflected: bit 31 is x^0)
+static uint32_t multmodp(uint32_t a, uint32_t b)
+{
+  uint32_t m = 1u << 31, p = 0;
+  for (;;)
+  {
+    if (a & m)
+    {
+      p ^= b;
+      if ((a & (m - 1)) == 0)
+        break;
+    }
+    m >>= 1;
+    b = (b & 1u) ? (b >> 1) ^ POLY : b >> 1;
+  }
+  return p;
+}
+
+// Tables multiplying a CRC by x^(8 * len), one byte of it at a time.
+static void shift_init(uint32_t tab[4][256], size_t len)
+{
+  uint32_t xn = 1u << 31; // x^0
+  uint32_t sq = 1u << 30; // x^1, squared as we go: x^(2^k)
+  for (size_t n = len * 8; n; n >>= 1)
+  {
+    if (n & 1)
+      xn = multmodp(sq, xn);
+    sq = multmodp(sq, sq);
+  }
+  for (int k = 0; k < 4; ++k)
+    for (uint32_t i = 0; i < 256; ++i)
+      tab[k][i] = multmodp(xn, i << (8 * k));
+}
+
+static inline uint32_t shift(uint32_t tab[4][256], uint32_t crc)
+{
+  return tab[0][crc & 0xFFu] ^ tab[1][(crc >> 8) & 0xFFu] ^ tab[2][(crc >> 16) & 0xFFu] ^ tab[3][crc >> 24];
+}
+
+static inline uint64_t load64(const uint8_t *p)
+{
+  uint64_t w;
+  memcpy(&w, p, sizeof w);
+  return w;
+}
+
+__attribute__((target("sse4.2"))) static uint32_t crc_hw(uint32_t crc, const void *data, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  uint64_t c0 = crc;
+
+  // Align to 8 bytes.
+  while (len && ((uintptr_t)p & 7u))
+  {
+    c0 = _mm_crc32_u8((uint32_t)c0, *p++);
+    len--;
+  }
+
+  while (len >= 3 * CHUNK_SHORT)
+  {
+    const size_t chunk = len >= 3 * CHUNK_LONG ? CHUNK_LONG : CHUNK_SHORT;
+    uint64_t c1 = 0, c2 = 0;
+    for (const uint8_t *end = p + chunk; p < end; p += 8)
+    {
+      c0 = _mm_crc32_u64(c0, load64(p));
+      c1 = _mm_crc32_u64(c1, load64(p + chunk));
+      c2 = _mm_crc32_u64(c2, load64(p + 2 * chunk));
+    }
+    uint32_t(*tab)[256] = chunk == CHUNK_LONG ? shift_long : shift_short;
+    c0 = shift(tab, (uint32_t)c0) ^ (uint32_t)c1;
+    c0 = shift(tab, (uint32_t)c0) ^ (uint32_t)c2;
+    p += 2 * chunk;
+    len -= 3 * chunk;
+  }
+
+  for (; len >= 8; len -= 8, p += 8)
+    c0 = _mm_crc32_u64(c0, load64(p));
+  while (len--)
+    c0 = _mm_crc32_u8((uint32_t)c0, *p++);
+  return (uint32_t)c0;
+}
+
+static bool hw_probe(void)
+{
+  shift_init(shift_long, CHUNK_LONG);
+  shift_init(shift_short, CHUNK_SHORT);
+  return __builtin_cpu_supports("sse4.2");
+}
+
+// ---- ARMv8 CRC ----
+
+#elif PC_CRC_ARM
+
+__attribute__((target("+crc"))) static uint32_t crc_hw(uint32_t crc, const void *data, size_t len)
+{
+  const uint8_t *p = (const uint8_t *)data;
+  while (len && ((uintptr_t)p & 7u))
+  {
+    crc = __crc32cb(crc, *p++);
+    len--;
+  }
+  for (; len >= 8; len -= 8, p += 8)
+  {
+    uint64_t w;
+    memcpy(&w, p, sizeof w);
+    crc = __crc32cd(crc, w);
+  }
+  while (len--)
+    crc = __crc32cb(crc, *p++);
+  return crc;
+}
+
+static bool hw_probe(void) { return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0; }
+
+#else
+
+static uint32_t crc_hw(uint32_t crc, const void *data, size_t len) { return crc_table(crc, data, len); }
+static bool hw_probe(void) { return false; }
+
+#endif
+
+// ---- Dispatch ----
+
+typedef uint32_t (*crc_fn)(uint32_t crc, const void *data, size_t len);
+
+static bool hw_ok;
+static crc_fn active = NULL;
+static int init_state; // 0 = not started, 1 = tables being built, 2 = published
+
+// Build the tables and pick the implementation, exactly once. The caller that
+// wins the compare-and-swap fills the tables and sets hw_ok / active, then
+// publishes them with a release store; racing first calls wait for it, so no
+// thread reads a table while it is written.
+static crc_fn resolve(void)
+{
+  if (__atomic_load_n(&init_state, __ATOMIC_ACQUIRE) == 2)
+    return active;
+  int expected = 0;
+  if (__atomic_compare_exchange_n(&init_state, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+  {
+    slice8_init();
+    hw_ok = hw_probe();
+    active = hw_ok ? crc_hw : crc_slice8;
+    __atomic_store_n(&init_state, 2, __ATOMIC_RELEASE);
+  }
+  else
+  {
+    while (__atomic_load_n(&init_state, __ATOMIC_ACQUIRE) != 2)
+      ; // a few microseconds, once per process
+  }
+  return active;
+}
+
+uint32_t pc_crc32c_update(uint32_t crc, const void *data, size_t len)
+{
+  return resolve()(crc, data, len);
+}
+
+bool pc_crc32c_available(pc_crc32c_impl_t impl)
+{
+  resolve(); // orders the hw_ok read after its publication
+  return impl == PC_CRC32C_IMPL_TABLE || impl == PC_CRC32C_IMPL_SLICE8 || (impl == PC_CRC32C_IMPL_HW && hw_ok);
+}
+
+uint32_t pc_crc32c_update_with(pc_crc32c_impl_t impl, uint32_t crc, const void *data, size_t len)
+{
+  if (!pc_crc32c_available(impl))
+    impl = PC_CRC32C_IMPL_TABLE;
+  switch (impl)
+  {
+  case PC_CRC32C_IMPL_SLICE8:
+    return crc_slice8(crc, data, len);
+  case PC_CRC32C_IMPL_HW:
+    return crc_hw(crc, data, len);
+  default:
+    return crc_table(crc, data, len);
+  }
+}
+
+pc_crc32c_impl_t pc_crc32c_active(void)
+{
+  return resolve() == crc_slice8 ? PC_CRC32C_IMPL_SLICE8 : PC_CRC32C_IMPL_HW;
+}
+
+const char *pc_crc32c_impl_name(pc_crc32c_impl_t impl)
+{
+  switch (impl)
+  {
+  case PC_CRC32C_IMPL_TABLE:
+    return "table";
+  case PC_CRC32C_IMPL_SLICE8:
+    return "slice8";
+  case PC_CRC32C_IMPL_HW:
+#if PC_CRC_X86
+    return "sse4.2";
+#elif PC_CRC_ARM
+    return "armv8-crc";
+#else
+    return "hw";
+#endif
+  default:
+    return "?";
+  }
+}
@@ -0,0 +1,141 @@
+#include "pc_epoch.h"
+#include "pc_appender.h"
+#include "pc_recover.h"
+#include <string.h>
+
+static bool live_get(const uint8_t *live, size_t i) { return (live[i / 8] >> (i % 8)) & 1u; }
+
+bool pc_epoch_fits(const pc_flash_t *f)
+{
+  if (!f || pc_flash_sector_count(f) <= PC_EPOCH_SLOTS)
+    return false;
+  return sizeof(pc_epoch_t) + pc_epoch_live_bytes(f) <= pc_logseg_preheader_bytes(f);
+}
+
+// Epoch held by superblock slot 'slot', if it is a valid one for this device.
+static bool read_slot(const pc_flash_t *f, size_t slot, pc_epoch_t *ep)
+{
+  const size_t base = slot * pc_flash_sector_bytes(f);
+  pc_segment_hdr_t hdr;
+  if (pc_flash_is_bad(f, slot) || pc_logseg_verify(f, base, &hdr) != PC_OK || hdr.type != PC_SEG_EPOCH)
+    return false;
+  if (pc_flash_read(f, base, ep, sizeof(*ep)) != PC_OK)
+    return false;
+  if (ep->magic != PC_EPOCH_MAGIC || ep->version != PC_EPOCH_VERSION ||
+      ep->sector_count != pc_flash_sector_count(f) || ep->seqno != hdr.seqno)
+    return false;
+  return true;
+}
+
+// Slot of the newest valid epoch, or PC_EPOCH_SLOTS if there is none.
+static size_t newest_slot(const pc_flash_t *f, pc_epoch_t *out)
+{
+  size_t best = PC_EPOCH_SLOTS;
+  for (size_t s = 0; s < PC_EPOCH_SLOTS; ++s)
+  {
+    pc_epoch_t ep;
+    if (!read_slot(f, s, &ep))
+      continue;
+    if (best == PC_EPOCH_SLOTS || ep.seqno > out->seqno)
+    {
+      best = s;
+      *out = ep;
+    }
+  }
+  return best;
+}
+
+pc_result_t pc_epoch_write(pc_flash_t *f, const pc_epoch_t *ep, const uint8_t *live, uint32_t seqno)
+{
+  if (!f || !ep || !live)
+    return PC_EINVAL;
+  if (!pc_epoch_fits(f))
+    return PC_UNSUPPORTED;
+
+  pc_epoch_t cur;
+  const size_t newest = newest_slot(f, &cur);
+  const size_t slot = newest == PC_EPOCH_SLOTS ? 0 : (newest + 1) % PC_EPOCH_SLOTS;
+
+  pc_epoch_t rec = *ep;
+  rec.magic = PC_EPOCH_MAGIC;
+  rec.version = PC_EPOCH_VERSION;
+  rec.reserved = 0xFFFFu;
+  rec.seqno = seqno;
+  rec.sector_count = (uint32_t)pc_flash_sector_count(f);
+
+  pc_appender_t app;
+  pc_result_t st = pc_appender_open(&app, f, slot * pc_flash_sector_bytes(f), seqno);
+  if (st == PC_OK)
+    st = pc_appender_append_bytes(&app, &rec, sizeof(rec));
+  if (st == PC_OK)
+    st = pc_appender_append_bytes(&app, live, pc_epoch_live_bytes(f));
+  if (st == PC_OK)
+    st = pc_appender_commit(&app, PC_SEG_EPOCH);
+  return st;
+}
+
+pc_result_t pc_epoch_load(const pc_flash_t *f, pc_epoch_t *ep, uint8_t *live, size_t live_bytes)
+{
+  if (!f || !ep || !live || live_bytes < pc_epoch_live_bytes(f))
+    return PC_EINVAL;
+  if (!pc_epoch_fits(f))
+    return PC_METRIC_UNKNOWN;
+  const size_t slot = newest_slot(f, ep);
+  if (slot == PC_EPOCH_SLOTS)
+    return PC_METRIC_UNKNOWN;
+  const size_t base = slot * pc_flash_sector_bytes(f);
+  if (pc_flash_read(f, base + sizeof(*ep), live, pc_epoch_live_bytes(f)) != PC_OK)
+    return PC_METRIC_UNKNOWN;
+  return PC_OK;
+}
+
+pc_result_t pc_epoch_read_headers(const pc_flash_t *f, const pc_epoch_t *ep, const uint8_t *live,
+                                  pc_segment_hdr_t *hdrs, uint8_t *states, size_t *end, size_t *headers_read)
+{
+  if (!f || !ep || !live || !hdrs || !states)
+    return PC_EINVAL;
+  const size_t count = pc_flash_sector_count(f);
+  if (ep->sector_count != count || count <= PC_EPOCH_SLOTS)
+    return PC_EINVAL;
+
+  size_t reads = 0;
+  for (size_t i = 0; i < count; ++i)
+    states[i] = PC_SECT_UNKNOWN;
+
+  // Live at the epoch: still holds that segment, or was erased since.
+  for (size_t i = PC_EPOCH_SLOTS; i < count; ++i)
+  {
+    if (!live_get(live, i))
+      continue;
+    states[i] = (uint8_t)pc_recover_sector_state(f, i, &hdrs[i]);
+    reads += states[i] != PC_SECT_BAD;
+  }
+
+  // Free at the epoch: the allocator took these in this order, so the first one
+  // still free is where the log ends. Live sectors were skipped by it (any
+  // erased since are not proof of an end).
+  const size_t span = count - PC_EPOCH_SLOTS;
+  const size_t head = ep->alloc_head >= PC_EPOCH_SLOTS && ep->alloc_head < count ? ep->alloc_head - PC_EPOCH_SLOTS : 0;
+  size_t stop = PC_EPOCH_SLOTS + head;
+  for (size_t step = 0; step < span; ++step)
+  {
+    const size_t i = PC_EPOCH_SLOTS + (head + step) % span;
+    if (live_get(live, i))
+      continue;
+    states[i] = (uint8_t)pc_recover_sector_state(f, i, &hdrs[i]);
+    if (states[i] == PC_SECT_BAD)
+      continue;
+    reads++;
+    if (states[i] == PC_SECT_FREE)
+    {
+      stop = i;
+      break;
+    }
+  }
+
+  if (end)
+    *end = stop;
+  if (headers_read)
+    *headers_read = reads;
+  return PC_OK;
+}
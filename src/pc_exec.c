@@ -0,0 +1,520 @@
+#include "pc_exec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// ---- Time filter ----
+
+static bool range_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  const pc_exec_range_t *f = (const pc_exec_range_t *)op;
+  const uint32_t n = b->n;
+  uint32_t lo = UINT32_MAX, hi = 0;
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    lo = b->ts[i] < lo ? b->ts[i] : lo;
+    hi = b->ts[i] > hi ? b->ts[i] : hi;
+  }
+  if (lo < f->t0 || hi > f->t1)
+  {
+    // Branch-free compaction: always copy, advance only on a match.
+    uint32_t k = 0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      uint32_t t = b->ts[i];
+      float v = b->val[i];
+      b->ts[k] = t;
+      b->val[k] = v;
+      k += (uint32_t)(t >= f->t0) & (uint32_t)(t <= f->t1);
+    }
+    b->n = k;
+  }
+  return b->n == 0 || op->next->push(op->next, b);
+}
+
+static bool range_summary(pc_exec_op_t *op, const pc_block_summary_t *sum, uint32_t count,
+                          uint16_t metric_id, uint16_t series_id)
+{
+  const pc_exec_range_t *f = (const pc_exec_range_t *)op;
+  if (sum->ts_min < f->t0 || sum->ts_max > f->t1 || !op->next->push_summary)
+    return false;
+  return op->next->push_summary(op->next, sum, count, metric_id, series_id);
+}
+
+void pc_exec_range_init(pc_exec_range_t *f, uint32_t t0, uint32_t t1, pc_exec_op_t *next)
+{
+  f->op.push = range_push;
+  f->op.push_summary = range_summary;
+  f->op.next = next;
+  f->t0 = t0;
+  f->t1 = t1;
+}
+
+// ---- Value filter ----
+
+static bool value_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  const pc_exec_value_t *f = (const pc_exec_value_t *)op;
+  const uint32_t n = b->n;
+  uint32_t k = 0;
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    uint32_t t = b->ts[i];
+    float v = b->val[i];
+    b->ts[k] = t;
+    b->val[k] = v;
+    k += (uint32_t)(v >= f->lo) & (uint32_t)(v <= f->hi);
+  }
+  b->n = k;
+  return k == 0 || op->next->push(op->next, b);
+}
+
+static bool value_summary(pc_exec_op_t *op, const pc_block_summary_t *sum, uint32_t count,
+                          uint16_t metric_id, uint16_t series_id)
+{
+  const pc_exec_value_t *f = (const pc_exec_value_t *)op;
+  // A NaN anywhere in the block shows up in v_sum; such blocks are decoded.
+  if (sum->v_sum != sum->v_sum || sum->v_min < f->lo || sum->v_max > f->hi || !op->next->push_summary)
+    return false;
+  return op->next->push_summary(op->next, sum, count, metric_id, series_id);
+}
+
+void pc_exec_value_init(pc_exec_value_t *f, float lo, float hi, pc_exec_op_t *next)
+{
+  f->op.push = value_push;
+  f->op.push_summary = value_summary;
+  f->op.next = next;
+  f->lo = lo;
+  f->hi = hi;
+}
+
+// ---- Bucketed aggregate ----
+
+static void fold(pc_bucket_t *o, uint32_t count, float vmin, float vmax, double sum)
+{
+  if (o->count == 0 || vmin < o->min)
+    o->min = vmin;
+  if (o->count == 0 || vmax > o->max)
+    o->max = vmax;
+  o->sum += sum;
+  o->count += count;
+}
+
+static bool agg_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  pc_exec_agg_t *a = (pc_exec_agg_t *)op;
+  const uint32_t n = b->n;
+  uint32_t lo = UINT32_MAX, hi = 0;
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    lo = b->ts[i] < lo ? b->ts[i] : lo;
+    hi = b->ts[i] > hi ? b->ts[i] : hi;
+  }
+
+  if (n && lo >= a->t0 && (lo - a->t0) / a->bucket_secs == (hi - a->t0) / a->bucket_secs &&
+      (lo - a->t0) / a->bucket_secs < a->nbuckets)
+  {
+    // Whole batch in one bucket: plain column reductions.
+    float vmin = b->val[0], vmax = b->val[0];
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      vmin = b->val[i] < vmin ? b->val[i] : vmin;
+      vmax = b->val[i] > vmax ? b->val[i] : vmax;
+      sum += b->val[i];
+    }
+    fold(&a->out[(lo - a->t0) / a->bucket_secs], n, vmin, vmax, sum);
+    return true;
+  }
+
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    if (b->ts[i] < a->t0)
+      continue;
+    uint32_t k = (b->ts[i] - a->t0) / a->bucket_secs;
+    if (k < a->nbuckets)
+      fold(&a->out[k], 1, b->val[i], b->val[i], b->val[i]);
+  }
+  return true;
+}
+
+static bool agg_summary(pc_exec_op_t *op, const pc_block_summary_t *sum, uint32_t count,
+                        uint16_t metric_id, uint16_t series_id)
+{
+  pc_exec_agg_t *a = (pc_exec_agg_t *)op;
+  if (sum->ts_min < a->t0)
+    return false;
+  uint32_t k = (sum->ts_min - a->t0) / a->bucket_secs;
+  if (k != (sum->ts_max - a->t0) / a->bucket_secs || k >= a->nbuckets)
+    return false;
+  fold(&a->out[k], count, sum->v_min, sum->v_max, sum->v_sum);
+  return true;
+}
+
+void pc_exec_agg_init(pc_exec_agg_t *a, uint32_t t0, uint32_t bucket_secs, pc_bucket_t *out, uint32_t nbuckets)
+{
+  a->op.push = agg_push;
+  a->op.push_summary = agg_summary;
+  a->op.next = NULL;
+  a->t0 = t0;
+  a->bucket_secs = bucket_secs ? bucket_secs : 1u;
+  a->out = out;
+  a->nbuckets = nbuckets;
+  memset(out, 0, (size_t)nbuckets * sizeof(*out));
+}
+
+void pc_exec_agg_finish(pc_exec_agg_t *a, uint32_t agg_mask)
+{
+  for (uint32_t k = 0; k < a->nbuckets; ++k)
+  {
+    pc_bucket_t *o = &a->out[k];
+    o->avg = o->count ? (float)(o->sum / o->count) : 0.0f;
+    if (!(agg_mask & PC_AGG_MIN))
+      o->min = 0.0f;
+    if (!(agg_mask & PC_AGG_MAX))
+      o->max = 0.0f;
+    if (!(agg_mask & PC_AGG_SUM))
+      o->sum = 0.0;
+    if (!(agg_mask & PC_AGG_AVG))
+      o->avg = 0.0f;
+  }
+}
+
+// ---- Projection to a callback ----
+
+static bool project_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  pc_exec_project_t *p = (pc_exec_project_t *)op;
+  uint32_t first = 0, n = b->n;
+  if (p->skip)
+  {
+    first = p->skip < n ? (uint32_t)p->skip : n;
+    p->skip -= first;
+    n -= first;
+  }
+  if (n == 0)
+    return true;
+  if (n > p->left)
+    n = (uint32_t)p->left;
+  p->left -= n;
+  if (!p->cb(p->ctx, b->ts + first, b->val + first, n, b->metric_id, b->series_id))
+    return false;
+  return p->left > 0;
+}
+
+void pc_exec_project_init(pc_exec_project_t *p, pc_exec_cb_t cb, void *ctx, uint64_t offset, uint64_t limit)
+{
+  p->op.push = project_push;
+  p->op.push_summary = NULL;
+  p->op.next = NULL;
+  p->cb = cb;
+  p->ctx = ctx;
+  p->skip = offset;
+  p->left = limit ? limit : UINT64_MAX;
+}
+
+// ---- Derivative ----
+
+static bool deriv_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  pc_exec_deriv_t *d = (pc_exec_deriv_t *)op;
+  if (d->have_prev && (d->metric_id != b->metric_id || d->series_id != b->series_id))
+    d->have_prev = false;
+  d->metric_id = b->metric_id;
+  d->series_id = b->series_id;
+
+  uint32_t i = 0, k = 0;
+  if (!d->have_prev && b->n)
+  {
+    d->prev_ts = b->ts[0];
+    d->prev_val = b->val[0];
+    d->have_prev = true;
+    i = 1;
+  }
+  // Output k never passes input i, so the batch is rewritten in place.
+  for (; i < b->n; ++i)
+  {
+    uint32_t t = b->ts[i];
+    float v = b->val[i];
+    if (t <= d->prev_ts)
+      continue;
+    double delta = (double)v - (double)d->prev_val;
+    if ((d->flags & PC_DERIVE_COUNTER) && v < d->prev_val)
+      delta = v;
+    if (d->flags & PC_DERIVE_RATE)
+      delta /= (double)(t - d->prev_ts);
+    b->ts[k] = t;
+    b->val[k] = (float)delta;
+    k++;
+    d->prev_ts = t;
+    d->prev_val = v;
+  }
+  b->n = k;
+  return k == 0 || op->next->push(op->next, b);
+}
+
+void pc_exec_deriv_init(pc_exec_deriv_t *d, uint32_t flags, pc_exec_op_t *next)
+{
+  memset(d, 0, sizeof(*d));
+  d->op.push = deriv_push;
+  d->op.push_summary = NULL; // needs every point
+  d->op.next = next;
+  d->flags = flags;
+}
+
+// ---- Buffer sink ----
+
+static bool buf_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  pc_exec_buf_t *o = (pc_exec_buf_t *)op;
+  uint32_t n = b->n;
+  if (n > o->cap - o->count)
+    n = o->cap - o->count;
+  memcpy(o->ts + o->count, b->ts, (size_t)n * sizeof(*o->ts));
+  memcpy(o->val + o->count, b->val, (size_t)n * sizeof(*o->val));
+  o->count += n;
+  o->total += b->n;
+  return true;
+}
+
+void pc_exec_buf_init(pc_exec_buf_t *b, uint32_t *ts, float *val, uint32_t cap)
+{
+  b->op.push = buf_push;
+  b->op.push_summary = NULL;
+  b->op.next = NULL;
+  b->ts = ts;
+  b->val = val;
+  b->cap = cap;
+  b->count = 0;
+  b->total = 0;
+}
+
+// ---- Grid alignment ----
+
+static bool align_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  pc_exec_align_t *a = (pc_exec_align_t *)op;
+  size_t c = a->last_key;
+  if (a->keys[c].metric_id != b->metric_id || a->keys[c].series_id != b->series_id)
+  {
+    for (c = 0; c < a->nkeys; ++c)
+      if (a->keys[c].metric_id == b->metric_id && a->keys[c].series_id == b->series_id)
+        break;
+    if (c == a->nkeys)
+      return true;
+    a->last_key = c;
+  }
+
+  pc_align_slot_t *col = a->slots + c * a->nrows;
+  for (uint32_t i = 0; i < b->n; ++i)
+  {
+    uint32_t t = b->ts[i];
+    if (t < a->t0)
+      continue;
+    uint32_t k = (t - a->t0) / a->step;
+    if (k >= a->nrows)
+      continue;
+    pc_align_slot_t *s = &col[k];
+    // On equal timestamps the later-written sample wins.
+    if (s->count == 0 || t <= s->first_ts)
+    {
+      s->first_ts = t;
+      s->first_val = b->val[i];
+    }
+    if (s->count == 0 || t >= s->last_ts)
+    {
+      s->last_ts = t;
+      s->last_val = b->val[i];
+    }
+    s->count++;
+  }
+  return true;
+}
+
+pc_result_t pc_exec_align_init(pc_exec_align_t *a, const pc_series_t *keys, size_t nkeys,
+                               uint32_t t0, uint32_t step, uint32_t nrows)
+{
+  if (!a || !keys || nkeys == 0 || step == 0 || nrows == 0)
+    return PC_EINVAL;
+  if ((size_t)nrows > SIZE_MAX / sizeof(pc_align_slot_t) / nkeys)
+    return PC_NO_SPACE;
+  a->slots = (pc_align_slot_t *)calloc(nkeys * nrows, sizeof(*a->slots));
+  if (!a->slots)
+    return PC_NO_SPACE;
+  a->op.push = align_push;
+  a->op.push_summary = NULL;
+  a->op.next = NULL;
+  a->keys = keys;
+  a->nkeys = nkeys;
+  a->t0 = t0;
+  a->step = step;
+  a->nrows = nrows;
+  a->last_key = 0;
+  return PC_OK;
+}
+
+void pc_exec_align_finish(const pc_exec_align_t *a, pc_fill_t fill, float *out)
+{
+  for (size_t c = 0; c < a->nkeys; ++c)
+  {
+    const pc_align_slot_t *col = a->slots + c * a->nrows;
+    bool have_prev = false; // latest sample before the current grid time
+    uint32_t prev_ts = 0;
+    float prev_val = 0.0f;
+    uint32_t nx = 0; // first non-empty slot >= k
+    for (uint32_t k = 0; k < a->nrows; ++k)
+    {
+      const uint32_t g = a->t0 + k * a->step;
+      const pc_align_slot_t *s = &col[k];
+      float v = NAN;
+      if (s->count && s->first_ts == g)
+        v = s->first_val;
+      else if (fill == PC_FILL_LOCF)
+        v = have_prev ? prev_val : NAN;
+      else if (have_prev)
+      {
+        if (nx < k)
+          nx = k;
+        while (nx < a->nrows && col[nx].count == 0)
+          nx++;
+        if (nx < a->nrows)
+        {
+          const pc_align_slot_t *n = &col[nx];
+          double w = (double)(g - prev_ts) / (double)(n->first_ts - prev_ts);
+          v = (float)(prev_val + (n->first_val - prev_val) * w);
+        }
+      }
+      out[(size_t)k * a->nkeys + c] = v;
+      if (s->count)
+      {
+        have_prev = true;
+        prev_ts = s->last_ts;
+        prev_val = s->last_val;
+      }
+    }
+  }
+}
+
+void pc_exec_align_free(pc_exec_align_t *a)
+{
+  if (!a)
+    return;
+  free(a->slots);
+  a->slots = NULL;
+}
+
+// ---- Source ----
+
+void pc_exec_src_init(pc_exec_src_t *s, const pc_exec_spec_t *spec, pc_exec_op_t *root)
+{
+  s->spec = *spec;
+  s->root = root;
+  s->stopped = false;
+  s->status = PC_OK;
+  s->batch.n = 0;
+}
+
+bool pc_exec_src_match(const pc_exec_src_t *s, uint16_t metric_id, uint16_t series_id)
+{
+  if (s->spec.keys)
+  {
+    for (size_t i = 0; i < s->spec.nkeys; ++i)
+      if (s->spec.keys[i].metric_id == metric_id && s->spec.keys[i].series_id == series_id)
+        return true;
+    return false;
+  }
+  if (s->spec.metric_id != PC_METRIC_ANY && s->spec.metric_id != metric_id)
+    return false;
+  if (s->spec.series_set)
+    return pc_series_set_has(s->spec.series_set, series_id);
+  return s->spec.series_id == PC_SERIES_ANY || s->spec.series_id == series_id;
+}
+
+void pc_exec_src_finish(pc_exec_src_t *s)
+{
+  if (s->batch.n && !s->stopped && !s->root->push(s->root, &s->batch))
+    s->stopped = true;
+  s->batch.n = 0;
+}
+
+// Start (or continue) a batch for (metric, series).
+static void retarget(pc_exec_src_t *s, uint16_t metric_id, uint16_t series_id)
+{
+  if (s->batch.n && (s->batch.metric_id != metric_id || s->batch.series_id != series_id))
+    pc_exec_src_finish(s);
+  s->batch.metric_id = metric_id;
+  s->batch.series_id = series_id;
+}
+
+void pc_exec_src_point(pc_exec_src_t *s, uint16_t metric_id, uint16_t series_id, uint32_t ts, float val)
+{
+  if (s->stopped)
+    return;
+  retarget(s, metric_id, series_id);
+  s->batch.ts[s->batch.n] = ts;
+  s->batch.val[s->batch.n] = val;
+  if (++s->batch.n == PC_EXEC_BATCH)
+    pc_exec_src_finish(s);
+}
+
+void pc_exec_run_blocks(pc_exec_src_t *s, pc_scan_t *sc)
+{
+  for (size_t b = 0; b < sc->nblocks && !s->stopped; ++b)
+  {
+    const pc_blockdir_ent_t *e = &sc->dir[b];
+    if (!pc_exec_src_match(s, e->hdr.metric_id, e->hdr.series_id))
+      continue;
+    if (e->flags & PC_BLOCK_F_SUMMARY)
+    {
+      if (e->sum.ts_max < s->spec.t0 || e->sum.ts_min > s->spec.t1)
+        continue;
+      if (s->root->push_summary &&
+          s->root->push_summary(s->root, &e->sum, e->hdr.point_count, e->hdr.metric_id, e->hdr.series_id))
+        continue;
+    }
+    const pc_point_disk_t *pts = NULL;
+    pc_result_t st = pc_scan_block_points(sc, b, &pts);
+    if (st != PC_OK)
+    {
+      if (s->status == PC_OK)
+        s->status = st;
+      return;
+    }
+
+    retarget(s, e->hdr.metric_id, e->hdr.series_id);
+    // Row → column decode, one batch-sized chunk at a time.
+    for (uint32_t p = 0; p < e->hdr.point_count && !s->stopped;)
+    {
+      pc_batch_t *bt = &s->batch;
+      uint32_t take = e->hdr.point_count - p;
+      if (take > PC_EXEC_BATCH - bt->n)
+        take = PC_EXEC_BATCH - bt->n;
+      for (uint32_t i = 0; i < take; ++i)
+      {
+        bt->ts[bt->n + i] = pts[p + i].ts;
+        bt->val[bt->n + i] = pts[p + i].value;
+      }
+      bt->n += take;
+      p += take;
+      if (bt->n == PC_EXEC_BATCH)
+        pc_exec_src_finish(s);
+    }
+  }
+}
+
+void pc_exec_run_catalog(pc_exec_src_t *s, pc_scan_t *sc, const pc_catalog_t *cat)
+{
+  for (size_t i = 0; i < cat->count && !s->stopped; ++i)
+  {
+    const pc_seg_summary_t *seg = &cat->segs[i];
+    if (seg->ts_max < s->spec.t0 || seg->ts_min > s->spec.t1)
+      continue;
+    // A segment that fails to decode is skipped, like a corrupt one at mount;
+    // callers that must not lose points silently check s->status.
+    pc_result_t st = pc_scan_load_seg(sc, seg);
+    if (st == PC_OK)
+      pc_exec_run_blocks(s, sc);
+    else if (s->status == PC_OK)
+      s->status = st;
+  }
+}
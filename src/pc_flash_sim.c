@@ -98,6 +98,18 @@ pc_result_t pc_flash_read(const pc_flash_t *f, size_t addr, void *out, size_t le
   return PC_OK;
 }
 
+pc_result_t pc_flash_map(const pc_flash_t *f, size_t addr, size_t len, const void **out)
+{
+  if (!f || !out)
+    return PC_EINVAL;
+  if (!range_in_one_piece(f, addr, len))
+    return PC_EINVAL;
+  if (range_hits_bad(f, addr, len))
+    return PC_FLASH_IO;
+  *out = f->mem + addr;
+  return PC_OK;
+}
+
 pc_result_t pc_flash_program(pc_flash_t *f, size_t addr, const void *data, size_t len)
 {
   if (!f || !data)
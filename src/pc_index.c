@@ -0,0 +1,503 @@
+#include "pc_index.h"
+#include "pc_appender.h"
+#include "pc_recover.h"
+#include <stdlib.h>
+#include <string.h>
+
+// ---- Blob ----
+
+void pc_index_blob_init(pc_index_blob_t *b)
+{
+  if (!b)
+    return;
+  b->data = NULL;
+  b->len = 0;
+  b->cap = 0;
+}
+
+void pc_index_blob_free(pc_index_blob_t *b)
+{
+  if (!b)
+    return;
+  free(b->data);
+  pc_index_blob_init(b);
+}
+
+static bool blob_reserve(pc_index_blob_t *b, size_t extra)
+{
+  if (b->len + extra <= b->cap)
+    return true;
+  size_t cap = b->cap ? b->cap : 256;
+  while (cap < b->len + extra)
+    cap *= 2;
+  uint8_t *p = (uint8_t *)realloc(b->data, cap);
+  if (!p)
+    return false;
+  b->data = p;
+  b->cap = cap;
+  return true;
+}
+
+uint8_t *pc_index_blob_section(pc_index_blob_t *b, uint16_t kind, size_t bytes)
+{
+  if (!b || bytes > UINT32_MAX)
+    return NULL;
+  if (!blob_reserve(b, sizeof(pc_index_sec_hdr_t) + bytes))
+    return NULL;
+  pc_index_sec_hdr_t sh;
+  sh.kind = kind;
+  sh.flags = 0;
+  sh.bytes = (uint32_t)bytes;
+  memcpy(b->data + b->len, &sh, sizeof(sh));
+  uint8_t *body = b->data + b->len + sizeof(sh);
+  b->len += sizeof(sh) + bytes;
+  return body;
+}
+
+pc_result_t pc_index_blob_find(const pc_index_blob_t *b, uint16_t kind,
+                               const uint8_t **out_body, size_t *out_bytes)
+{
+  if (!b || !out_body || !out_bytes)
+    return PC_EINVAL;
+  size_t off = 0;
+  while (off < b->len)
+  {
+    pc_index_sec_hdr_t sh;
+    if (off + sizeof(sh) > b->len)
+      return PC_CORRUPT;
+    memcpy(&sh, b->data + off, sizeof(sh));
+    off += sizeof(sh);
+    if (sh.bytes > b->len - off)
+      return PC_CORRUPT;
+    if (sh.kind == kind)
+    {
+      *out_body = b->data + off;
+      *out_bytes = sh.bytes;
+      return PC_OK;
+    }
+    off += sh.bytes;
+  }
+  return PC_METRIC_UNKNOWN;
+}
+
+pc_result_t pc_index_put_catalog(pc_index_blob_t *b, const pc_catalog_t *c)
+{
+  if (!b || !c)
+    return PC_EINVAL;
+  uint8_t *body = pc_index_blob_section(b, PC_INDEX_SEC_CATALOG, c->count * sizeof(pc_index_seg_rec_t));
+  if (!body)
+    return PC_NO_SPACE;
+  for (size_t i = 0; i < c->count; ++i)
+  {
+    pc_index_seg_rec_t r;
+    r.base = (uint32_t)c->segs[i].base;
+    r.seqno = c->segs[i].seqno;
+    r.ts_min = c->segs[i].ts_min;
+    r.ts_max = c->segs[i].ts_max;
+    r.record_count = c->segs[i].record_count;
+    r.type = c->segs[i].type;
+    r.reserved = 0;
+    memcpy(body + i * sizeof(r), &r, sizeof(r));
+  }
+  return PC_OK;
+}
+
+// ---- Live snapshot bookkeeping ----
+
+void pc_index_init(pc_index_t *ix)
+{
+  if (!ix)
+    return;
+  ix->bases = NULL;
+  ix->nparts = 0;
+  ix->snap_seq = 0;
+  ix->covered_seq = 0;
+}
+
+void pc_index_free(pc_index_t *ix)
+{
+  if (!ix)
+    return;
+  free(ix->bases);
+  pc_index_init(ix);
+}
+
+static void erase_parts(pc_flash_t *f, pc_alloc_t *a, const size_t *bases, size_t n)
+{
+  for (size_t i = 0; i < n; ++i)
+    pc_alloc_release(a, bases[i], pc_logseg_erase(f, bases[i]) == PC_OK);
+}
+
+pc_result_t pc_index_write(pc_index_t *ix, pc_flash_t *f, pc_alloc_t *a,
+                           const pc_index_blob_t *blob,
+                           uint32_t covered_seq, uint32_t *next_seq)
+{
+  if (!ix || !f || !a || !blob || !next_seq)
+    return PC_EINVAL;
+
+  const size_t room = pc_logseg_preheader_bytes(f) - sizeof(pc_index_part_hdr_t);
+  size_t nparts = (blob->len + room - 1) / room;
+  if (nparts == 0)
+    nparts = 1;
+  if (nparts > UINT16_MAX)
+    return PC_NO_SPACE;
+
+  size_t *bases = (size_t *)calloc(nparts, sizeof(size_t));
+  if (!bases)
+    return PC_NO_SPACE;
+
+  const uint32_t snap_seq = *next_seq;
+  pc_result_t st = PC_OK;
+  size_t done = 0;
+  for (; done < nparts; ++done)
+  {
+    bool erased = false;
+    st = pc_alloc_acquire_ex(a, a->policy, &bases[done], &erased);
+    if (st != PC_OK)
+      break;
+
+    pc_appender_t app;
+    st = erased ? pc_appender_open_erased(&app, f, bases[done], (*next_seq)++)
+                : pc_appender_open(&app, f, bases[done], (*next_seq)++);
+    if (st != PC_OK)
+    {
+      done++; // sector was erased; nothing else to undo
+      break;
+    }
+
+    size_t off = done * room;
+    size_t chunk = blob->len - off < room ? blob->len - off : room;
+    pc_index_part_hdr_t ph;
+    ph.magic = PC_INDEX_MAGIC;
+    ph.version = PC_INDEX_VERSION;
+    ph.part = (uint16_t)done;
+    ph.nparts = (uint16_t)nparts;
+    ph.reserved = 0xFFFFu;
+    ph.snap_seq = snap_seq;
+    ph.covered_seq = covered_seq;
+    ph.blob_bytes = (uint32_t)blob->len;
+    ph.part_bytes = (uint32_t)chunk;
+
+    st = pc_appender_append_bytes(&app, &ph, sizeof(ph));
+    if (st == PC_OK && chunk)
+      st = pc_appender_append_bytes(&app, blob->data + off, chunk);
+    if (st == PC_OK)
+      st = pc_appender_commit(&app, PC_SEG_INDEX);
+    if (st == PC_OK)
+      pc_alloc_commit(a, bases[done]);
+    if (st != PC_OK)
+    {
+      done++;
+      break;
+    }
+  }
+
+  if (st != PC_OK)
+  {
+    erase_parts(f, a, bases, done);
+    free(bases);
+    return st;
+  }
+
+  // New snapshot is durable; the previous one can go. Mount ignores superseded
+  // parts, so with an erased pool their erase is left to the refill step.
+  if (a->pool_target)
+    for (size_t i = 0; i < ix->nparts; ++i)
+      pc_alloc_release(a, ix->bases[i], false);
+  else
+    erase_parts(f, a, ix->bases, ix->nparts);
+  free(ix->bases);
+  ix->bases = bases;
+  ix->nparts = nparts;
+  ix->snap_seq = snap_seq;
+  ix->covered_seq = covered_seq;
+  return PC_OK;
+}
+
+// ---- Mount ----
+
+typedef struct
+{
+  size_t base;
+  pc_index_part_hdr_t ph;
+} part_ref_t;
+
+// Newest snapshot first, parts in order.
+static int cmp_part(const void *a, const void *b)
+{
+  const part_ref_t *x = (const part_ref_t *)a;
+  const part_ref_t *y = (const part_ref_t *)b;
+  if (x->ph.snap_seq != y->ph.snap_seq)
+    return x->ph.snap_seq > y->ph.snap_seq ? -1 : 1;
+  if (x->ph.part != y->ph.part)
+    return x->ph.part < y->ph.part ? -1 : 1;
+  return 0;
+}
+
+// Try to load parts[0..n) as one snapshot into 'blob'.
+static bool load_snapshot(const pc_flash_t *f, const part_ref_t *parts, size_t n,
+                          pc_index_blob_t *blob, pc_mount_stats_t *stats)
+{
+  const pc_index_part_hdr_t *p0 = &parts[0].ph;
+  if (p0->nparts != n)
+    return false;
+
+  blob->len = 0;
+  if (!blob_reserve(blob, p0->blob_bytes))
+    return false;
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    const pc_index_part_hdr_t *ph = &parts[i].ph;
+    if (ph->part != i || ph->blob_bytes != p0->blob_bytes || ph->covered_seq != p0->covered_seq)
+      return false;
+    if (blob->len + ph->part_bytes > p0->blob_bytes)
+      return false;
+    if (pc_logseg_verify(f, parts[i].base, NULL) != PC_OK)
+      return false;
+    if (stats)
+      stats->segments_verified++;
+    if (pc_flash_read(f, parts[i].base + sizeof(*ph), blob->data + blob->len, ph->part_bytes) != PC_OK)
+      return false;
+    blob->len += ph->part_bytes;
+  }
+  return blob->len == p0->blob_bytes;
+}
+
+static pc_result_t add_summary(pc_catalog_t *cat, size_t base, const pc_segment_hdr_t *h)
+{
+  pc_seg_summary_t s;
+  s.base = base;
+  s.type = h->type;
+  s.seqno = h->seqno;
+  s.ts_min = h->ts_min;
+  s.ts_max = h->ts_max;
+  s.record_count = h->record_count;
+  return pc_catalog_add(cat, &s);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+  const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Same commit header content (a byte-for-byte copy of the same segment)
+static bool same_segment(const pc_segment_hdr_t *a, const pc_segment_hdr_t *b)
+{
+  return a->type == b->type && a->seqno == b->seqno && a->ts_min == b->ts_min && a->ts_max == b->ts_max &&
+         a->record_count == b->record_count && a->crc32c == b->crc32c;
+}
+
+pc_result_t pc_index_mount(pc_index_t *ix, pc_flash_t *f, pc_catalog_t *cat,
+                           pc_index_blob_t *blob, pc_mount_stats_t *stats)
+{
+  return pc_index_mount_ex(ix, f, cat, blob, stats, NULL);
+}
+
+pc_result_t pc_index_mount_ex(pc_index_t *ix, pc_flash_t *f, pc_catalog_t *cat,
+                              pc_index_blob_t *blob, pc_mount_stats_t *stats,
+                              pc_mount_opts_t *opts)
+{
+  if (!ix || !f || !cat || !blob)
+    return PC_EINVAL;
+
+  pc_mount_stats_t local;
+  if (!stats)
+    stats = &local;
+  memset(stats, 0, sizeof(*stats));
+
+  const size_t seg = pc_flash_sector_bytes(f);
+  const size_t count = pc_flash_sector_count(f);
+  pc_segment_hdr_t *hdrs = (pc_segment_hdr_t *)malloc(count * sizeof(*hdrs));
+  uint8_t *states = (uint8_t *)malloc(count);
+  part_ref_t *parts = (part_ref_t *)malloc(count * sizeof(*parts));
+  if (!hdrs || !states || !parts)
+  {
+    free(hdrs);
+    free(states);
+    free(parts);
+    return PC_NO_SPACE;
+  }
+
+  uint64_t *unverified = opts ? opts->unverified : NULL;
+  const unsigned threads = opts ? opts->threads : 1;
+  uint8_t *verdict = NULL; // pass 3 CRC results when they are computed up front
+  uint32_t *moved = NULL; // snapshot seqnos no longer at their sector (ascending)
+  size_t nmoved = 0;
+  pc_result_t st = opts && opts->epoch
+                       ? pc_epoch_read_headers(f, opts->epoch, opts->epoch_live, hdrs, states, &opts->epoch_end, NULL)
+                       : pc_recover_read_headers_mt(f, hdrs, states, threads);
+  if (st != PC_OK)
+    goto out;
+
+  // Pass 1: collect INDEX part headers.
+  size_t nparts = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (states[i] == PC_SECT_BAD || states[i] == PC_SECT_UNKNOWN)
+      continue;
+    stats->headers_read++;
+    if (states[i] == PC_SECT_COMMITTED && hdrs[i].seqno >= stats->max_seqno)
+    {
+      stats->max_seqno = hdrs[i].seqno;
+      stats->newest_sector = i;
+    }
+    if (states[i] != PC_SECT_COMMITTED || hdrs[i].type != PC_SEG_INDEX)
+      continue;
+    part_ref_t *r = &parts[nparts];
+    r->base = i * seg;
+    if (pc_flash_read(f, r->base, &r->ph, sizeof(r->ph)) != PC_OK)
+      continue;
+    if (r->ph.magic != PC_INDEX_MAGIC || r->ph.version != PC_INDEX_VERSION)
+      continue;
+    nparts++;
+  }
+  qsort(parts, nparts, sizeof(*parts), cmp_part);
+
+  // Pass 2: newest snapshot whose parts are all present and valid.
+  pc_index_free(ix);
+  pc_catalog_clear(cat);
+  blob->len = 0;
+  size_t chosen = nparts; // index of first part of chosen snapshot
+  for (size_t i = 0; i < nparts;)
+  {
+    size_t j = i;
+    while (j < nparts && parts[j].ph.snap_seq == parts[i].ph.snap_seq)
+      j++;
+    if (load_snapshot(f, &parts[i], j - i, blob, stats))
+    {
+      chosen = i;
+      break;
+    }
+    i = j;
+  }
+
+  if (chosen < nparts)
+  {
+    const pc_index_part_hdr_t *p0 = &parts[chosen].ph;
+    ix->bases = (size_t *)calloc(p0->nparts, sizeof(size_t));
+    if (!ix->bases)
+    {
+      st = PC_NO_SPACE;
+      goto out;
+    }
+    for (size_t k = 0; k < p0->nparts; ++k)
+      ix->bases[k] = parts[chosen + k].base;
+    ix->nparts = p0->nparts;
+    ix->snap_seq = p0->snap_seq;
+    ix->covered_seq = p0->covered_seq;
+    stats->used_index = true;
+    stats->covered_seq = p0->covered_seq;
+
+    // Trust snapshot entries whose sector still carries the same segment.
+    const uint8_t *body = NULL;
+    size_t bytes = 0;
+    if (pc_index_blob_find(blob, PC_INDEX_SEC_CATALOG, &body, &bytes) == PC_OK)
+    {
+      moved = (uint32_t *)malloc((bytes / sizeof(pc_index_seg_rec_t) + 1) * sizeof(uint32_t));
+      if (!moved)
+      {
+        st = PC_NO_SPACE;
+        goto out;
+      }
+      for (size_t off = 0; off + sizeof(pc_index_seg_rec_t) <= bytes; off += sizeof(pc_index_seg_rec_t))
+      {
+        pc_index_seg_rec_t r;
+        memcpy(&r, body + off, sizeof(r));
+        size_t idx = r.base / seg;
+        if (r.base % seg != 0 || idx >= count)
+          continue;
+        if (states[idx] != PC_SECT_COMMITTED || hdrs[idx].seqno != r.seqno || hdrs[idx].type != r.type)
+        {
+          // Reclaimed, or relocated by wear leveling (looked for in pass 3)
+          if (states[idx] != PC_SECT_UNKNOWN)
+            moved[nmoved++] = r.seqno;
+          continue;
+        }
+        st = add_summary(cat, r.base, &hdrs[idx]);
+        if (st != PC_OK)
+          goto out;
+        stats->segments_trusted++;
+      }
+    }
+  }
+  else
+  {
+    blob->len = 0;
+  }
+
+  // Pass 3: verify DATA segments newer than the watermark (the header from pass
+  // 1 is reused, so only the pre-header is read) or defer them. With several
+  // threads the CRC checks run first, split across them.
+  if (!unverified && threads > 1)
+  {
+    verdict = (uint8_t *)calloc(count, 1);
+    if (!verdict)
+    {
+      st = PC_NO_SPACE;
+      goto out;
+    }
+    for (size_t i = 0; i < count; ++i)
+      verdict[i] = states[i] == PC_SECT_COMMITTED && hdrs[i].type == PC_SEG_DATA &&
+                   !(stats->used_index && hdrs[i].seqno <= ix->covered_seq &&
+                     !bsearch(&hdrs[i].seqno, moved, nmoved, sizeof(uint32_t), cmp_u32));
+    st = pc_recover_verify_sectors(f, hdrs, verdict, threads);
+    if (st != PC_OK)
+      goto out;
+  }
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (states[i] != PC_SECT_COMMITTED || hdrs[i].type != PC_SEG_DATA)
+      continue;
+    // Second copy of a catalogued segment: a relocation interrupted before it
+    // erased the source. Reclaimed unless its twin is not CRC-checked yet.
+    const pc_seg_summary_t *twin = pc_catalog_find_seq(cat, hdrs[i].seqno);
+    if (twin && twin->base != i * seg && same_segment(&hdrs[twin->base / seg], &hdrs[i]))
+    {
+      if (!unverified && pc_logseg_erase(f, i * seg) == PC_OK)
+        states[i] = PC_SECT_FREE;
+      continue;
+    }
+    if (stats->used_index && hdrs[i].seqno <= ix->covered_seq &&
+        !bsearch(&hdrs[i].seqno, moved, nmoved, sizeof(uint32_t), cmp_u32))
+      continue;
+    if (unverified)
+    {
+      unverified[i / 64] |= 1ull << (i % 64);
+      stats->segments_deferred++;
+    }
+    else
+    {
+      stats->segments_verified++;
+      if (verdict ? !verdict[i] : pc_logseg_verify_crc(f, i * seg, &hdrs[i]) != PC_OK)
+        continue;
+    }
+    st = add_summary(cat, i * seg, &hdrs[i]);
+    if (st != PC_OK)
+      goto out;
+  }
+
+  // Stale INDEX parts (superseded or from an interrupted write) are reclaimed.
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (states[i] != PC_SECT_COMMITTED || hdrs[i].type != PC_SEG_INDEX)
+      continue;
+    bool live = false;
+    for (size_t k = 0; k < ix->nparts; ++k)
+      live = live || ix->bases[k] == i * seg;
+    if (!live && pc_logseg_erase(f, i * seg) == PC_OK)
+      states[i] = PC_SECT_FREE;
+  }
+  if (opts && opts->states)
+    memcpy(opts->states, states, count);
+  st = PC_OK;
+
+out:
+  free(hdrs);
+  free(states);
+  free(parts);
+  free(moved);
+  free(verdict);
+  return st;
+}
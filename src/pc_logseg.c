@@ -66,6 +66,19 @@ pc_result_t pc_logseg_crc32c_region(const pc_flash_t *f, size_t base, uint32_t *
 pc_result_t pc_logseg_commit(pc_flash_t *f, size_t base,
                              uint16_t type, uint32_t seqno,
                              uint32_t ts_min, uint32_t ts_max, uint32_t record_count)
+{
+  // Compute CRC across the entire pre-header region as currently on flash.
+  uint32_t crc = 0;
+  pc_result_t st = pc_logseg_crc32c_region(f, base, &crc);
+  if (st != PC_OK)
+    return st;
+  return pc_logseg_commit_with_crc(f, base, type, seqno, ts_min, ts_max, record_count, crc);
+}
+
+pc_result_t pc_logseg_commit_with_crc(pc_flash_t *f, size_t base,
+                                      uint16_t type, uint32_t seqno,
+                                      uint32_t ts_min, uint32_t ts_max, uint32_t record_count,
+                                      uint32_t crc)
 {
   if (!f)
     return PC_EINVAL;
@@ -75,12 +88,6 @@ pc_result_t pc_logseg_commit(pc_flash_t *f, size_t base,
   if (!is_aligned(base, seg))
     return PC_EINVAL;
 
-  // Compute CRC across the entire pre-header region as currently on flash.
-  uint32_t crc = 0;
-  pc_result_t st = pc_logseg_crc32c_region(f, base, &crc);
-  if (st != PC_OK)
-    return st;
-
   // Build header.
   pc_segment_hdr_t hdr;
   hdr.magic = PC_SEG_MAGIC;
@@ -94,7 +101,7 @@ pc_result_t pc_logseg_commit(pc_flash_t *f, size_t base,
 
   // Write header into the last program page.
   // We program a full page (prog bytes), header at the start, rest 0xFF.
-  uint8_t page[512]; // assume prog <= 512; we checked in crc helper similarly
+  uint8_t page[512]; // assume prog <= 512
   if (prog > sizeof(page))
     return PC_EINVAL;
   memset(page, 0xFF, prog);
@@ -131,9 +138,10 @@ bool pc_logseg_header_erased(const pc_flash_t *f, size_t base)
   return true;
 }
 
-pc_result_t pc_logseg_verify(const pc_flash_t *f, size_t base, pc_segment_hdr_t *out_hdr)
+pc_result_t pc_logseg_read_header(const pc_flash_t *f, size_t base,
+                                  pc_segment_hdr_t *out_hdr, bool *out_erased)
 {
-  if (!f)
+  if (!f || !out_erased)
     return PC_EINVAL;
   const size_t seg = pc_logseg_segment_bytes(f);
   const size_t prog = pc_logseg_commit_page_bytes(f);
@@ -144,44 +152,57 @@ pc_result_t pc_logseg_verify(const pc_flash_t *f, size_t base, pc_segment_hdr_t
   uint8_t page[512];
   if (prog > sizeof(page))
     return PC_EINVAL;
-
   pc_result_t st = pc_flash_read(f, base + preH, page, prog);
   if (st != PC_OK)
     return st;
 
-  // If the page is still fully erased, there's no header -> treat as corrupt/uncommitted.
-  bool all_ff = true;
+  *out_erased = true;
   for (size_t i = 0; i < prog; ++i)
   {
     if (page[i] != 0xFF)
     {
-      all_ff = false;
+      *out_erased = false;
       break;
     }
   }
-  if (all_ff)
-    return PC_CORRUPT;
+  if (*out_erased)
+    return PC_OK;
 
-  // Unpack header
-  pc_segment_hdr_t hdr = {0};
+  pc_segment_hdr_t hdr;
   memcpy(&hdr, page, sizeof(hdr));
-
   if (hdr.magic != PC_SEG_MAGIC || hdr.version != PC_SEG_VERSION)
-  {
     return PC_CORRUPT;
-  }
+  if (out_hdr)
+    *out_hdr = hdr;
+  return PC_OK;
+}
 
-  // Recompute CRC over pre-header region and compare
+pc_result_t pc_logseg_verify_crc(const pc_flash_t *f, size_t base, const pc_segment_hdr_t *hdr)
+{
+  if (!f || !hdr)
+    return PC_EINVAL;
   uint32_t crc = 0;
-  st = pc_logseg_crc32c_region(f, base, &crc);
+  pc_result_t st = pc_logseg_crc32c_region(f, base, &crc);
   if (st != PC_OK)
     return st;
+  return crc == hdr->crc32c ? PC_OK : PC_CORRUPT;
+}
 
-  if (crc != hdr.crc32c)
-  {
+pc_result_t pc_logseg_verify(const pc_flash_t *f, size_t base, pc_segment_hdr_t *out_hdr)
+{
+  // One commit-page read for the header, then the pre-header for the CRC.
+  pc_segment_hdr_t hdr;
+  bool erased = false;
+  pc_result_t st = pc_logseg_read_header(f, base, &hdr, &erased);
+  if (st != PC_OK)
+    return st;
+  // If the page is still fully erased, there's no header -> treat as corrupt/uncommitted.
+  if (erased)
     return PC_CORRUPT;
-  }
 
+  st = pc_logseg_verify_crc(f, base, &hdr);
+  if (st != PC_OK)
+    return st;
   if (out_hdr)
     *out_hdr = hdr;
   return PC_OK;
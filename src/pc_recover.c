@@ -1,7 +1,48 @@
 #include "pc_recover.h"
+#include <stdlib.h>
+#include <string.h>
+#if PC_THREADS
+#include <pthread.h>
+#endif
 
 static bool is_aligned(size_t x, size_t a) { return (a == 0) ? (x == 0) : (x % a) == 0; }
 
+// Verify the segment at 'base' and summarize it. False if it is not a valid one.
+static bool scan_sector(const pc_flash_t *f, size_t base, size_t seg, pc_seg_summary_t *out)
+{
+  if (!is_aligned(base, seg))
+    return false;
+
+  // Skip bad sectors early (treat as unreadable)
+  size_t sector_index = base / seg;
+  if (pc_flash_is_bad(f, sector_index))
+  {
+    return false;
+  }
+
+  // One commit-page read: erased → uncommitted → skip
+  pc_segment_hdr_t hdr;
+  bool erased = false;
+  if (pc_logseg_read_header(f, base, &hdr, &erased) != PC_OK || erased)
+  {
+    return false;
+  }
+
+  // CRC over pre-header region; corrupt or I/O → skip and keep scanning
+  if (pc_logseg_verify_crc(f, base, &hdr) != PC_OK)
+  {
+    return false;
+  }
+
+  out->base = base;
+  out->type = (uint16_t)hdr.type;
+  out->seqno = hdr.seqno;
+  out->ts_min = hdr.ts_min;
+  out->ts_max = hdr.ts_max;
+  out->record_count = hdr.record_count;
+  return true;
+}
+
 pc_result_t pc_recover_scan_all(const pc_flash_t *f,
                                 pc_seg_summary_t *out,
                                 size_t max_out,
@@ -21,45 +62,224 @@ pc_result_t pc_recover_scan_all(const pc_flash_t *f,
 
   for (size_t base = 0; base + seg <= total; base += seg)
   {
-    if (!is_aligned(base, seg))
+    pc_seg_summary_t s;
+    if (!scan_sector(f, base, seg, &s))
       continue;
 
-    // Skip bad sectors early (treat as unreadable)
-    size_t sector_index = base / seg;
-    if (pc_flash_is_bad(f, sector_index))
-    {
-      continue;
-    }
+    // Valid segment: emit summary (if space)
+    if (out && write_idx < max_out)
+      out[write_idx] = s;
+    write_idx++;
+  }
+
+  if (found)
+    *found = (out ? (write_idx > max_out ? max_out : write_idx) : 0);
+  return PC_OK;
+}
+
+// Run work(ctx, first, end) over [0, count) split into nthreads contiguous
+// runs. Run 0 goes on the calling thread; so does any worker that fails to
+// start, and every run in builds without PC_THREADS. Workers must only write
+// per-index slots of their own run.
+typedef void (*split_fn)(void *ctx, size_t first, size_t end);
+
+#if PC_THREADS
+typedef struct
+{
+  split_fn work;
+  void *ctx;
+  size_t first, end;
+} split_part_t;
 
-    // If commit page is erased → uncommitted → skip
-    if (pc_logseg_header_erased(f, base))
+static void *split_main(void *arg)
+{
+  split_part_t *p = (split_part_t *)arg;
+  p->work(p->ctx, p->first, p->end);
+  return NULL;
+}
+#endif
+
+static pc_result_t run_split(unsigned nthreads, size_t count, split_fn work, void *ctx)
+{
+  if (nthreads == 0)
+    nthreads = 1;
+  if (nthreads > count)
+    nthreads = count ? (unsigned)count : 1u;
+#if PC_THREADS
+  if (nthreads > 1)
+  {
+    split_part_t *parts = (split_part_t *)calloc(nthreads, sizeof(*parts));
+    pthread_t *tids = (pthread_t *)calloc(nthreads, sizeof(*tids));
+    bool *started = (bool *)calloc(nthreads, sizeof(bool));
+    if (!parts || !tids || !started)
     {
-      continue;
+      free(parts);
+      free(tids);
+      free(started);
+      return PC_NO_SPACE;
     }
-
-    // Verify header + CRC over pre-header region
-    pc_segment_hdr_t hdr;
-    pc_result_t st = pc_logseg_verify(f, base, &hdr);
-    if (st != PC_OK)
+    for (unsigned t = 0; t < nthreads; ++t)
     {
-      // corrupt or I/O → skip and keep scanning
-      continue;
+      parts[t].work = work;
+      parts[t].ctx = ctx;
+      parts[t].first = count * t / nthreads;
+      parts[t].end = count * (t + 1) / nthreads;
     }
-
-    // Valid segment: emit summary (if space)
-    if (out && write_idx < max_out)
+    for (unsigned t = 1; t < nthreads; ++t)
+      started[t] = pthread_create(&tids[t], NULL, split_main, &parts[t]) == 0;
+    split_main(&parts[0]);
+    for (unsigned t = 1; t < nthreads; ++t)
     {
-      out[write_idx].base = base;
-      out[write_idx].type = (uint16_t)hdr.type;
-      out[write_idx].seqno = hdr.seqno;
-      out[write_idx].ts_min = hdr.ts_min;
-      out[write_idx].ts_max = hdr.ts_max;
-      out[write_idx].record_count = hdr.record_count;
+      if (started[t])
+        pthread_join(tids[t], NULL);
+      else
+        split_main(&parts[t]);
     }
-    write_idx++;
+    free(parts);
+    free(tids);
+    free(started);
+    return PC_OK;
+  }
+#endif
+  work(ctx, 0, count);
+  return PC_OK;
+}
+
+// Parallel scan: sector i leaves its summary in segs[i] when valid[i] is set.
+typedef struct
+{
+  const pc_flash_t *f;
+  size_t seg;
+  pc_seg_summary_t *segs;
+  uint8_t *valid;
+} scan_ctx_t;
+
+static void scan_run(void *arg, size_t first, size_t end)
+{
+  scan_ctx_t *c = (scan_ctx_t *)arg;
+  for (size_t i = first; i < end; ++i)
+    c->valid[i] = scan_sector(c->f, i * c->seg, c->seg, &c->segs[i]);
+}
+
+static int cmp_seqno(const void *a, const void *b)
+{
+  const pc_seg_summary_t *x = (const pc_seg_summary_t *)a;
+  const pc_seg_summary_t *y = (const pc_seg_summary_t *)b;
+  if (x->seqno != y->seqno)
+    return x->seqno < y->seqno ? -1 : 1;
+  return (x->base > y->base) - (x->base < y->base);
+}
+
+pc_result_t pc_recover_scan_all_parallel(const pc_flash_t *f, unsigned nthreads,
+                                         pc_recover_cb_t cb, void *ctx, size_t *found)
+{
+  if (!f)
+    return PC_EINVAL;
+  if (found)
+    *found = 0;
+  const size_t seg = pc_flash_sector_bytes(f);
+  const size_t count = pc_flash_sector_count(f);
+  if (seg == 0 || count == 0)
+    return PC_EINVAL;
+#if !PC_THREADS
+  if (nthreads > 1)
+    return PC_UNSUPPORTED;
+#endif
+
+  // Every worker writes only the slots of its own sectors, so they share
+  // nothing but the (read-only) device.
+  scan_ctx_t sc = {f, seg, (pc_seg_summary_t *)malloc(count * sizeof(pc_seg_summary_t)), (uint8_t *)calloc(count, 1)};
+  pc_result_t st = sc.segs && sc.valid ? run_split(nthreads, count, scan_run, &sc) : PC_NO_SPACE;
+  if (st != PC_OK)
+  {
+    free(sc.segs);
+    free(sc.valid);
+    return st;
   }
 
+  // Compact, then order by seqno.
+  size_t n = 0;
+  for (size_t i = 0; i < count; ++i)
+    if (sc.valid[i])
+      sc.segs[n++] = sc.segs[i];
+  free(sc.valid);
+  qsort(sc.segs, n, sizeof(*sc.segs), cmp_seqno);
+
   if (found)
-    *found = (out ? (write_idx > max_out ? max_out : write_idx) : 0);
+    *found = n;
+  for (size_t i = 0; i < n && cb; ++i)
+    if (!cb(ctx, &sc.segs[i]))
+      break;
+  free(sc.segs);
   return PC_OK;
 }
+
+pc_result_t pc_recover_read_headers(const pc_flash_t *f,
+                                    pc_segment_hdr_t *hdrs,
+                                    uint8_t *states)
+{
+  return pc_recover_read_headers_mt(f, hdrs, states, 1);
+}
+
+typedef struct
+{
+  const pc_flash_t *f;
+  pc_segment_hdr_t *hdrs;
+  uint8_t *states;
+} headers_ctx_t;
+
+static void headers_run(void *arg, size_t first, size_t end)
+{
+  headers_ctx_t *c = (headers_ctx_t *)arg;
+  for (size_t i = first; i < end; ++i)
+    c->states[i] = (uint8_t)pc_recover_sector_state(c->f, i, &c->hdrs[i]);
+}
+
+pc_result_t pc_recover_read_headers_mt(const pc_flash_t *f, pc_segment_hdr_t *hdrs, uint8_t *states,
+                                       unsigned nthreads)
+{
+  if (!f || !hdrs || !states)
+    return PC_EINVAL;
+  if (pc_flash_sector_bytes(f) == 0)
+    return PC_EINVAL;
+  headers_ctx_t c = {f, hdrs, states};
+  return run_split(nthreads, pc_flash_sector_count(f), headers_run, &c);
+}
+
+typedef struct
+{
+  const pc_flash_t *f;
+  const pc_segment_hdr_t *hdrs;
+  uint8_t *verdict;
+} verify_ctx_t;
+
+static void verify_run(void *arg, size_t first, size_t end)
+{
+  verify_ctx_t *c = (verify_ctx_t *)arg;
+  const size_t seg = pc_flash_sector_bytes(c->f);
+  for (size_t i = first; i < end; ++i)
+    if (c->verdict[i])
+      c->verdict[i] = pc_logseg_verify_crc(c->f, i * seg, &c->hdrs[i]) == PC_OK;
+}
+
+pc_result_t pc_recover_verify_sectors(const pc_flash_t *f, const pc_segment_hdr_t *hdrs, uint8_t *verdict,
+                                      unsigned nthreads)
+{
+  if (!f || !hdrs || !verdict || pc_flash_sector_bytes(f) == 0)
+    return PC_EINVAL;
+  verify_ctx_t c = {f, hdrs, verdict};
+  return run_split(nthreads, pc_flash_sector_count(f), verify_run, &c);
+}
+
+pc_sector_state_t pc_recover_sector_state(const pc_flash_t *f, size_t idx, pc_segment_hdr_t *hdr)
+{
+  if (pc_flash_is_bad(f, idx))
+    return PC_SECT_BAD;
+  bool erased = false;
+  pc_result_t st = pc_logseg_read_header(f, idx * pc_flash_sector_bytes(f), hdr, &erased);
+  if (st == PC_OK)
+    return erased ? PC_SECT_FREE : PC_SECT_COMMITTED;
+  if (st == PC_CORRUPT)
+    return PC_SECT_CORRUPT;
+  return PC_SECT_BAD;
+}
@@ -103,3 +103,10 @@ const void *pc_ring_peek(const pc_ring_t *r)
     return NULL;
   return (const void *)slot_ptr(r, r->tail);
 }
+
+const void *pc_ring_peek_at(const pc_ring_t *r, uint32_t i)
+{
+  if (!r || i >= r->head - r->tail)
+    return NULL;
+  return (const void *)slot_ptr(r, r->tail + i);
+}
@@ -0,0 +1,251 @@
+#include "pc_scan.h"
+#include "pc_logseg.h"
+#include <stdlib.h>
+#include <string.h>
+
+pc_result_t pc_scan_init(pc_scan_t *s, const pc_flash_t *f)
+{
+  if (!s || !f)
+    return PC_EINVAL;
+  memset(s, 0, sizeof(*s));
+  s->f = f;
+  s->preH = pc_logseg_preheader_bytes(f);
+  s->prog = pc_logseg_commit_page_bytes(f);
+  s->use_map = true;
+  if (s->prog == 0)
+    return PC_EINVAL;
+
+  // Smallest block is one header + one point.
+  s->dir_cap = s->preH / (sizeof(pc_block_hdr_t) + sizeof(pc_point_disk_t)) + 1;
+  s->dir = (pc_blockdir_ent_t *)malloc(s->dir_cap * sizeof(*s->dir));
+  s->seg_buf = (uint8_t *)malloc(s->preH);
+  s->page_valid = (uint8_t *)malloc(s->preH / s->prog);
+  if (!s->dir || !s->seg_buf || !s->page_valid)
+  {
+    pc_scan_free(s);
+    return PC_NO_SPACE;
+  }
+  return PC_OK;
+}
+
+void pc_scan_free(pc_scan_t *s)
+{
+  if (!s)
+    return;
+  free(s->dir);
+  free(s->seg_buf);
+  free(s->page_valid);
+  memset(s, 0, sizeof(*s));
+}
+
+// Pointer to [off, off+len) of the loaded segment, paging it in if needed.
+static pc_result_t view(pc_scan_t *s, size_t off, size_t len, const uint8_t **out)
+{
+  if (off + len > s->mem_len)
+    return PC_CORRUPT;
+  if (s->lazy && len)
+  {
+    size_t first = off / s->prog;
+    size_t last = (off + len - 1) / s->prog;
+    for (size_t p = first; p <= last;)
+    {
+      if (s->page_valid[p])
+      {
+        p++;
+        continue;
+      }
+      size_t q = p;
+      while (q <= last && !s->page_valid[q])
+        q++;
+      // One read for the whole run of missing pages.
+      pc_result_t st = pc_flash_read(s->f, s->lazy_base + p * s->prog, s->seg_buf + p * s->prog, (q - p) * s->prog);
+      s->flash_reads++;
+      if (st != PC_OK)
+        return st;
+      memset(s->page_valid + p, 1, q - p);
+      p = q;
+    }
+  }
+  *out = s->mem + off;
+  return PC_OK;
+}
+
+static pc_result_t build_dir(pc_scan_t *s, uint32_t record_count)
+{
+  s->nblocks = 0;
+
+  size_t off = 0;
+  uint32_t seen = 0;
+  while (seen < record_count)
+  {
+    pc_blockdir_ent_t *e = &s->dir[s->nblocks];
+    if (s->nblocks == s->dir_cap || off + sizeof(e->hdr) > s->preH)
+      return PC_CORRUPT;
+    const uint8_t *p = NULL;
+    pc_result_t st = view(s, off, sizeof(e->hdr), &p);
+    if (st != PC_OK)
+      return st;
+    memcpy(&e->hdr, p, sizeof(e->hdr));
+    e->flags = e->hdr.point_count & ~PC_BLOCK_COUNT_MASK;
+    e->hdr.point_count &= PC_BLOCK_COUNT_MASK;
+    if (e->hdr.point_count == 0 || e->hdr.point_count > record_count - seen)
+      return PC_CORRUPT;
+    size_t bytes = (size_t)e->hdr.point_count * sizeof(pc_point_disk_t);
+    if (e->flags & PC_BLOCK_F_SUMMARY)
+    {
+      st = view(s, off + sizeof(e->hdr) + bytes, sizeof(e->sum), &p);
+      if (st != PC_OK)
+        return st;
+      memcpy(&e->sum, p, sizeof(e->sum));
+      bytes += sizeof(e->sum);
+    }
+    e->sketch_off = 0;
+    e->sketch_len = 0;
+    if (e->flags & PC_BLOCK_F_SKETCH)
+    {
+      size_t at = off + sizeof(e->hdr) + bytes;
+      if (!(e->flags & PC_BLOCK_F_SUMMARY))
+        return PC_CORRUPT;
+      st = view(s, at, sizeof(pc_sketch_hdr_t), &p);
+      if (st != PC_OK)
+        return st;
+      size_t len = pc_sketch_encoded_bytes(p, s->mem_len - at);
+      if (len == 0)
+        return PC_CORRUPT;
+      e->sketch_off = (uint32_t)at;
+      e->sketch_len = (uint32_t)len;
+      bytes += len;
+    }
+    if (off + sizeof(e->hdr) + bytes > s->preH)
+      return PC_CORRUPT;
+
+    e->off = (uint32_t)off;
+    off += sizeof(e->hdr) + bytes;
+    seen += e->hdr.point_count;
+    s->nblocks++;
+  }
+  s->dirs_loaded++;
+  return PC_OK;
+}
+
+static pc_result_t load(pc_scan_t *s, size_t base, uint32_t record_count, uint32_t seqno)
+{
+  s->mem_len = s->preH;
+  s->lazy = false;
+  s->seqno = seqno;
+  if (s->use_map)
+  {
+    const void *p = NULL;
+    pc_result_t st = pc_flash_map(s->f, base, s->preH, &p);
+    s->flash_reads++;
+    if (st == PC_OK)
+    {
+      s->mem = (const uint8_t *)p;
+      return build_dir(s, record_count);
+    }
+    if (st != PC_UNSUPPORTED)
+      return st;
+  }
+
+  memset(s->page_valid, 0, s->preH / s->prog);
+  s->mem = s->seg_buf;
+  s->lazy = true;
+  s->lazy_base = base;
+
+  size_t len = 0;
+  const void *hit = seqno && s->cache ? pc_blockcache_get(s->cache, base, seqno, PC_BLOCKCACHE_DIR, &len) : NULL;
+  if (hit && len <= s->dir_cap * sizeof(*s->dir) && len % sizeof(*s->dir) == 0)
+  {
+    memcpy(s->dir, hit, len);
+    s->nblocks = len / sizeof(*s->dir);
+    s->dirs_loaded++;
+    return PC_OK;
+  }
+  pc_result_t st = build_dir(s, record_count);
+  if (st == PC_OK && seqno && s->cache && s->nblocks)
+    (void)pc_blockcache_put(s->cache, base, seqno, PC_BLOCKCACHE_DIR, s->dir, s->nblocks * sizeof(*s->dir));
+  return st;
+}
+
+pc_result_t pc_scan_load_dir(pc_scan_t *s, size_t base, uint32_t record_count)
+{
+  if (!s || !s->dir)
+    return PC_EINVAL;
+  return load(s, base, record_count, 0);
+}
+
+pc_result_t pc_scan_load_seg(pc_scan_t *s, const pc_seg_summary_t *seg)
+{
+  if (!s || !s->dir || !seg)
+    return PC_EINVAL;
+  if (s->check)
+  {
+    pc_result_t st = s->check(s->check_ctx, seg);
+    if (st != PC_OK)
+      return st;
+  }
+  return load(s, seg->base, seg->record_count, seg->seqno);
+}
+
+pc_result_t pc_scan_load_open(pc_scan_t *s, const pc_appender_t *a)
+{
+  if (!s || !s->dir || !a || !a->open || a->f != s->f)
+    return PC_EINVAL;
+  // [0, programmed) is on flash; [programmed, seg_off) is still in the staging page.
+  size_t programmed = a->seg_off - a->page_off;
+  if (a->seg_off > s->preH)
+    return PC_CORRUPT;
+  pc_result_t st = pc_flash_read(s->f, a->base, s->seg_buf, programmed);
+  s->flash_reads++;
+  if (st != PC_OK)
+    return st;
+  memcpy(s->seg_buf + programmed, a->page, a->page_off);
+  s->mem = s->seg_buf;
+  s->mem_len = a->seg_off;
+  s->lazy = false;
+  s->seqno = 0; // still growing: never cached
+  return build_dir(s, a->record_count);
+}
+
+pc_result_t pc_scan_block_points(pc_scan_t *s, size_t idx, const pc_point_disk_t **out_pts)
+{
+  if (!s || !out_pts || idx >= s->nblocks)
+    return PC_EINVAL;
+  const pc_blockdir_ent_t *e = &s->dir[idx];
+  const size_t bytes = (size_t)e->hdr.point_count * sizeof(pc_point_disk_t);
+  const bool cacheable = s->lazy && s->seqno && s->cache;
+  if (cacheable)
+  {
+    size_t len = 0;
+    const void *hit = pc_blockcache_get(s->cache, s->lazy_base, s->seqno, e->off, &len);
+    if (hit && len == bytes)
+    {
+      s->blocks_read++;
+      *out_pts = (const pc_point_disk_t *)hit;
+      return PC_OK;
+    }
+  }
+  const uint8_t *p = NULL;
+  pc_result_t st = view(s, e->off + sizeof(e->hdr), bytes, &p);
+  if (st != PC_OK)
+    return st;
+  if (cacheable)
+    (void)pc_blockcache_put(s->cache, s->lazy_base, s->seqno, e->off, p, bytes);
+  s->blocks_read++;
+  *out_pts = (const pc_point_disk_t *)p; // packed struct: byte alignment is fine
+  return PC_OK;
+}
+
+pc_result_t pc_scan_block_sketch(pc_scan_t *s, size_t idx, const uint8_t **out, size_t *out_len)
+{
+  if (!s || !out || !out_len || idx >= s->nblocks)
+    return PC_EINVAL;
+  const pc_blockdir_ent_t *e = &s->dir[idx];
+  if (!(e->flags & PC_BLOCK_F_SKETCH))
+    return PC_METRIC_UNKNOWN;
+  pc_result_t st = view(s, e->sketch_off, e->sketch_len, out);
+  if (st != PC_OK)
+    return st;
+  *out_len = e->sketch_len;
+  return PC_OK;
+}
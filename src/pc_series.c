@@ -0,0 +1,427 @@
+#include "pc_series.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// On-flash record in PC_INDEX_SEC_SERIES: [ uint32_t count ][ rec + key bytes ]...
+typedef struct __attribute__((packed))
+{
+  uint16_t metric_id;
+  uint16_t series_id;
+  uint16_t ntags;
+  uint16_t key_len;
+} series_rec_t;
+
+static size_t slots_for(size_t capacity)
+{
+  size_t n = 8;
+  while (n < capacity * 2)
+    n <<= 1;
+  return n;
+}
+
+pc_result_t pc_series_dict_init(pc_series_dict_t *d, size_t capacity)
+{
+  if (!d)
+    return PC_EINVAL;
+  memset(d, 0, sizeof(*d));
+  d->next_metric = 1;
+  d->next_series = 1;
+  pc_tagindex_init(&d->tags);
+  return pc_series_dict_reserve(d, capacity);
+}
+
+void pc_series_dict_free(pc_series_dict_t *d)
+{
+  if (!d)
+    return;
+  free(d->ents);
+  free(d->slots);
+  free(d->by_metric);
+  free(d->by_series);
+  free(d->keys);
+  pc_tagindex_free(&d->tags);
+  memset(d, 0, sizeof(*d));
+}
+
+static void slot_put(uint32_t *slots, size_t nslots, uint32_t hash, uint32_t idx)
+{
+  size_t mask = nslots - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask)
+  {
+    if (slots[2 * i + 1] == 0)
+    {
+      slots[2 * i] = hash;
+      slots[2 * i + 1] = idx + 1u;
+      return;
+    }
+  }
+}
+
+pc_result_t pc_series_dict_reserve(pc_series_dict_t *d, size_t capacity)
+{
+  if (!d || capacity == 0 || capacity > PC_SERIES_CAPACITY_MAX || capacity < d->count)
+    return PC_EINVAL;
+  if (capacity <= d->capacity)
+    return PC_OK;
+
+  size_t nslots = slots_for(capacity);
+  pc_series_ent_t *ents = (pc_series_ent_t *)realloc(d->ents, capacity * sizeof(*ents));
+  if (!ents)
+    return PC_NO_SPACE;
+  d->ents = ents;
+  uint16_t *bm = (uint16_t *)realloc(d->by_metric, (capacity + 1) * sizeof(*bm));
+  if (!bm)
+    return PC_NO_SPACE;
+  d->by_metric = bm;
+  uint16_t *bs = (uint16_t *)realloc(d->by_series, (capacity + 1) * sizeof(*bs));
+  if (!bs)
+    return PC_NO_SPACE;
+  d->by_series = bs;
+  uint32_t *slots = (uint32_t *)calloc(nslots * 2, sizeof(*slots));
+  if (!slots)
+    return PC_NO_SPACE;
+
+  for (size_t i = 0; i < d->count; ++i)
+    slot_put(slots, nslots, d->ents[i].hash, (uint32_t)i);
+  free(d->slots);
+  d->slots = slots;
+  d->nslots = nslots;
+  d->capacity = capacity;
+  return PC_OK;
+}
+
+// ---- Canonical keys ----
+
+static bool valid_tags(const pc_tag_t *tags, size_t ntags)
+{
+  if (ntags > PC_SERIES_MAX_TAGS || (ntags && !tags))
+    return false;
+  for (size_t i = 0; i < ntags; ++i)
+  {
+    if (!tags[i].key || !tags[i].value || !tags[i].key[0] || strchr(tags[i].key, '='))
+      return false;
+    for (size_t j = 0; j < i; ++j)
+      if (strcmp(tags[i].key, tags[j].key) == 0)
+        return false;
+  }
+  return true;
+}
+
+// Writes name [ '\0' k '=' v ]... with tags sorted by key. Returns length or 0.
+static size_t canonical(const char *name, const pc_tag_t *tags, size_t ntags, char *out)
+{
+  if (!name || !name[0] || !valid_tags(tags, ntags))
+    return 0;
+  size_t order[PC_SERIES_MAX_TAGS];
+  for (size_t i = 0; i < ntags; ++i)
+  {
+    size_t j = i;
+    while (j > 0 && strcmp(tags[order[j - 1]].key, tags[i].key) > 0)
+    {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  size_t len = strlen(name);
+  if (len > PC_SERIES_MAX_KEY)
+    return 0;
+  memcpy(out, name, len);
+  for (size_t i = 0; i < ntags; ++i)
+  {
+    const pc_tag_t *t = &tags[order[i]];
+    size_t kl = strlen(t->key), vl = strlen(t->value);
+    if (len + 2 + kl + vl > PC_SERIES_MAX_KEY)
+      return 0;
+    out[len++] = '\0';
+    memcpy(out + len, t->key, kl);
+    len += kl;
+    out[len++] = '=';
+    memcpy(out + len, t->value, vl);
+    len += vl;
+  }
+  return len;
+}
+
+static int32_t lookup(const pc_series_dict_t *d, const char *key, size_t len, uint32_t hash)
+{
+  size_t mask = d->nslots - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask)
+  {
+    uint32_t e = d->slots[2 * i + 1];
+    if (e == 0)
+      return -1;
+    const pc_series_ent_t *ent = &d->ents[e - 1];
+    if (d->slots[2 * i] == hash && ent->key_len == len && memcmp(d->keys + ent->key_off, key, len) == 0)
+      return (int32_t)(e - 1);
+  }
+}
+
+static pc_result_t insert(pc_series_dict_t *d, const char *key, size_t len, uint32_t hash,
+                          uint16_t ntags, uint16_t metric_id, uint16_t series_id)
+{
+  // Room for the key first: past this point only the postings can fail.
+  if (d->keys_len + len > d->keys_cap)
+  {
+    size_t cap = d->keys_cap ? d->keys_cap : 1024;
+    while (cap < d->keys_len + len)
+      cap *= 2;
+    char *k = (char *)realloc(d->keys, cap);
+    if (!k)
+      return PC_NO_SPACE;
+    d->keys = k;
+    d->keys_cap = cap;
+  }
+
+  // Index every "k=v" of a tagged series before recording the entry; on
+  // failure the pairs already added are taken out again.
+  if (series_id)
+  {
+    for (size_t i = 0; i < len; ++i)
+    {
+      if (key[i] != '\0')
+        continue;
+      size_t j = i + 1;
+      while (j < len && key[j] != '\0')
+        j++;
+      pc_result_t st = pc_tagindex_add(&d->tags, key + i + 1, j - i - 1, series_id);
+      if (st != PC_OK)
+      {
+        for (size_t r = 0; r < i; ++r)
+        {
+          if (key[r] != '\0')
+            continue;
+          size_t e = r + 1;
+          while (e < len && key[e] != '\0')
+            e++;
+          pc_tagindex_remove(&d->tags, key + r + 1, e - r - 1, series_id);
+        }
+        return st;
+      }
+    }
+  }
+
+  memcpy(d->keys + d->keys_len, key, len);
+
+  uint32_t idx = (uint32_t)d->count++;
+  pc_series_ent_t *e = &d->ents[idx];
+  e->hash = hash;
+  e->metric_id = metric_id;
+  e->series_id = series_id;
+  e->key_off = (uint32_t)d->keys_len;
+  e->key_len = (uint16_t)len;
+  e->ntags = ntags;
+  d->keys_len += len;
+  slot_put(d->slots, d->nslots, hash, idx);
+  if (series_id)
+    d->by_series[series_id] = (uint16_t)idx;
+  else
+    d->by_metric[metric_id] = (uint16_t)idx;
+  d->dirty = true;
+  return PC_OK;
+}
+
+pc_result_t pc_series_dict_find(const pc_series_dict_t *d, const char *name,
+                                const pc_tag_t *tags, size_t ntags, pc_series_t *out)
+{
+  if (!d || !out)
+    return PC_EINVAL;
+  char key[PC_SERIES_MAX_KEY];
+  size_t len = canonical(name, tags, ntags, key);
+  if (len == 0)
+    return PC_EINVAL;
+  int32_t i = lookup(d, key, len, pc_fnv1a(key, len));
+  if (i < 0)
+    return PC_METRIC_UNKNOWN;
+  out->metric_id = d->ents[i].metric_id;
+  out->series_id = d->ents[i].series_id;
+  return PC_OK;
+}
+
+pc_result_t pc_series_dict_resolve(pc_series_dict_t *d, const char *name,
+                                   const pc_tag_t *tags, size_t ntags, pc_series_t *out)
+{
+  if (!d || !out)
+    return PC_EINVAL;
+  char key[PC_SERIES_MAX_KEY];
+  size_t len = canonical(name, tags, ntags, key);
+  if (len == 0)
+    return PC_EINVAL;
+  uint32_t hash = pc_fnv1a(key, len);
+  int32_t i = lookup(d, key, len, hash);
+  if (i >= 0)
+  {
+    out->metric_id = d->ents[i].metric_id;
+    out->series_id = d->ents[i].series_id;
+    return PC_OK;
+  }
+
+  // The name prefix of the canonical key is the metric's own key.
+  size_t name_len = strlen(name);
+  uint32_t name_hash = pc_fnv1a(key, name_len);
+  int32_t m = ntags ? lookup(d, key, name_len, name_hash) : -1;
+  size_t need = 1u + (ntags && m < 0);
+  if (d->count + need > d->capacity)
+    return PC_TOO_MANY_SERIES;
+
+  // Ids are only consumed once their entry is in: the snapshot loader expects
+  // them dense. A metric entry whose series insert then fails stays, as a
+  // plain metric, and is picked up by the retry.
+  uint16_t metric_id;
+  if (m >= 0)
+    metric_id = d->ents[m].metric_id;
+  else
+  {
+    metric_id = d->next_metric;
+    if (ntags)
+    {
+      pc_result_t st = insert(d, key, name_len, name_hash, 0, metric_id, 0);
+      if (st != PC_OK)
+        return st;
+      d->next_metric++;
+    }
+  }
+  uint16_t series_id = ntags ? d->next_series : 0u;
+  pc_result_t st = insert(d, key, len, hash, (uint16_t)ntags, metric_id, series_id);
+  if (st != PC_OK)
+    return st;
+  if (ntags)
+    d->next_series++;
+  else
+    d->next_metric++;
+  out->metric_id = metric_id;
+  out->series_id = series_id;
+  return PC_OK;
+}
+
+pc_result_t pc_series_dict_key(const pc_series_dict_t *d, pc_series_t s,
+                               const char **out_key, size_t *out_len)
+{
+  if (!d || !out_key || !out_len)
+    return PC_EINVAL;
+  size_t idx = SIZE_MAX;
+  if (s.series_id)
+  {
+    if (s.series_id < d->next_series)
+      idx = d->by_series[s.series_id];
+  }
+  else if (s.metric_id && s.metric_id < d->next_metric)
+    idx = d->by_metric[s.metric_id];
+  if (idx >= d->count || d->ents[idx].metric_id != s.metric_id || d->ents[idx].series_id != s.series_id)
+    return PC_METRIC_UNKNOWN;
+  const pc_series_ent_t *e = &d->ents[idx];
+  *out_key = d->keys + e->key_off;
+  *out_len = e->key_len;
+  return PC_OK;
+}
+
+pc_result_t pc_series_dict_describe(const pc_series_dict_t *d, pc_series_t s, char *buf, size_t cap)
+{
+  if (!buf || cap == 0)
+    return PC_EINVAL;
+  const char *key = NULL;
+  size_t len = 0;
+  pc_result_t st = pc_series_dict_key(d, s, &key, &len);
+  if (st != PC_OK)
+    return st;
+
+  // name\0k=v\0k2=v2 → name{k=v,k2=v2}
+  size_t o = 0;
+  bool tags = false;
+  for (size_t i = 0; i < len; ++i)
+  {
+    char c = key[i];
+    if (c == '\0')
+    {
+      c = tags ? ',' : '{';
+      tags = true;
+    }
+    if (o + 1 >= cap)
+      return PC_NO_SPACE;
+    buf[o++] = c;
+  }
+  if (tags)
+  {
+    if (o + 1 >= cap)
+      return PC_NO_SPACE;
+    buf[o++] = '}';
+  }
+  buf[o] = '\0';
+  return PC_OK;
+}
+
+// ---- Snapshot section ----
+
+pc_result_t pc_series_dict_save(const pc_series_dict_t *d, pc_index_blob_t *b)
+{
+  if (!d || !b)
+    return PC_EINVAL;
+  size_t bytes = sizeof(uint32_t) + d->count * sizeof(series_rec_t) + d->keys_len;
+  uint8_t *body = pc_index_blob_section(b, PC_INDEX_SEC_SERIES, bytes);
+  if (!body)
+    return PC_NO_SPACE;
+  uint32_t n = (uint32_t)d->count;
+  memcpy(body, &n, sizeof(n));
+  uint8_t *p = body + sizeof(n);
+  for (size_t i = 0; i < d->count; ++i)
+  {
+    const pc_series_ent_t *e = &d->ents[i];
+    series_rec_t r = {e->metric_id, e->series_id, e->ntags, e->key_len};
+    memcpy(p, &r, sizeof(r));
+    memcpy(p + sizeof(r), d->keys + e->key_off, e->key_len);
+    p += sizeof(r) + e->key_len;
+  }
+  return PC_OK;
+}
+
+pc_result_t pc_series_dict_load(pc_series_dict_t *d, const uint8_t *body, size_t bytes)
+{
+  if (!d || (!body && bytes))
+    return PC_EINVAL;
+  uint32_t n = 0;
+  if (bytes < sizeof(n))
+    return PC_CORRUPT;
+  memcpy(&n, body, sizeof(n));
+  if (n > PC_SERIES_CAPACITY_MAX)
+    return PC_CORRUPT;
+  pc_result_t st = pc_series_dict_reserve(d, n > d->capacity ? n : d->capacity);
+  if (st != PC_OK)
+    return st;
+
+  d->count = 0;
+  d->keys_len = 0;
+  d->next_metric = 1;
+  d->next_series = 1;
+  memset(d->slots, 0, d->nslots * 2 * sizeof(*d->slots));
+  pc_tagindex_clear(&d->tags);
+
+  size_t off = sizeof(n);
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    series_rec_t r;
+    if (off + sizeof(r) > bytes)
+      return PC_CORRUPT;
+    memcpy(&r, body + off, sizeof(r));
+    off += sizeof(r);
+    // Ids are handed out in order, so they never exceed the entry count.
+    if (off + r.key_len > bytes || r.key_len == 0 || r.key_len > PC_SERIES_MAX_KEY ||
+        r.metric_id == 0 || r.metric_id > n || r.series_id > n || (r.series_id == 0) != (r.ntags == 0))
+      return PC_CORRUPT;
+    const char *key = (const char *)body + off;
+    uint32_t hash = pc_fnv1a(key, r.key_len);
+    if (lookup(d, key, r.key_len, hash) >= 0)
+      return PC_CORRUPT;
+    st = insert(d, key, r.key_len, hash, r.ntags, r.metric_id, r.series_id);
+    if (st != PC_OK)
+      return st;
+    if (r.metric_id >= d->next_metric)
+      d->next_metric = (uint16_t)(r.metric_id + 1u);
+    if (r.series_id >= d->next_series)
+      d->next_series = (uint16_t)(r.series_id + 1u);
+    off += r.key_len;
+  }
+  d->dirty = false;
+  return off == bytes ? PC_OK : PC_CORRUPT;
+}
@@ -0,0 +1,236 @@
+#include "pc_sketch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SHIFT (23u - PC_SKETCH_SUB_BITS)
+
+static uint32_t float_bits(float v)
+{
+  uint32_t b;
+  memcpy(&b, &v, sizeof(b));
+  return b;
+}
+
+// 0 = zero bucket, 1 = binned (key/neg set), -1 = ignored (NaN/Inf)
+static int bin_of(float v, uint16_t *key, int *neg)
+{
+  uint32_t b = float_bits(v);
+  uint32_t e = (b >> 23) & 0xFFu;
+  if (e == 0xFFu)
+    return -1;
+  if (e == 0u)
+    return 0;
+  *neg = (int)(b >> 31);
+  *key = (uint16_t)((b & 0x7FFFFFFFu) >> SHIFT);
+  return 1;
+}
+
+// Midpoint of a bucket (in mantissa space).
+static float key_value(uint32_t key, int neg)
+{
+  uint32_t b = (key << SHIFT) | (1u << (SHIFT - 1u)) | ((uint32_t)neg << 31);
+  float v;
+  memcpy(&v, &b, sizeof(v));
+  return v;
+}
+
+static int cmp_u16(const void *x, const void *y)
+{
+  return (int)*(const uint16_t *)x - (int)*(const uint16_t *)y;
+}
+
+// Run-length encode sorted keys as bins. Returns bins written.
+static uint16_t put_bins(const uint16_t *keys, uint32_t n, pc_sketch_bin_t *out)
+{
+  uint16_t nb = 0;
+  for (uint32_t i = 0; i < n;)
+  {
+    uint32_t j = i;
+    while (j < n && keys[j] == keys[i] && j - i < 0xFFFFu)
+      j++;
+    out[nb].key = keys[i];
+    out[nb].count = (uint16_t)(j - i);
+    nb++;
+    i = j;
+  }
+  return nb;
+}
+
+size_t pc_sketch_encode(const float *val, uint32_t n, uint8_t *out, size_t cap)
+{
+  if (!val || !out || n > PC_SKETCH_MAX_POINTS || cap < sizeof(pc_sketch_hdr_t))
+    return 0;
+
+  uint16_t neg[PC_SKETCH_MAX_POINTS], pos[PC_SKETCH_MAX_POINTS];
+  uint32_t nn = 0, np = 0, zero = 0;
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    uint16_t key = 0;
+    int sign = 0;
+    int r = bin_of(val[i], &key, &sign);
+    if (r == 0)
+      zero++;
+    else if (r > 0 && sign)
+      neg[nn++] = key;
+    else if (r > 0)
+      pos[np++] = key;
+  }
+  qsort(neg, nn, sizeof(neg[0]), cmp_u16);
+  qsort(pos, np, sizeof(pos[0]), cmp_u16);
+
+  pc_sketch_bin_t bins[PC_SKETCH_MAX_POINTS];
+  pc_sketch_hdr_t h;
+  memset(&h, 0, sizeof(h));
+  h.sub_bits = (uint8_t)PC_SKETCH_SUB_BITS;
+  h.nneg = put_bins(neg, nn, bins);
+  h.npos = put_bins(pos, np, bins + h.nneg);
+  h.zero_count = zero;
+
+  size_t bytes = sizeof(h) + (size_t)(h.nneg + h.npos) * sizeof(pc_sketch_bin_t);
+  if (bytes > cap)
+    return 0;
+  memcpy(out, &h, sizeof(h));
+  memcpy(out + sizeof(h), bins, bytes - sizeof(h));
+  return bytes;
+}
+
+size_t pc_sketch_encoded_bytes(const uint8_t *p, size_t avail)
+{
+  pc_sketch_hdr_t h;
+  if (!p || avail < sizeof(h))
+    return 0;
+  memcpy(&h, p, sizeof(h));
+  size_t bytes = sizeof(h) + (size_t)(h.nneg + h.npos) * sizeof(pc_sketch_bin_t);
+  return bytes <= avail ? bytes : 0;
+}
+
+void pc_sketch_acc_init(pc_sketch_acc_t *acc)
+{
+  if (acc)
+    memset(acc, 0, sizeof(*acc));
+}
+
+void pc_sketch_acc_free(pc_sketch_acc_t *acc)
+{
+  if (!acc)
+    return;
+  free(acc->neg.cnt);
+  free(acc->pos.cnt);
+  memset(acc, 0, sizeof(*acc));
+}
+
+// Make room for 'key' in the side's window (re-centering when it grows).
+static pc_result_t side_reserve(pc_sketch_side_t *s, uint32_t key)
+{
+  if (s->n && key >= s->lo && key < s->lo + s->n)
+    return PC_OK;
+  uint32_t lo = s->n ? (key < s->lo ? key : s->lo) : key;
+  uint32_t hi = s->n ? (key >= s->lo + s->n ? key + 1u : s->lo + s->n) : key + 1u;
+  // Over-allocate a little so neighbouring keys do not realloc every time.
+  uint32_t pad = (hi - lo) / 2u + 8u;
+  lo = lo > pad ? lo - pad : 0u;
+  hi += pad;
+  uint64_t *c = (uint64_t *)calloc(hi - lo, sizeof(*c));
+  if (!c)
+    return PC_NO_SPACE;
+  if (s->n)
+    memcpy(c + (s->lo - lo), s->cnt, s->n * sizeof(*c));
+  free(s->cnt);
+  s->cnt = c;
+  s->lo = lo;
+  s->n = hi - lo;
+  return PC_OK;
+}
+
+static pc_result_t side_add(pc_sketch_side_t *s, uint32_t key, uint64_t count)
+{
+  pc_result_t st = side_reserve(s, key);
+  if (st != PC_OK)
+    return st;
+  s->cnt[key - s->lo] += count;
+  return PC_OK;
+}
+
+pc_result_t pc_sketch_acc_add(pc_sketch_acc_t *acc, float v)
+{
+  if (!acc)
+    return PC_EINVAL;
+  uint16_t key = 0;
+  int neg = 0;
+  int r = bin_of(v, &key, &neg);
+  if (r < 0)
+    return PC_OK;
+  if (r == 0)
+    acc->zero++;
+  else
+  {
+    pc_result_t st = side_add(neg ? &acc->neg : &acc->pos, key, 1u);
+    if (st != PC_OK)
+      return st;
+  }
+  acc->total++;
+  return PC_OK;
+}
+
+pc_result_t pc_sketch_acc_merge(pc_sketch_acc_t *acc, const uint8_t *p, size_t len)
+{
+  if (!acc || !p)
+    return PC_EINVAL;
+  pc_sketch_hdr_t h;
+  if (len < sizeof(h) || pc_sketch_encoded_bytes(p, len) == 0)
+    return PC_CORRUPT;
+  memcpy(&h, p, sizeof(h));
+  if (h.sub_bits != PC_SKETCH_SUB_BITS)
+    return PC_UNSUPPORTED;
+
+  const uint8_t *b = p + sizeof(h);
+  for (uint32_t i = 0; i < (uint32_t)h.nneg + h.npos; ++i)
+  {
+    pc_sketch_bin_t bin;
+    memcpy(&bin, b + i * sizeof(bin), sizeof(bin));
+    pc_result_t st = side_add(i < h.nneg ? &acc->neg : &acc->pos, bin.key, bin.count);
+    if (st != PC_OK)
+      return st;
+    acc->total += bin.count;
+  }
+  acc->zero += h.zero_count;
+  acc->total += h.zero_count;
+  return PC_OK;
+}
+
+pc_result_t pc_sketch_acc_quantile(const pc_sketch_acc_t *acc, float q, float *out)
+{
+  if (!acc || !out || !(q >= 0.0f && q <= 1.0f))
+    return PC_EINVAL;
+  if (acc->total == 0)
+    return PC_METRIC_UNKNOWN;
+
+  uint64_t rank = (uint64_t)((double)q * (double)(acc->total - 1u));
+  uint64_t seen = 0;
+  // Ascending value order: most negative first, then zero, then positives.
+  for (uint32_t i = acc->neg.n; i-- > 0;)
+  {
+    seen += acc->neg.cnt[i];
+    if (seen > rank)
+    {
+      *out = key_value(acc->neg.lo + i, 1);
+      return PC_OK;
+    }
+  }
+  seen += acc->zero;
+  if (seen > rank)
+  {
+    *out = 0.0f;
+    return PC_OK;
+  }
+  for (uint32_t i = 0; i < acc->pos.n; ++i)
+  {
+    seen += acc->pos.cnt[i];
+    if (seen > rank)
+    {
+      *out = key_value(acc->pos.lo + i, 0);
+      return PC_OK;
+    }
+  }
+  return PC_CORRUPT; // counts do not add up to total
+}
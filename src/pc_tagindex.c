@@ -0,0 +1,325 @@
+#include "pc_tagindex.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PC_TAG_KV_MAX 256u
+
+// ---- Series sets ----
+
+void pc_series_set_init(pc_series_set_t *s)
+{
+  if (s)
+    memset(s, 0, sizeof(*s));
+}
+
+void pc_series_set_free(pc_series_set_t *s)
+{
+  if (!s)
+    return;
+  free(s->words);
+  memset(s, 0, sizeof(*s));
+}
+
+static pc_result_t set_resize(pc_series_set_t *s, size_t nwords)
+{
+  if (nwords > s->nwords)
+  {
+    uint64_t *w = (uint64_t *)realloc(s->words, nwords * sizeof(*w));
+    if (!w)
+      return PC_NO_SPACE;
+    s->words = w;
+  }
+  s->nwords = nwords;
+  memset(s->words, 0, nwords * sizeof(*s->words));
+  s->count = 0;
+  return PC_OK;
+}
+
+// ---- Postings ----
+
+static size_t words_for(uint16_t id) { return ((size_t)id >> 6) + 1u; }
+
+static pc_result_t post_to_dense(pc_tag_posting_t *p, size_t nwords)
+{
+  uint64_t *w = (uint64_t *)calloc(nwords, sizeof(*w));
+  if (!w)
+    return PC_NO_SPACE;
+  for (uint32_t i = 0; i < p->card; ++i)
+    w[p->ids[i] >> 6] |= 1ull << (p->ids[i] & 63u);
+  free(p->ids);
+  p->ids = NULL;
+  p->ids_cap = 0;
+  p->words = w;
+  p->nwords = nwords;
+  p->dense = true;
+  return PC_OK;
+}
+
+static pc_result_t post_add(pc_tag_posting_t *p, uint16_t id)
+{
+  if (p->dense)
+  {
+    if (words_for(id) > p->nwords)
+    {
+      size_t n = words_for(id);
+      uint64_t *w = (uint64_t *)realloc(p->words, n * sizeof(*w));
+      if (!w)
+        return PC_NO_SPACE;
+      memset(w + p->nwords, 0, (n - p->nwords) * sizeof(*w));
+      p->words = w;
+      p->nwords = n;
+    }
+    uint64_t bit = 1ull << (id & 63u);
+    if (!(p->words[id >> 6] & bit))
+    {
+      p->words[id >> 6] |= bit;
+      p->card++;
+    }
+    return PC_OK;
+  }
+
+  // Array form: keep sorted, ignore duplicates (appends in the common case).
+  uint32_t pos = p->card;
+  while (pos > 0 && p->ids[pos - 1] > id)
+    pos--;
+  if (pos > 0 && p->ids[pos - 1] == id)
+    return PC_OK;
+  if (p->card == p->ids_cap)
+  {
+    uint32_t cap = p->ids_cap ? p->ids_cap * 2u : 4u;
+    uint16_t *ids = (uint16_t *)realloc(p->ids, cap * sizeof(*ids));
+    if (!ids)
+      return PC_NO_SPACE;
+    p->ids = ids;
+    p->ids_cap = cap;
+  }
+  memmove(p->ids + pos + 1, p->ids + pos, (p->card - pos) * sizeof(*p->ids));
+  p->ids[pos] = id;
+  p->card++;
+
+  // Switch once 2 bytes per id cost more than 1 bit per id spanned.
+  uint16_t max_id = p->ids[p->card - 1];
+  if ((size_t)p->card * 16u >= words_for(max_id) * 64u)
+    return post_to_dense(p, words_for(max_id));
+  return PC_OK;
+}
+
+// ---- Index ----
+
+void pc_tagindex_init(pc_tagindex_t *ix)
+{
+  if (ix)
+    memset(ix, 0, sizeof(*ix));
+}
+
+void pc_tagindex_clear(pc_tagindex_t *ix)
+{
+  if (!ix)
+    return;
+  for (size_t i = 0; i < ix->count; ++i)
+  {
+    free(ix->posts[i].ids);
+    free(ix->posts[i].words);
+  }
+  ix->count = 0;
+  ix->strs_len = 0;
+  if (ix->slots)
+    memset(ix->slots, 0, ix->nslots * sizeof(*ix->slots));
+}
+
+void pc_tagindex_free(pc_tagindex_t *ix)
+{
+  if (!ix)
+    return;
+  pc_tagindex_clear(ix);
+  free(ix->posts);
+  free(ix->slots);
+  free(ix->strs);
+  memset(ix, 0, sizeof(*ix));
+}
+
+static int32_t find_post(const pc_tagindex_t *ix, const char *kv, size_t len, uint32_t hash)
+{
+  if (!ix->nslots)
+    return -1;
+  size_t mask = ix->nslots - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask)
+  {
+    uint32_t e = ix->slots[i];
+    if (e == 0)
+      return -1;
+    const pc_tag_posting_t *p = &ix->posts[e - 1];
+    if (p->hash == hash && p->str_len == len && memcmp(ix->strs + p->str_off, kv, len) == 0)
+      return (int32_t)(e - 1);
+  }
+}
+
+static pc_result_t grow_posts(pc_tagindex_t *ix)
+{
+  size_t cap = ix->cap ? ix->cap * 2 : 16;
+  pc_tag_posting_t *p = (pc_tag_posting_t *)realloc(ix->posts, cap * sizeof(*p));
+  if (!p)
+    return PC_NO_SPACE;
+  ix->posts = p;
+  ix->cap = cap;
+
+  // Keep the table at most half full.
+  size_t nslots = cap * 2;
+  uint32_t *slots = (uint32_t *)calloc(nslots, sizeof(*slots));
+  if (!slots)
+    return PC_NO_SPACE;
+  for (size_t k = 0; k < ix->count; ++k)
+  {
+    size_t i = ix->posts[k].hash & (nslots - 1);
+    while (slots[i])
+      i = (i + 1) & (nslots - 1);
+    slots[i] = (uint32_t)k + 1u;
+  }
+  free(ix->slots);
+  ix->slots = slots;
+  ix->nslots = nslots;
+  return PC_OK;
+}
+
+pc_result_t pc_tagindex_add(pc_tagindex_t *ix, const char *kv, size_t kv_len, uint16_t series_id)
+{
+  if (!ix || !kv || kv_len == 0 || kv_len > PC_TAG_KV_MAX)
+    return PC_EINVAL;
+  uint32_t hash = pc_fnv1a(kv, kv_len);
+  int32_t k = find_post(ix, kv, kv_len, hash);
+  if (k < 0)
+  {
+    if (ix->count == ix->cap && grow_posts(ix) != PC_OK)
+      return PC_NO_SPACE;
+    if (ix->strs_len + kv_len > ix->strs_cap)
+    {
+      size_t cap = ix->strs_cap ? ix->strs_cap : 512;
+      while (cap < ix->strs_len + kv_len)
+        cap *= 2;
+      char *s = (char *)realloc(ix->strs, cap);
+      if (!s)
+        return PC_NO_SPACE;
+      ix->strs = s;
+      ix->strs_cap = cap;
+    }
+    memcpy(ix->strs + ix->strs_len, kv, kv_len);
+    k = (int32_t)ix->count++;
+    pc_tag_posting_t *p = &ix->posts[k];
+    memset(p, 0, sizeof(*p));
+    p->hash = hash;
+    p->str_off = (uint32_t)ix->strs_len;
+    p->str_len = (uint16_t)kv_len;
+    ix->strs_len += kv_len;
+
+    size_t i = hash & (ix->nslots - 1);
+    while (ix->slots[i])
+      i = (i + 1) & (ix->nslots - 1);
+    ix->slots[i] = (uint32_t)k + 1u;
+  }
+  return post_add(&ix->posts[k], series_id);
+}
+
+void pc_tagindex_remove(pc_tagindex_t *ix, const char *kv, size_t kv_len, uint16_t series_id)
+{
+  if (!ix || !kv || kv_len == 0 || kv_len > PC_TAG_KV_MAX)
+    return;
+  int32_t k = find_post(ix, kv, kv_len, pc_fnv1a(kv, kv_len));
+  if (k < 0)
+    return;
+  pc_tag_posting_t *p = &ix->posts[k];
+  if (p->dense)
+  {
+    uint64_t bit = 1ull << (series_id & 63u);
+    if ((size_t)(series_id >> 6) < p->nwords && (p->words[series_id >> 6] & bit))
+    {
+      p->words[series_id >> 6] &= ~bit;
+      p->card--;
+    }
+    return;
+  }
+  for (uint32_t i = 0; i < p->card; ++i)
+  {
+    if (p->ids[i] != series_id)
+      continue;
+    memmove(p->ids + i, p->ids + i + 1, (p->card - i - 1) * sizeof(*p->ids));
+    p->card--;
+    return;
+  }
+}
+
+static int by_card(const void *a, const void *b)
+{
+  uint32_t x = (*(const pc_tag_posting_t *const *)a)->card;
+  uint32_t y = (*(const pc_tag_posting_t *const *)b)->card;
+  return (x > y) - (x < y);
+}
+
+pc_result_t pc_tagindex_select(const pc_tagindex_t *ix, const pc_tag_t *tags, size_t ntags,
+                               pc_series_set_t *out)
+{
+  if (!ix || !out || !tags || ntags == 0 || ntags > PC_TAGINDEX_SELECT_MAX)
+    return PC_EINVAL;
+
+  const pc_tag_posting_t *posts[PC_TAGINDEX_SELECT_MAX];
+  for (size_t i = 0; i < ntags; ++i)
+  {
+    if (!tags[i].key || !tags[i].value)
+      return PC_EINVAL;
+    char kv[PC_TAG_KV_MAX];
+    size_t kl = strlen(tags[i].key), vl = strlen(tags[i].value);
+    if (kl + 1 + vl > sizeof(kv))
+      return set_resize(out, 0);
+    memcpy(kv, tags[i].key, kl);
+    kv[kl] = '=';
+    memcpy(kv + kl + 1, tags[i].value, vl);
+    int32_t k = find_post(ix, kv, kl + 1 + vl, pc_fnv1a(kv, kl + 1 + vl));
+    if (k < 0)
+      return set_resize(out, 0); // nothing can match
+    posts[i] = &ix->posts[k];
+  }
+  qsort(posts, ntags, sizeof(posts[0]), by_card);
+
+  // Expand the smallest posting; the result never outgrows it.
+  const pc_tag_posting_t *p0 = posts[0];
+  size_t nwords = p0->dense ? p0->nwords : (p0->card ? words_for(p0->ids[p0->card - 1]) : 0);
+  pc_result_t st = set_resize(out, nwords);
+  if (st != PC_OK)
+    return st;
+  if (p0->dense)
+    memcpy(out->words, p0->words, nwords * sizeof(*out->words));
+  else
+    for (uint32_t i = 0; i < p0->card; ++i)
+      out->words[p0->ids[i] >> 6] |= 1ull << (p0->ids[i] & 63u);
+
+  for (size_t t = 1; t < ntags; ++t)
+  {
+    const pc_tag_posting_t *p = posts[t];
+    if (p->dense)
+    {
+      size_t n = p->nwords < out->nwords ? p->nwords : out->nwords;
+      for (size_t w = 0; w < n; ++w)
+        out->words[w] &= p->words[w];
+      memset(out->words + n, 0, (out->nwords - n) * sizeof(*out->words));
+    }
+    else
+    {
+      // Array posting: build its words on the fly and AND word by word.
+      size_t w = 0;
+      uint32_t i = 0;
+      for (; w < out->nwords; ++w)
+      {
+        uint64_t m = 0;
+        while (i < p->card && (size_t)(p->ids[i] >> 6) == w)
+        {
+          m |= 1ull << (p->ids[i] & 63u);
+          i++;
+        }
+        out->words[w] &= m;
+      }
+    }
+  }
+
+  for (size_t w = 0; w < out->nwords; ++w)
+    out->count += (size_t)__builtin_popcountll(out->words[w]);
+  return PC_OK;
+}
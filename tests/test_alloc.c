@@ -1,7 +1,16 @@
 // PR-010 tests: allocator rotates across segments and returns NO_SPACE when full.
+// PR-033 tests: wear-aware policies, retirement at wear_limit, static wear
+// leveling through pc_db_wear_level_step, and mount with relocation leftovers
+// (an identical copy next to the original, or only the copy)
+// PR-034 tests: per-sector states, the pre-erased pool (blank sectors join
+// without an erase), flushes that never erase while the pool keeps up, and
+// remounts with superseded snapshot parts left for the refill
+// PR-035 tests: the mount seeds every sector state and the free bitmap across
+// several words; acquire follows the map without reading flash
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include "pc_api.h"
 #include "pc_recover.h"
 
@@ -14,8 +23,307 @@ static void expect(int cond, const char *msg)
   }
 }
 
+static void erase_n(pc_flash_t *f, size_t idx, int n)
+{
+  for (int k = 0; k < n; ++k)
+    expect(pc_flash_erase_sector(f, idx) == PC_OK, "erase");
+}
+
+static void policies(void)
+{
+  const size_t SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, 8 * SEG, SEG, PROG, 0xFF), "flash init");
+  // wear: 5 3 3 7 1 9 1 2
+  const int wear[8] = {5, 3, 3, 7, 1, 9, 1, 2};
+  for (size_t i = 0; i < 8; ++i)
+    erase_n(&f, i, wear[i]);
+  pc_alloc_t a;
+  expect(pc_alloc_init(&a, &f) == PC_OK, "alloc init");
+  expect(a.policy == PC_ALLOC_NEXT && a.wear_limit == 0, "defaults");
+
+  size_t base = 0;
+  expect(pc_alloc_acquire(&a, &base) == PC_OK && base == 0, "next: circular");
+  expect(pc_alloc_acquire_policy(&a, PC_ALLOC_LEAST_WORN, &base) == PC_OK && base == 4 * SEG,
+         "least worn, first in circular order");
+  expect(pc_alloc_acquire_policy(&a, PC_ALLOC_LEAST_WORN, &base) == PC_OK && base == 6 * SEG,
+         "the tie is taken next");
+  expect(pc_alloc_acquire_policy(&a, PC_ALLOC_MOST_WORN, &base) == PC_OK && base == 5 * SEG, "most worn");
+  // Acquired sectors are not handed out again
+  pc_appender_t app;
+  expect(pc_appender_open(&app, &f, 5 * SEG, 1) == PC_OK && pc_appender_commit(&app, PC_SEG_DATA) == PC_OK,
+         "commit");
+  expect(pc_alloc_acquire_policy(&a, PC_ALLOC_MOST_WORN, &base) == PC_OK && base == 3 * SEG,
+         "committed sector skipped");
+
+  // Static wear leveling candidate: the least-worn sector holding data
+  // (opening the appender erased sector 5 once more: 10)
+  uint64_t in_use = (1u << 5) | (1u << 4) | (1u << 1);
+  size_t idx = 0;
+  expect(pc_alloc_cold_sector(&a, &in_use, 8, &idx) == PC_OK && idx == 4, "cold sector");
+  expect(pc_alloc_cold_sector(&a, &in_use, 9, &idx) == PC_ITER_END, "balanced enough");
+
+  // Retirement: only sectors erased fewer than wear_limit times are handed out
+  a.wear_limit = 3;
+  a.policy = PC_ALLOC_MOST_WORN;
+  expect(pc_alloc_acquire(&a, &base) == PC_OK && base == 7 * SEG, "most worn below the limit");
+  a.wear_limit = 1;
+  expect(pc_alloc_acquire(&a, &base) == PC_FLASH_WEAR, "all free sectors retired");
+  pc_alloc_deinit(&a);
+  pc_flash_free(&f);
+}
+
+static void write_points(pc_db_t *db, uint32_t n, uint32_t ts0)
+{
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    expect(pc_write(db, 1, 0, ts0 + i, (float)(ts0 + i)) == PC_OK, "write");
+    if (pc_ring_size(&db->ring) >= 256)
+      expect(pc_db_flush_once(db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(db) == PC_OK, "flush all");
+}
+
+static uint32_t count_range(pc_db_t *db, uint32_t t0, uint32_t t1)
+{
+  static uint32_t ts[4096];
+  static float val[4096];
+  uint32_t n = 0;
+  expect(pc_query_range(db, 1, t0, t1, ts, val, 4096, &n) == PC_OK, "range");
+  return n;
+}
+
+// Copy sector 'from' (header included) into the free sector 'to'
+static void clone_sector(pc_flash_t *f, size_t from, size_t to)
+{
+  static uint8_t img[4096];
+  const size_t seg = pc_flash_sector_bytes(f);
+  expect(pc_flash_read(f, from * seg, img, seg) == PC_OK, "read sector");
+  expect(pc_flash_program(f, to * seg, img, seg) == PC_OK, "program copy");
+}
+
+static size_t first_free(const pc_flash_t *f)
+{
+  pc_segment_hdr_t h;
+  for (size_t i = 0; i < pc_flash_sector_count(f); ++i)
+    if (pc_recover_sector_state(f, i, &h) == PC_SECT_FREE)
+      return i;
+  return SIZE_MAX;
+}
+
+static void wear_leveling(void)
+{
+  const size_t SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, 16 * SEG, SEG, PROG, 0xFF), "flash init");
+  pc_db_config_t cfg;
+  pc_db_config_default(&cfg);
+  cfg.index_interval = 0;
+  cfg.alloc_policy = PC_ALLOC_LEAST_WORN;
+  cfg.wear_delta = 8;
+  pc_db_t db;
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "open");
+  expect(db.alloc.policy == PC_ALLOC_LEAST_WORN && db.wear_delta == 8, "config applied");
+
+  // Cold data, then hot churn on every other sector
+  write_points(&db, 1000, 1);
+  const size_t cold = db.catalog.count;
+  expect(cold >= 2, "cold segments");
+  size_t n = 0;
+  expect(pc_db_wear_level_step(&db, 4, &n) == PC_OK && n == 0, "balanced: nothing moves");
+  pc_segment_hdr_t h;
+  for (size_t i = 0; i < 16; ++i)
+    if (pc_recover_sector_state(&f, i, &h) == PC_SECT_FREE)
+      erase_n(&f, i, 20);
+
+  expect(pc_db_wear_level_step(&db, 1, &n) == PC_OK && n == 1, "one move per step");
+  expect(pc_db_wear_level_step(&db, 100, &n) == PC_OK, "step");
+  expect(db.segments_relocated >= cold, "cold segments relocated");
+  expect(db.catalog.count == cold, "same segments");
+  for (size_t k = 0; k < db.catalog.count; ++k)
+    if (db.catalog.segs[k].type == PC_SEG_DATA)
+      expect(f.wear[db.catalog.segs[k].base / SEG] >= 20, "cold data on worn sectors");
+  expect(count_range(&db, 1, 1000) == 1000, "relocated data readable");
+  pc_db_deinit(&db);
+
+  // Remount from the snapshot written after the moves
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "reopen");
+  expect(count_range(&db, 1, 1000) == 1000, "data after remount");
+  const size_t total = db.catalog.count;
+
+  // Crash after the copy committed: two identical segments, one is kept
+  const pc_seg_summary_t s0 = db.catalog.segs[0];
+  const size_t to = first_free(&f);
+  expect(to != SIZE_MAX, "free sector");
+  clone_sector(&f, s0.base / SEG, to);
+  pc_db_deinit(&db);
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "reopen with duplicate");
+  expect(db.catalog.count == total, "duplicate dropped");
+  expect(pc_recover_sector_state(&f, to, &h) == PC_SECT_FREE ||
+             pc_recover_sector_state(&f, s0.base / SEG, &h) == PC_SECT_FREE,
+         "one copy erased");
+  expect(count_range(&db, 1, 1000) == 1000, "data once");
+  pc_db_deinit(&db);
+
+  // Crash after the original was erased, before the snapshot: the copy is adopted
+  const size_t to2 = first_free(&f);
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "reopen");
+  const pc_seg_summary_t s1 = db.catalog.segs[0];
+  pc_db_deinit(&db);
+  clone_sector(&f, s1.base / SEG, to2);
+  expect(pc_flash_erase_sector(&f, s1.base / SEG) == PC_OK, "erase original");
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "reopen with moved segment");
+  expect(db.catalog.count == total, "moved segment adopted");
+  expect(pc_catalog_find_base(&db.catalog, to2 * SEG) != NULL, "at its new home");
+  expect(count_range(&db, 1, 1000) == 1000, "data after adoption");
+
+  // Epoch devices keep circular allocation
+  pc_db_deinit(&db);
+  pc_flash_t g = {0};
+  expect(pc_flash_init(&g, 16 * SEG, SEG, PROG, 0xFF), "flash2 init");
+  expect(pc_db_open(&db, &g, &cfg) == PC_OK, "open 2");
+  expect(pc_db_enable_epochs(&db) == PC_OK && db.alloc.policy == PC_ALLOC_NEXT, "epochs: next");
+  pc_db_deinit(&db);
+  pc_flash_free(&g);
+  pc_flash_free(&f);
+}
+
+static void pool(void)
+{
+  const size_t SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, 16 * SEG, SEG, PROG, 0xFF), "flash init");
+  // Sector 2: a torn write (data pages, no header)
+  uint8_t junk[256];
+  memset(junk, 0x5A, sizeof junk);
+  expect(pc_flash_program(&f, 2 * SEG, junk, PROG) == PC_OK, "torn write");
+
+  pc_alloc_t a;
+  expect(pc_alloc_init(&a, &f) == PC_OK, "alloc init");
+  expect(a.state[2] == PC_ALLOC_UNKNOWN && pc_alloc_state(&a, 2) == PC_ALLOC_FREE_DIRTY, "probed once");
+  a.pool_target = 4;
+  size_t n = 0;
+  expect(pc_alloc_refill_step(&a, 8, &n) == PC_OK && a.erased == 4, "pool filled");
+  expect(n == 1 && f.wear[2] == 1 && f.wear[0] == 0, "only the torn sector erased");
+  expect(pc_alloc_refill_step(&a, 8, &n) == PC_OK && n == 0, "pool full");
+
+  size_t base = 0;
+  bool erased = false;
+  expect(pc_alloc_acquire_ex(&a, PC_ALLOC_NEXT, &base, &erased) == PC_OK && base == 0 && erased, "pre-erased");
+  expect(a.erased == 3 && pc_alloc_state(&a, 0) == PC_ALLOC_OPEN, "open");
+  pc_appender_t app;
+  expect(pc_appender_open_erased(&app, &f, base, 1) == PC_OK && pc_appender_commit(&app, PC_SEG_DATA) == PC_OK,
+         "commit without erase");
+  pc_alloc_commit(&a, base);
+  expect(f.wear[0] == 0 && pc_alloc_state(&a, 0) == PC_ALLOC_COMMITTED, "committed, never erased");
+
+  // Wear-aware policies take erased sectors first
+  erase_n(&f, 9, 3);
+  pc_alloc_release(&a, 9 * SEG, true);
+  expect(pc_alloc_acquire_ex(&a, PC_ALLOC_LEAST_WORN, &base, &erased) == PC_OK && erased && base == 1 * SEG,
+         "least worn erased sector");
+  a.next_index = 0;
+  a.erased = 0; // (pretend the pool ran dry)
+  for (size_t i = 0; i < 16; ++i)
+    if (a.state[i] == PC_ALLOC_FREE_ERASED)
+      a.state[i] = PC_ALLOC_FREE_DIRTY;
+  expect(pc_alloc_acquire_ex(&a, PC_ALLOC_NEXT, &base, &erased) == PC_OK && !erased && a.pool_misses == 1,
+         "miss counted");
+  pc_alloc_release(&a, 0, false);
+  expect(pc_alloc_state(&a, 0) == PC_ALLOC_FREE_DIRTY, "released dirty");
+  pc_alloc_deinit(&a);
+
+  // Database: no erase on the flush path while the pool keeps up
+  for (int epochs = 0; epochs < 2; ++epochs)
+  {
+    pc_flash_t g = {0};
+    expect(pc_flash_init(&g, 16 * SEG, SEG, PROG, 0xFF), "flash2 init");
+    for (size_t i = 0; i < 16; ++i)
+      expect(pc_flash_program(&g, i * SEG, junk, PROG) == PC_OK, "dirty device");
+    pc_db_config_t cfg;
+    pc_db_config_default(&cfg);
+    cfg.index_interval = 2;
+    cfg.erased_pool = 3;
+    cfg.retention.min_free_segments = 2;
+    pc_db_t db;
+    expect(pc_db_open(&db, &g, &cfg) == PC_OK, "open");
+    if (epochs)
+      expect(pc_db_enable_epochs(&db) == PC_OK, "epochs");
+    expect(pc_db_erase_step(&db, 8, &n) == PC_OK && n == 3 && db.alloc.erased == 3, "refill");
+    db.alloc.pool_misses = 0;
+
+    uint32_t ts = 1;
+    for (int round = 0; round < 40; ++round)
+    {
+      for (uint32_t i = 0; i < 200; ++i, ++ts)
+        expect(pc_write(&db, 1, 0, ts, (float)ts) == PC_OK, "write");
+      expect(pc_db_flush_until_empty(&db) == PC_OK, "flush");
+      expect(pc_db_reclaim_step(&db, 2, NULL) == PC_OK, "reclaim");
+      expect(pc_db_erase_step(&db, 4, NULL) == PC_OK, "erase step");
+    }
+    expect(db.catalog.count > 4, "segments written");
+    expect(db.alloc.pool_misses == 0, "flusher only took erased sectors");
+    const size_t count = db.catalog.count;
+    float v = 0;
+    uint32_t lt = 0;
+    pc_db_deinit(&db);
+
+    expect(pc_db_open(&db, &g, &cfg) == PC_OK, "reopen");
+    expect(db.catalog.count == count, "same catalog");
+    expect(pc_query_latest(&db, 1, &v, &lt) == PC_OK && lt == ts - 1, "newest point");
+    pc_db_deinit(&db);
+    pc_flash_free(&g);
+  }
+  pc_flash_free(&f);
+}
+
+static void bitmap(void)
+{
+  const size_t SEG = 4096, PROG = 256, N = 200;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, N * SEG, SEG, PROG, 0xFF), "flash init");
+  for (size_t i = 0; i < N; ++i)
+  {
+    if (i == 7 || i == 150 || i == 199)
+      continue;
+    pc_appender_t app;
+    expect(pc_appender_open(&app, &f, i * SEG, (uint32_t)(i + 1)) == PC_OK &&
+               pc_appender_commit(&app, PC_SEG_DATA) == PC_OK,
+           "fill");
+  }
+
+  pc_db_t db;
+  expect(pc_db_open(&db, &f, NULL) == PC_OK, "open");
+  size_t nfree = 0;
+  for (size_t i = 0; i < N; ++i)
+  {
+    expect(db.alloc.state[i] != PC_ALLOC_UNKNOWN, "state known after mount");
+    const bool bit = (db.alloc.free_map[i / 64] >> (i % 64)) & 1u;
+    expect(bit == (db.alloc.state[i] == PC_ALLOC_FREE_DIRTY), "map matches states");
+    nfree += bit;
+  }
+  expect(nfree == 3, "three free sectors");
+
+  // A header appearing behind the allocator's back is not seen: no flash reads
+  f.mem[150 * SEG + SEG - PROG] = 0x00;
+  size_t base = 0;
+  expect(pc_alloc_acquire(&db.alloc, &base) == PC_OK && base == 199 * SEG, "after the newest segment");
+  expect(pc_alloc_acquire(&db.alloc, &base) == PC_OK && base == 7 * SEG, "wraps to the first word");
+  expect(pc_alloc_acquire(&db.alloc, &base) == PC_OK && base == 150 * SEG, "taken from the map");
+  expect(pc_alloc_acquire(&db.alloc, &base) == PC_NO_SPACE, "map empty");
+  pc_alloc_release(&db.alloc, 7 * SEG, true);
+  expect(pc_alloc_acquire(&db.alloc, &base) == PC_OK && base == 7 * SEG, "released sector back");
+  pc_db_deinit(&db);
+  pc_flash_free(&f);
+}
+
 int main(void)
 {
+  policies();
+  wear_leveling();
+  pool();
+  bitmap();
+
   // 20KB total → 5 segments of 4KB, prog 256B
   const size_t TOTAL = 20 * 1024, SEG = 4096, PROG = 256;
   pc_flash_t f = {0};
@@ -66,6 +374,7 @@ int main(void)
   }
   // Now allocator should report no space.
   expect(pc_alloc_acquire(&alloc, &dummy_base) == PC_NO_SPACE, "no space after filling");
+  pc_alloc_deinit(&alloc);
 
   pc_db_deinit(&db);
   pc_flash_free(&f);
@@ -1,4 +1,5 @@
 // PR-009 tests: write -> flush -> query_latest
+// PR-031: pc_db_open resumes seqnos and allocation after the newest segment
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -59,8 +60,103 @@ int main(void)
   expect(pc_query_latest(&db, 1, &v, &ts) == PC_OK, "latest m1");
   expect(ts == 3004u && v == 204.0f, "m1 values second batch");
 
+  // PR-012: newest-first with early termination.
+  // Fill several more segments with metric 3; the tail lives in the newest one.
+  for (uint32_t i = 0; i < 1500; ++i)
+  {
+    expect(pc_write(&db, 3, 0, 5000 + i, (float)i) == PC_OK, "write m3");
+    if (pc_ring_size(&db.ring) >= 256)
+      expect(pc_db_flush_once(&db) == PC_OK, "flush m3");
+  }
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush m3 rest");
+  expect(db.catalog.count >= 5, "m3 spans segments");
+
+  size_t dirs0 = db.scan.dirs_loaded;
+  expect(pc_query_latest(&db, 3, &v, &ts) == PC_OK, "latest m3");
+  expect(ts == 6499u && v == 1499.0f, "m3 latest values");
+  expect(db.scan.dirs_loaded - dirs0 == 1, "latest touched only the newest segment");
+
+  uint32_t tts[10];
+  float tval[10];
+  uint32_t tn = 0;
+  dirs0 = db.scan.dirs_loaded;
+  expect(pc_query_tail(&db, 3, 10, tts, tval, &tn) == PC_OK, "tail m3");
+  expect(tn == 10, "tail count");
+  for (uint32_t i = 0; i < 10; ++i)
+    expect(tts[i] == 6490u + i && tval[i] == (float)(1490 + i), "tail ascending");
+  expect(db.scan.dirs_loaded - dirs0 == 1, "tail touched only the newest segment");
+
+  // Tail larger than what exists returns everything found
+  uint32_t big_ts[64];
+  float big_val[64];
+  expect(pc_query_tail(&db, 2, 64, big_ts, big_val, &tn) == PC_OK, "tail m2");
+  expect(tn == 10 && big_ts[0] == 2000u && big_ts[9] == 2009u, "tail m2 all points");
+  expect(pc_query_tail(&db, 77, 4, big_ts, big_val, &tn) == PC_METRIC_UNKNOWN, "tail unknown");
+
+  // PR-013: read-your-writes over the ring and the open segment.
+  expect(pc_write(&db, 3, 0, 7000, 70.0f) == PC_OK, "write pending");
+  expect(pc_query_latest(&db, 3, &v, &ts) == PC_OK && ts == 6499u, "committed view ignores ring");
+  expect(pc_query_latest_ex(&db, 3, PC_READ_YOUR_WRITES, &v, &ts) == PC_OK, "ryw latest (ring)");
+  expect(ts == 7000u && v == 70.0f, "ring point visible");
+  expect(pc_ring_size(&db.ring) == 1, "query did not pop");
+
+  // Into the appender staging page (segment open, nothing programmed for it yet)
+  expect(pc_db_flush_once(&db) == PC_OK, "flush into open segment");
+  expect(db.app_open && pc_ring_is_empty(&db.ring), "segment open, ring drained");
+  expect(pc_write(&db, 3, 0, 7001, 71.0f) == PC_OK, "write pending 2");
+  expect(pc_query_latest(&db, 3, &v, &ts) == PC_OK && ts == 6499u, "committed view ignores open segment");
+  expect(pc_query_latest_ex(&db, 3, PC_READ_YOUR_WRITES, &v, &ts) == PC_OK, "ryw latest (ring+open)");
+  expect(ts == 7001u && v == 71.0f, "newest pending point");
+  expect(pc_query_tail_ex(&db, 3, PC_READ_YOUR_WRITES, 3, tts, tval, &tn) == PC_OK && tn == 3, "ryw tail");
+  expect(tts[0] == 6499u && tts[1] == 7000u && tts[2] == 7001u, "tail merges committed + open + ring");
+
+  // Enough to program whole pages of the open segment
+  for (uint32_t i = 0; i < 100; ++i)
+    expect(pc_write(&db, 4, 0, 8000 + i, (float)i) == PC_OK, "write m4");
+  expect(pc_db_flush_once(&db) == PC_OK && pc_db_flush_once(&db) == PC_OK, "flush m4 into open segment");
+  expect(db.app_open && db.app.seg_off > db.app.prog, "pages programmed");
+  expect(pc_query_latest(&db, 4, &v, &ts) == PC_METRIC_UNKNOWN, "m4 not committed");
+  expect(pc_query_latest_ex(&db, 4, PC_READ_YOUR_WRITES, &v, &ts) == PC_OK && ts == 8099u, "m4 from open segment");
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "commit pending");
+  expect(pc_query_latest(&db, 3, &v, &ts) == PC_OK && ts == 7001u, "committed after flush");
+
   pc_db_deinit(&db);
   pc_flash_free(&f);
+
+  // pc_db_open: no seq_start, no scan by the caller
+  {
+    pc_flash_t g = (pc_flash_t){0};
+    expect(pc_flash_init(&g, 16 * SEG, SEG, PROG, 0xFF), "flash2 init");
+    pc_db_config_t cfg;
+    pc_db_config_default(&cfg);
+    cfg.index_interval = 0;
+    pc_db_t d;
+    expect(pc_db_open(&d, &g, &cfg) == PC_OK, "open fresh");
+    expect(d.next_seq == 1 && d.alloc.next_index == 0, "fresh device starts at the beginning");
+    for (uint32_t i = 0; i < 2000; ++i)
+    {
+      expect(pc_write(&d, 1, 0, 100 + i, (float)i) == PC_OK, "write");
+      if (pc_ring_size(&d.ring) >= 256)
+        expect(pc_db_flush_once(&d) == PC_OK, "flush once");
+    }
+    expect(pc_db_flush_until_empty(&d) == PC_OK, "flush all");
+    const uint32_t next = d.next_seq;
+    const size_t newest = d.catalog.segs[d.catalog.count - 1].base;
+    expect(d.catalog.count >= 3 && newest / SEG == d.catalog.count - 1, "segments in sectors 0..n-1");
+    pc_db_deinit(&d);
+
+    // Reclaim an old sector: a restart must not fill the hole out of order
+    expect(pc_logseg_erase(&g, 1 * SEG) == PC_OK, "erase sector 1");
+    expect(pc_db_open(&d, &g, NULL) == PC_OK, "reopen");
+    expect(d.ring_capacity == PC_DB_RING_CAPACITY_DEFAULT, "default config");
+    expect(d.next_seq == next, "next_seq = max + 1");
+    expect(pc_write(&d, 1, 0, 5000, 1.0f) == PC_OK && pc_db_flush_until_empty(&d) == PC_OK, "write after reopen");
+    const pc_seg_summary_t *last = &d.catalog.segs[d.catalog.count - 1];
+    expect(last->seqno == next && last->base == newest + SEG, "placed after the newest segment");
+    pc_db_deinit(&d);
+    pc_flash_free(&g);
+  }
+
   puts("api: ok");
   return 0;
 }
@@ -1,5 +1,7 @@
 // PR-008 tests: append multiple blocks into a segment and commit.
 // Verifies header fields and total record_count.
+// PR-027: commit CRC comes from the running CRC (no read-back); the paranoid
+//         mode catches flash that differs from what was staged
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -74,6 +76,43 @@ int main(void)
   expect(n == 1, "one segment");
   expect(out[0].seqno == 101 && out[0].record_count == 130, "summary ok");
 
+  // Running CRC == CRC over flash, for empty, partial-page and page-exact fills
+  static uint8_t raw[2 * 256];
+  memset(raw, 0x5A, sizeof raw);
+  for (int i = 0; i < 3; ++i)
+  {
+    expect(pc_appender_open(&a, &f, SEG, 200u + (uint32_t)i) == PC_OK, "reopen");
+    if (i == 1)
+      expect(pc_appender_append_block(&a, 3, 0, ts1, v1, 60) == PC_OK, "append");
+    if (i == 2)
+      expect(pc_appender_append_bytes(&a, raw, 2 * PROG) == PC_OK, "append two whole pages");
+    expect(pc_appender_commit(&a, PC_SEG_DATA) == PC_OK, "commit");
+    uint32_t crc = 0;
+    expect(pc_logseg_crc32c_region(&f, SEG, &crc) == PC_OK && pc_logseg_verify(&f, SEG, &hdr) == PC_OK &&
+               hdr.crc32c == crc,
+           "running crc matches flash");
+  }
+
+  // Flash silently differs from the staged bytes (a stuck bit): the fast commit
+  // does not notice, the paranoid one refuses to commit.
+  expect(pc_appender_open(&a, &f, 2 * SEG, 300) == PC_OK, "open 3");
+  expect(pc_appender_append_block(&a, 1, 0, ts2, v2, 70) == PC_OK, "append 3");
+  f.mem[2 * SEG + 20] &= 0x7F;
+  expect(pc_appender_commit(&a, PC_SEG_DATA) == PC_OK, "fast commit");
+  expect(pc_logseg_verify(&f, 2 * SEG, &hdr) == PC_CORRUPT, "caught by verify later");
+
+  expect(pc_appender_open(&a, &f, 2 * SEG, 301) == PC_OK, "open 4");
+  a.verify_commit = true;
+  expect(pc_appender_append_block(&a, 1, 0, ts2, v2, 70) == PC_OK, "append 4");
+  expect(pc_appender_commit(&a, PC_SEG_DATA) == PC_OK, "paranoid commit of good data");
+  expect(pc_logseg_verify(&f, 2 * SEG, &hdr) == PC_OK, "verified");
+  expect(pc_appender_open(&a, &f, 2 * SEG, 302) == PC_OK, "open 5");
+  a.verify_commit = true;
+  expect(pc_appender_append_block(&a, 1, 0, ts2, v2, 70) == PC_OK, "append 5");
+  f.mem[2 * SEG + 20] &= 0x7F;
+  expect(pc_appender_commit(&a, PC_SEG_DATA) == PC_CORRUPT && pc_appender_is_open(&a), "paranoid commit refused");
+  expect(pc_logseg_header_erased(&f, 2 * SEG), "no header written");
+
   pc_flash_free(&f);
   puts("appender: ok");
   return 0;
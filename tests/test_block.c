@@ -1,5 +1,6 @@
 // PR-007 tests: write one block into a segment and commit it.
 // Verifies header fields and a few bytes of the payload.
+// PR-025: as-of lookup agrees between binary search and the linear fallback
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -67,6 +68,19 @@ int main(void)
   expect(p0.ts == ts[0], "p0 ts");
   expect(p0.value == val[0], "p0 val");
 
+  // As-of lookup: sorted (with duplicates) and unsorted
+  pc_point_disk_t pts[6] = {{10, 1.0f}, {20, 2.0f}, {20, 3.0f}, {30, 4.0f}, {40, 5.0f}, {40, 6.0f}};
+  for (uint32_t t = 0; t < 50; ++t)
+  {
+    uint32_t a = pc_block_find_asof(pts, 6, true, t), b = pc_block_find_asof(pts, 6, false, t);
+    expect(a == b, "binary == linear");
+  }
+  expect(pc_block_find_asof(pts, 6, true, 9) == 6, "before first");
+  expect(pc_block_find_asof(pts, 6, true, 25) == 2, "last of equal ts");
+  expect(pc_block_find_asof(pts, 6, true, 99) == 5, "after last");
+  pc_point_disk_t un[4] = {{30, 1.0f}, {10, 2.0f}, {25, 3.0f}, {10, 4.0f}};
+  expect(pc_block_find_asof(un, 4, false, 20) == 3 && pc_block_find_asof(un, 4, false, 29) == 2, "unsorted");
+
   pc_flash_free(&f);
   puts("block: ok");
   return 0;
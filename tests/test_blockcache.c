@@ -0,0 +1,99 @@
+// PR-021 tests: decoded-block LRU cache
+// - LRU order, byte cap, counters, invalidation by segment base
+// - repeated page-read queries are served from the cache with no flash reads
+// - answers are the same with the cache on and off
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+int main(void)
+{
+  // ---- Cache alone ----
+  pc_blockcache_t c;
+  pc_blockcache_init(&c, 300);
+  uint8_t buf[100];
+  size_t len = 0;
+  for (uint32_t i = 0; i < 3; ++i)
+  {
+    memset(buf, (int)i, sizeof buf);
+    expect(pc_blockcache_put(&c, 4096, 7, i * 100, buf, sizeof buf) == PC_OK, "put");
+  }
+  expect(c.count == 3 && c.bytes == 300, "full");
+  const uint8_t *p = (const uint8_t *)pc_blockcache_get(&c, 4096, 7, 0, &len);
+  expect(p && len == 100 && p[0] == 0, "hit oldest (now most recent)");
+  expect(pc_blockcache_put(&c, 8192, 3, 0, buf, 50) == PC_OK, "put evicts");
+  expect(c.evictions == 1 && !pc_blockcache_get(&c, 4096, 7, 100, &len), "LRU entry evicted");
+  expect(pc_blockcache_get(&c, 4096, 7, 0, &len) != NULL, "recently used kept");
+  expect(!pc_blockcache_get(&c, 4096, 8, 0, &len), "other seqno misses");
+  expect(pc_blockcache_put(&c, 0, 1, 0, buf, 301) == PC_NO_SPACE, "oversized not cached");
+  pc_blockcache_invalidate_base(&c, 4096);
+  expect(c.count == 1 && c.invalidations == 2 && c.bytes == 50, "invalidate by base");
+  expect(c.hits == 2 && c.misses == 2, "counters");
+  for (uint32_t i = 0; i < 200; ++i)
+    expect(pc_blockcache_put(&c, i * 4096u, i, 0, buf, 1) == PC_OK, "many small");
+  expect(pc_blockcache_get(&c, 199u * 4096u, 199, 0, &len) != NULL && len == 1, "after growth");
+  pc_blockcache_free(&c);
+
+  pc_blockcache_init(&c, 0);
+  expect(pc_blockcache_put(&c, 0, 1, 0, buf, 1) == PC_NO_SPACE && !pc_blockcache_get(&c, 0, 1, 0, &len), "disabled");
+  pc_blockcache_free(&c);
+
+  // ---- Behind the query paths (page-read mode) ----
+  const size_t TOTAL = 128 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init");
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 512, 1) == PC_OK, "db init");
+  // Runs of 16 points per metric → 16-point blocks
+  for (uint32_t i = 0; i < 2000; ++i)
+  {
+    expect(pc_write(&db, (uint16_t)(1 + (i / 16) % 4), 0, 1000 + i, (float)i) == PC_OK, "write");
+    if (pc_ring_size(&db.ring) >= 256)
+      expect(pc_db_flush_once(&db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush");
+  db.scan.use_map = false;
+
+  uint16_t ids[4] = {1, 2, 3, 4};
+  pc_range_buf_t rb[4];
+  static uint32_t ts[4][600];
+  static float val[4][600];
+  for (int i = 0; i < 4; ++i)
+    rb[i] = (pc_range_buf_t){ts[i], val[i], 600, 0, 0};
+  expect(pc_query_range_many(&db, ids, 4, 0, UINT32_MAX, rb) == PC_OK, "cold range");
+  size_t reads = db.scan.flash_reads, hits = db.cache.hits;
+  expect(db.cache.count > 0, "blocks cached");
+  expect(pc_query_range_many(&db, ids, 4, 0, UINT32_MAX, rb) == PC_OK, "warm range");
+  expect(db.scan.flash_reads == reads, "warm query reads no flash");
+  expect(db.cache.hits > hits, "hits counted");
+  expect(rb[2].count == 31 * 16 && ts[2][0] == 1032 && val[2][31 * 16 - 1] == 1967.0f, "warm answer");
+
+  float v = 0;
+  uint32_t t = 0;
+  expect(pc_query_latest(&db, 3, &v, &t) == PC_OK && t == 2967 && v == 1967.0f, "latest from cache");
+
+  // Same answers with the cache disabled
+  pc_blockcache_free(&db.cache);
+  pc_blockcache_init(&db.cache, 0);
+  float v2 = 0;
+  uint32_t t2 = 0;
+  reads = db.scan.flash_reads;
+  expect(pc_query_latest(&db, 3, &v2, &t2) == PC_OK && v2 == v && t2 == t, "uncached latest");
+  expect(db.scan.flash_reads > reads, "uncached query reads flash");
+
+  pc_db_deinit(&db);
+  pc_flash_free(&f);
+  puts("blockcache: ok");
+  return 0;
+}
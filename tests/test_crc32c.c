@@ -1,9 +1,16 @@
+// PR-003 tests: CRC32C test vector, streaming, parity
+// PR-026: every available implementation matches the reference table loop
+//         over many lengths, alignments and stream splits
+// PR-026 fix: concurrent first calls (tables built once) agree
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include "pc_crc32c.h"
 #include "pc_parity.h"
+#if PC_THREADS
+#include <pthread.h>
+#endif
 
 static void expect(int cond, const char *msg)
 {
@@ -14,8 +21,37 @@ static void expect(int cond, const char *msg)
   }
 }
 
+#if PC_THREADS
+static void *first_call(void *arg)
+{
+  static uint8_t big[65536];
+  uint32_t *out = (uint32_t *)arg;
+  out[0] = pc_crc32c("123456789", 9);
+  out[1] = pc_crc32c(big, sizeof big);
+  out[2] = pc_crc32c_update_with(PC_CRC32C_IMPL_TABLE, PC_CRC32C_SEED, big, sizeof big);
+  return NULL;
+}
+#endif
+
 int main(void)
 {
+#if PC_THREADS
+  // Before any other call: several threads race the one-time table setup
+  {
+    pthread_t t[8];
+    uint32_t got[8][3];
+    for (int i = 0; i < 8; ++i)
+      expect(pthread_create(&t[i], NULL, first_call, got[i]) == 0, "thread");
+    for (int i = 0; i < 8; ++i)
+      pthread_join(t[i], NULL);
+    for (int i = 0; i < 8; ++i)
+    {
+      expect(got[i][0] == 0xE3069283u, "racing first call");
+      expect(got[i][1] == PC_CRC32C_FINALIZE(got[i][2]), "racing calls match the table loop");
+    }
+  }
+#endif
+
   // Standard test vector for CRC32C (Castagnoli): "123456789"
   const char *s = "123456789";
   uint32_t one_shot = pc_crc32c(s, 9);
@@ -28,6 +64,42 @@ int main(void)
   uint32_t final = PC_CRC32C_FINALIZE(crc);
   expect(final == one_shot, "crc32c streaming matches one-shot");
 
+  // Cross-check the accelerated paths against the reference loop
+  static uint8_t buf[8192 + 16];
+  uint32_t x = 12345u;
+  for (size_t i = 0; i < sizeof buf; ++i)
+  {
+    x = x * 1103515245u + 12345u;
+    buf[i] = (uint8_t)(x >> 16);
+  }
+  expect(pc_crc32c_available(PC_CRC32C_IMPL_TABLE) && pc_crc32c_available(PC_CRC32C_IMPL_SLICE8), "software paths");
+  printf("crc32c: active = %s\n", pc_crc32c_impl_name(pc_crc32c_active()));
+  for (int impl = 0; impl < PC_CRC32C_IMPL_COUNT; ++impl)
+  {
+    if (!pc_crc32c_available((pc_crc32c_impl_t)impl))
+      continue;
+    expect(PC_CRC32C_FINALIZE(pc_crc32c_update_with((pc_crc32c_impl_t)impl, PC_CRC32C_SEED, s, 9)) == 0xE3069283u,
+           "impl test vector");
+    for (size_t len = 0; len <= 8192; len = len < 64 ? len + 1 : len * 3 / 2 + 7)
+    {
+      for (size_t off = 0; off < 8; off += 3)
+      {
+        uint32_t want = pc_crc32c_update_with(PC_CRC32C_IMPL_TABLE, PC_CRC32C_SEED, buf + off, len);
+        expect(pc_crc32c_update_with((pc_crc32c_impl_t)impl, PC_CRC32C_SEED, buf + off, len) == want, "impl == table");
+        size_t cut = len / 3;
+        uint32_t c = pc_crc32c_update_with((pc_crc32c_impl_t)impl, PC_CRC32C_SEED, buf + off, cut);
+        c = pc_crc32c_update_with((pc_crc32c_impl_t)impl, c, buf + off + cut, len - cut);
+        expect(c == want, "impl streaming == table");
+      }
+    }
+  }
+  // Exact multiples of the interleaved chunk sizes
+  const size_t sizes[] = {384, 768, 3072, 3072 + 384, 6144};
+  for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; ++i)
+    expect(pc_crc32c_update(PC_CRC32C_SEED, buf, sizes[i]) ==
+               pc_crc32c_update_with(PC_CRC32C_IMPL_TABLE, PC_CRC32C_SEED, buf, sizes[i]),
+           "chunk multiples");
+
   // Parity sanity
   uint8_t p1 = pc_parity8("AB", 2); // 'A'^'B' = 0x41 ^ 0x42 = 0x03
   expect(p1 == (uint8_t)(0x41 ^ 0x42), "parity AB");
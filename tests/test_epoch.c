@@ -0,0 +1,131 @@
+// PR-030 tests: epoch markers
+// - enabling writes a snapshot + epoch into the reserved superblock slots
+// - a remount reads only the live headers plus the walk from the allocator head
+//   and rebuilds the same catalog, including segments written after the epoch
+// - segments written after a remount are found by the next one
+// - a torn newest epoch falls back to the other slot
+// - slots that already hold data cannot become a superblock
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+static void write_points(pc_db_t *db, uint32_t n, uint32_t ts0)
+{
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    expect(pc_write(db, (uint16_t)(1 + (i / 50) % 3), 0, ts0 + i, (float)i) == PC_OK, "write");
+    if (pc_ring_size(&db->ring) >= 256)
+      expect(pc_db_flush_once(db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(db) == PC_OK, "flush all");
+}
+
+static void same_latest(pc_db_t *db, uint32_t want_ts, float want_v)
+{
+  float v = 0;
+  uint32_t ts = 0;
+  expect(pc_query_latest(db, 1, &v, &ts) == PC_OK, "latest");
+  expect(ts == want_ts && v == want_v, "same latest");
+}
+
+int main(void)
+{
+  // 1MB → 256 segments of 4KB
+  const size_t TOTAL = 1024 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init");
+
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 512, 1) == PC_OK, "db init");
+  expect(!db.epochs, "no epochs on a fresh device");
+  expect(pc_db_enable_epochs(&db) == PC_OK, "enable");
+  expect(db.epochs && db.alloc.first_index == PC_EPOCH_SLOTS, "slots reserved");
+  pc_epoch_t ep;
+  uint8_t live[64];
+  expect(pc_epoch_load(&f, &ep, live, sizeof live) == PC_OK, "first epoch");
+  expect(ep.next_seq == db.next_seq, "epoch next_seq");
+  db.index_interval = 4;
+
+  // ~30 segments with snapshots + epochs every 4, then a tail after the last one
+  write_points(&db, 14000, 1000);
+  write_points(&db, 900, 20000);
+  expect(db.commits_since_index > 0, "segments after the last epoch");
+  for (size_t k = 0; k < db.catalog.count; ++k)
+    expect(db.catalog.segs[k].base >= PC_EPOCH_SLOTS * SEG, "no data in the slots");
+  const size_t total = db.catalog.count;
+  const uint32_t last_seq = db.next_seq;
+  float v0 = 0;
+  uint32_t t0 = 0;
+  expect(pc_query_latest(&db, 1, &v0, &t0) == PC_OK, "latest before remount");
+  pc_db_deinit(&db);
+
+  // Bounded remount: live headers + walk, not the 256 commit pages
+  pc_db_t db2;
+  expect(pc_db_init(&db2, &f, 512, 1) == PC_OK, "remount");
+  expect(db2.epochs, "epochs detected");
+  expect(db2.catalog.count == total, "same catalog");
+  expect(db2.mount.headers_read < total + 8, "bounded header pass");
+  expect(db2.mount.segments_verified <= 8, "only post-snapshot segments verified");
+  expect(db2.next_seq > last_seq, "seqnos move past the log");
+  same_latest(&db2, t0, v0);
+
+  // Writes after the remount continue the walked chain
+  write_points(&db2, 700, 30000);
+  const size_t total2 = db2.catalog.count;
+  expect(total2 > total, "more segments");
+  pc_db_deinit(&db2);
+  expect(pc_db_init(&db2, &f, 512, 1) == PC_OK, "remount 2");
+  expect(db2.catalog.count == total2, "post-remount segments found");
+  expect(pc_query_latest(&db2, 1, &v0, &t0) == PC_OK, "latest 2");
+  pc_db_deinit(&db2);
+
+  // Tear the newest epoch (clear bits in its payload): the older slot still works
+  {
+    pc_epoch_t a, b;
+    expect(pc_epoch_load(&f, &a, live, sizeof live) == PC_OK, "load newest");
+    size_t slot = 0;
+    for (; slot < PC_EPOCH_SLOTS; ++slot)
+    {
+      pc_segment_hdr_t h;
+      if (pc_logseg_verify(&f, slot * SEG, &h) == PC_OK && h.seqno == a.seqno)
+        break;
+    }
+    expect(slot < PC_EPOCH_SLOTS, "newest slot");
+    uint8_t zero[256];
+    memset(zero, 0, sizeof zero);
+    expect(pc_logseg_program_data(&f, slot * SEG, 0, zero, PROG) == PC_OK, "tamper epoch");
+    expect(pc_epoch_load(&f, &b, live, sizeof live) == PC_OK && b.seqno < a.seqno, "older epoch");
+  }
+  expect(pc_db_init(&db2, &f, 512, 1) == PC_OK, "remount on older epoch");
+  expect(db2.catalog.count == total2, "catalog from older epoch + walk");
+  same_latest(&db2, t0, v0);
+  pc_db_deinit(&db2);
+
+  // A device whose first sectors already hold data cannot take a superblock
+  {
+    pc_flash_t g = {0};
+    expect(pc_flash_init(&g, 64 * SEG, SEG, PROG, 0xFF), "flash2 init");
+    pc_db_t d;
+    expect(pc_db_init(&d, &g, 512, 1) == PC_OK, "db2 init");
+    write_points(&d, 100, 1);
+    expect(pc_db_enable_epochs(&d) == PC_BUSY, "slots in use");
+    expect(!d.epochs && d.alloc.first_index == 0, "unchanged");
+    pc_db_deinit(&d);
+    pc_flash_free(&g);
+  }
+
+  pc_flash_free(&f);
+  puts("epoch: ok");
+  return 0;
+}
@@ -0,0 +1,263 @@
+// PR-022 tests: batch-at-a-time executor
+// - time / value filters compact a batch in place, NaN never passes
+// - operators compose (range → value → aggregate | project)
+// - summarized blocks inside one bucket are folded without decoding
+// - pipelines over the db agree with point-at-a-time answers
+// PR-023 tests: derivative operator
+// - delta / rate / counter reset, state carried across batches
+// - pc_query_rate over a counter spanning many segments
+// PR-024 tests: grid alignment
+// - LOCF and linear fill of two series sampled at different periods
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+// Sink that keeps everything it is pushed
+typedef struct
+{
+  pc_exec_op_t op;
+  uint32_t n, batches;
+  uint32_t ts[4096];
+  float val[4096];
+} capture_t;
+
+static bool capture_push(pc_exec_op_t *op, pc_batch_t *b)
+{
+  capture_t *c = (capture_t *)op;
+  for (uint32_t i = 0; i < b->n && c->n < 4096; ++i, ++c->n)
+  {
+    c->ts[c->n] = b->ts[i];
+    c->val[c->n] = b->val[i];
+  }
+  c->batches++;
+  return true;
+}
+
+static void capture_init(capture_t *c)
+{
+  memset(c, 0, sizeof(*c));
+  c->op.push = capture_push;
+}
+
+static bool count_cb(void *ctx, const uint32_t *ts, const float *val, uint32_t n,
+                     uint16_t metric_id, uint16_t series_id)
+{
+  (void)ts, (void)val, (void)metric_id, (void)series_id;
+  *(uint64_t *)ctx += n;
+  return true;
+}
+
+static pc_batch_t batch; // too big for a comfortable stack frame
+
+int main(void)
+{
+  static capture_t cap;
+
+  // ---- Filters on a hand-made batch ----
+  batch.n = 10;
+  for (uint32_t i = 0; i < 10; ++i)
+  {
+    batch.ts[i] = 100 + i;
+    batch.val[i] = (float)i;
+  }
+  batch.val[7] = NAN;
+  capture_init(&cap);
+  pc_exec_value_t vf;
+  pc_exec_value_init(&vf, 2.0f, 8.0f, &cap.op);
+  pc_exec_range_t tf;
+  pc_exec_range_init(&tf, 101, 108, &vf.op);
+  expect(tf.op.push(&tf.op, &batch), "push");
+  // ts 101..108 → vals 1..8; value 2..8 → 2,3,4,5,6,8 (7 is NaN)
+  expect(cap.n == 6 && cap.ts[0] == 102 && cap.ts[5] == 108 && cap.val[5] == 8.0f, "range + value compaction");
+
+  // Batch entirely inside: passed through untouched
+  batch.n = 10;
+  for (uint32_t i = 0; i < 10; ++i)
+    batch.ts[i] = 100 + i;
+  capture_init(&cap);
+  pc_exec_range_init(&tf, 0, UINT32_MAX, &cap.op);
+  expect(tf.op.push(&tf.op, &batch) && cap.n == 10 && cap.batches == 1, "pass-through");
+
+  // Nothing matches: next is not called
+  capture_init(&cap);
+  pc_exec_range_init(&tf, 500, 600, &cap.op);
+  expect(tf.op.push(&tf.op, &batch) && cap.batches == 0, "empty batch dropped");
+
+  // ---- Aggregate: one-bucket fast path and per-point path ----
+  pc_bucket_t bk[4];
+  pc_exec_agg_t agg;
+  pc_exec_agg_init(&agg, 100, 5, bk, 4);
+  batch.n = 5;
+  for (uint32_t i = 0; i < 5; ++i)
+  {
+    batch.ts[i] = 100 + i;
+    batch.val[i] = (float)(10 - i);
+  }
+  expect(agg.op.push(&agg.op, &batch), "agg push (one bucket)");
+  batch.n = 3;
+  batch.ts[0] = 99;  // before t0: ignored
+  batch.ts[1] = 106; // bucket 1
+  batch.ts[2] = 140; // past the last bucket: ignored
+  batch.val[1] = 1.0f;
+  expect(agg.op.push(&agg.op, &batch), "agg push (split)");
+  pc_exec_agg_finish(&agg, PC_AGG_ALL);
+  expect(bk[0].count == 5 && bk[0].min == 6.0f && bk[0].max == 10.0f && bk[0].sum == 40.0, "bucket 0");
+  expect(bk[1].count == 1 && bk[1].avg == 1.0f && bk[2].count == 0 && bk[3].count == 0, "bucket 1..3");
+
+  // ---- Derivative across two batches ----
+  static uint32_t dts[16];
+  static float dval[16];
+  pc_exec_buf_t buf;
+  pc_exec_buf_init(&buf, dts, dval, 16);
+  pc_exec_deriv_t dv;
+  pc_exec_deriv_init(&dv, PC_DERIVE_RATE | PC_DERIVE_COUNTER, &buf.op);
+  batch.metric_id = 1;
+  batch.series_id = 0;
+  batch.n = 3;
+  const uint32_t t_a[3] = {10, 12, 14};
+  const float v_a[3] = {100.0f, 104.0f, 110.0f};
+  memcpy(batch.ts, t_a, sizeof t_a);
+  memcpy(batch.val, v_a, sizeof v_a);
+  expect(dv.op.push(&dv.op, &batch), "deriv push 1");
+  const uint32_t t_b[3] = {14, 18, 20}; // duplicate ts dropped; reset at 18
+  const float v_b[3] = {111.0f, 8.0f, 12.0f};
+  memcpy(batch.ts, t_b, sizeof t_b);
+  memcpy(batch.val, v_b, sizeof v_b);
+  batch.n = 3;
+  expect(dv.op.push(&dv.op, &batch), "deriv push 2");
+  expect(buf.count == 4 && dts[0] == 12 && dval[0] == 2.0f && dval[1] == 3.0f, "rate within batch");
+  expect(dts[2] == 18 && dval[2] == 2.0f && dts[3] == 20 && dval[3] == 2.0f, "rate across batches + reset");
+
+  pc_exec_buf_init(&buf, dts, dval, 16);
+  pc_exec_deriv_init(&dv, PC_DERIVE_DELTA, &buf.op);
+  memcpy(batch.ts, t_a, sizeof t_a);
+  memcpy(batch.val, v_a, sizeof v_a);
+  batch.n = 3;
+  expect(dv.op.push(&dv.op, &batch), "delta push");
+  batch.series_id = 1; // other series: starts over
+  memcpy(batch.ts, t_a, sizeof t_a); // (the batch was rewritten in place)
+  memcpy(batch.val, v_a, sizeof v_a);
+  batch.n = 3;
+  expect(dv.op.push(&dv.op, &batch), "delta push other series");
+  expect(buf.count == 4 && dval[0] == 4.0f && dval[1] == 6.0f && dts[2] == 12, "delta resets on series change");
+
+  // ---- Over the db ----
+  const size_t TOTAL = 128 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init");
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 512, 1) == PC_OK, "db init");
+  // 32-point runs per metric → summarized blocks
+  for (uint32_t i = 0; i < 3000; ++i)
+  {
+    expect(pc_write(&db, (uint16_t)(1 + (i / 32) % 3), 0, 1000 + i, (float)(i % 50)) == PC_OK, "write");
+    if (pc_ring_size(&db.ring) >= 256)
+      expect(pc_db_flush_once(&db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush");
+
+  // One bucket over everything: every block is folded from its summary.
+  pc_exec_agg_init(&agg, 0, UINT32_MAX, bk, 1);
+  pc_exec_spec_t spec = {2, PC_SERIES_ANY, NULL, 0, UINT32_MAX, NULL, 0};
+  pc_exec_src_t *src = (pc_exec_src_t *)malloc(sizeof(*src));
+  expect(src != NULL, "alloc src");
+  pc_exec_src_init(src, &spec, &agg.op);
+  size_t decoded = db.scan.blocks_read;
+  pc_exec_run_catalog(src, &db.scan, &db.catalog);
+  pc_exec_src_finish(src);
+  pc_exec_agg_finish(&agg, PC_AGG_ALL);
+  expect(bk[0].count == 31 * 32, "count via summaries");
+  expect(db.scan.blocks_read == decoded, "no block decoded");
+
+  // range → value → capture agrees with pc_query_range filtered by hand
+  static uint32_t rts[2000];
+  static float rval[2000];
+  uint32_t rn = 0;
+  expect(pc_query_range(&db, 3, 1500, 2600, rts, rval, 2000, &rn) == PC_OK, "range");
+  uint32_t want = 0;
+  for (uint32_t i = 0; i < rn; ++i)
+    want += rval[i] >= 10.0f && rval[i] <= 20.0f;
+  capture_init(&cap);
+  pc_exec_value_init(&vf, 10.0f, 20.0f, &cap.op);
+  pc_exec_range_init(&tf, 1500, 2600, &vf.op);
+  spec = (pc_exec_spec_t){3, PC_SERIES_ANY, NULL, 1500, 2600, NULL, 0};
+  pc_exec_src_init(src, &spec, &tf.op);
+  pc_exec_run_catalog(src, &db.scan, &db.catalog);
+  pc_exec_src_finish(src);
+  expect(want > 0 && cap.n == want, "filtered pipeline matches");
+  for (uint32_t i = 0; i < cap.n; ++i)
+    expect(cap.ts[i] >= 1500 && cap.ts[i] <= 2600 && cap.val[i] >= 10.0f && cap.val[i] <= 20.0f, "filtered point");
+
+  // Aggregate and scan (both on the executor) agree with the range query
+  pc_bucket_t out[12];
+  expect(pc_query_aggregate(&db, 3, PC_SERIES_ANY, 1500, 2600, 100, PC_AGG_ALL, out, 12) == PC_OK, "aggregate");
+  uint32_t total = 0;
+  for (int k = 0; k < 12; ++k)
+    total += out[k].count;
+  expect(total == rn, "aggregate count");
+  uint64_t seen = 0;
+  pc_query_filter_t flt = {3, PC_SERIES_ANY, 1500, 2600, 0, 0, PC_READ_COMMITTED, NULL};
+  expect(pc_query_scan(&db, &flt, count_cb, &seen) == PC_OK && seen == rn, "scan count");
+
+  // Counter +3 every 2 s across many segments, reset to 0 at ts 4000
+  for (uint32_t i = 0; i < 1500; ++i)
+  {
+    uint32_t ts = 3000 + 2 * i;
+    float v = ts < 4000 ? (float)(3 * i) : (float)(3 * (i - 500));
+    expect(pc_write(&db, 9, 4, ts, v) == PC_OK, "write counter");
+    if (pc_ring_size(&db.ring) >= 256)
+      expect(pc_db_flush_once(&db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush counter");
+  static uint32_t qts[2000];
+  static float qval[2000];
+  uint32_t qn = 0;
+  expect(pc_query_rate(&db, 9, 4, 0, UINT32_MAX, qts, qval, 2000, &qn) == PC_OK, "rate");
+  expect(qn == 1499 && qts[0] == 3002, "rate count");
+  for (uint32_t i = 0; i < qn; ++i)
+    expect(qval[i] == (qts[i] == 4000 ? 0.0f : 1.5f), "rate value");
+  expect(pc_query_derive(&db, 9, 4, 3000, 3010, PC_DERIVE_DELTA, qts, qval, 2000, &qn) == PC_OK &&
+             qn == 5 && qval[4] == 3.0f,
+         "delta window");
+  expect(pc_query_rate(&db, 9, PC_SERIES_ANY, 0, 10, qts, qval, 2000, &qn) == PC_EINVAL, "wildcard rejected");
+  expect(pc_query_rate(&db, 9, 4, 0, 10, qts, qval, 2000, &qn) == PC_METRIC_UNKNOWN, "nothing in window");
+
+  // Two series at different periods: (10,0) every 10 s, (10,1) every 7 s from +3
+  for (uint32_t i = 0; i < 50; ++i)
+    expect(pc_write(&db, 10, 0, 5000 + 10 * i, (float)i) == PC_OK, "write s0");
+  for (uint32_t i = 0; i < 70; ++i)
+    expect(pc_write(&db, 10, 1, 5003 + 7 * i, (float)(100 + i)) == PC_OK, "write s1");
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush align");
+  const pc_series_t keys[2] = {{10, 0}, {10, 1}};
+  static float grid[99 * 2];
+  expect(pc_query_align(&db, keys, 2, 5000, 5490, 5, PC_FILL_LOCF, grid, 98) == PC_EINVAL, "grid too small");
+  expect(pc_query_align(&db, keys, 2, 0, UINT32_MAX, 1, PC_FILL_LOCF, grid, 99) == PC_EINVAL, "full range rows");
+  expect(pc_query_align(&db, keys, 2, 5000, 5490, 5, PC_FILL_LOCF, grid, 99) == PC_OK, "align locf");
+  for (uint32_t k = 0; k < 99; ++k)
+    expect(grid[k * 2] == (float)(k / 2), "locf s0");
+  expect(isnan(grid[1]) && grid[3] == 100.0f && grid[2 * 2 + 1] == 101.0f && grid[98 * 2 + 1] == 169.0f, "locf s1");
+
+  expect(pc_query_align(&db, keys, 2, 5000, 5490, 5, PC_FILL_LINEAR, grid, 99) == PC_OK, "align linear");
+  for (uint32_t k = 0; k < 99; ++k)
+    expect(fabsf(grid[k * 2] - 0.5f * (float)k) < 1e-4f, "linear s0");
+  expect(isnan(grid[1]) && fabsf(grid[3] - (100.0f + 2.0f / 7.0f)) < 1e-4f, "linear s1 start");
+  expect(isnan(grid[98 * 2 + 1]) && fabsf(grid[97 * 2 + 1] - (168.0f + 6.0f / 7.0f)) < 1e-4f, "linear s1 past last sample");
+
+  free(src);
+  pc_db_deinit(&db);
+  pc_flash_free(&f);
+  printf("exec OK\n");
+  return 0;
+}
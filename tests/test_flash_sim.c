@@ -68,6 +68,13 @@ int main(void)
   uint8_t buf[SECTOR]; // size not used fully
   expect(pc_flash_read(&f, SECTOR, buf, PROG) == PC_FLASH_IO, "read bad");
 
+  // Zero-copy map: same checks as read, view tracks the device contents
+  const void *view = NULL;
+  expect(pc_flash_map(&f, 0, PROG, &view) == PC_OK, "map ok");
+  expect(((const uint8_t *)view)[0] == 0xF0 && ((const uint8_t *)view)[1] == 0xFF, "map contents");
+  expect(pc_flash_map(&f, SECTOR - PROG, 2 * PROG, &view) == PC_FLASH_IO, "map spans bad");
+  expect(pc_flash_map(&f, TOTAL - PROG, 2 * PROG, &view) == PC_EINVAL, "map out of range");
+
   pc_flash_free(&f);
   puts("flash_sim: ok");
   return 0;
@@ -0,0 +1,242 @@
+// PR-011 tests: INDEX snapshots + fast mount
+// - periodic snapshots are written and superseded ones erased
+// - re-mount trusts the snapshot and only verifies newer segments
+// - a corrupt snapshot falls back to a full scan
+// - multi-part snapshots round-trip through flash
+// PR-028: lazy mount
+// - only commit headers are read; every newer segment is left unverified
+// - a segment corrupted behind its header is quarantined on first read
+// - pc_db_verify_step finishes the job in the background
+// PR-017 fix: a scan over a quarantined segment returns its error
+// PR-016 fix: so does an aggregate, after filling the buckets from the rest
+// PR-023 fix: and a derived series or an aligned grid
+// PR-018 fix: and quantiles, answered from the readable segments
+// PR-014 fix: and batch range queries (latest_many only if it reaches it)
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+static void write_points(pc_db_t *db, uint32_t n, uint32_t ts0)
+{
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    expect(pc_write(db, (uint16_t)(1 + (i / 50) % 3), 0, ts0 + i, (float)i) == PC_OK, "write");
+    if (pc_ring_size(&db->ring) >= 256)
+      expect(pc_db_flush_once(db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(db) == PC_OK, "flush all");
+}
+
+static bool count_points(void *ctx, const uint32_t *ts, const float *val, uint32_t n, uint16_t metric_id,
+                         uint16_t series_id)
+{
+  (void)ts;
+  (void)val;
+  (void)metric_id;
+  (void)series_id;
+  *(size_t *)ctx += n;
+  return true;
+}
+
+static size_t count_index_segments(const pc_flash_t *f)
+{
+  pc_seg_summary_t segs[64];
+  size_t n = 0, k = 0;
+  expect(pc_recover_scan_all(f, segs, 64, &n) == PC_OK, "scan");
+  for (size_t i = 0; i < n; ++i)
+    k += segs[i].type == PC_SEG_INDEX;
+  return k;
+}
+
+int main(void)
+{
+  // 256KB → 64 segments of 4KB
+  const size_t TOTAL = 256 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init");
+
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 512, 1) == PC_OK, "db init");
+  expect(!db.mount.used_index, "fresh device has no snapshot");
+  db.index_interval = 4;
+
+  // ~10 data segments → two snapshots, the first one erased by the second
+  write_points(&db, 4600, 1000);
+  const size_t nseg = db.catalog.count;
+  expect(nseg >= 9, "several data segments");
+  expect(db.index.nparts == 1, "snapshot written");
+  expect(count_index_segments(&f) == 1, "superseded snapshot erased");
+
+  // Two more segments after the snapshot
+  write_points(&db, 900, 9000);
+  const size_t total = db.catalog.count;
+  const uint32_t covered = db.index.covered_seq;
+  float v0 = 0;
+  uint32_t t0 = 0;
+  expect(pc_query_latest(&db, 1, &v0, &t0) == PC_OK, "latest before remount");
+  pc_db_deinit(&db);
+
+  // Re-mount: snapshot trusted, only newer segments verified
+  pc_db_t db2;
+  expect(pc_db_init(&db2, &f, 512, 1000) == PC_OK, "remount");
+  expect(db2.mount.used_index, "snapshot used");
+  expect(db2.mount.covered_seq == covered, "watermark");
+  expect(db2.catalog.count == total, "same catalog size");
+  expect(db2.mount.segments_trusted + (db2.mount.segments_verified - db2.index.nparts) == total, "trusted + verified");
+  expect(db2.mount.segments_verified < total, "fewer CRC checks than segments");
+  float v = 0;
+  uint32_t ts = 0;
+  expect(pc_query_latest(&db2, 1, &v, &ts) == PC_OK, "latest after remount");
+  expect(ts == t0 && v == v0, "same answer");
+  pc_db_deinit(&db2);
+
+  // Corrupt the snapshot (clear bits in its payload) → full scan fallback
+  {
+    pc_db_t tmp;
+    expect(pc_db_init(&tmp, &f, 512, 2000) == PC_OK, "remount for corruption");
+    size_t ibase = tmp.index.bases[0];
+    pc_db_deinit(&tmp);
+    uint8_t zero[256];
+    memset(zero, 0, sizeof zero);
+    expect(pc_logseg_program_data(&f, ibase, PROG, zero, PROG) == PC_OK, "tamper index");
+  }
+  expect(pc_db_init(&db2, &f, 512, 3000) == PC_OK, "remount after tamper");
+  expect(!db2.mount.used_index, "corrupt snapshot ignored");
+  expect(db2.catalog.count == total, "catalog rebuilt by scan");
+  expect(db2.mount.segments_verified == total, "all verified");
+  expect(count_index_segments(&f) == 0, "corrupt snapshot reclaimed");
+  pc_db_deinit(&db2);
+
+  // Lazy mount: no CRC work at all; corruption behind a header is found later
+  {
+    pc_db_t lz;
+    expect(pc_db_init_ex(&lz, &f, 512, 4000, PC_MOUNT_LAZY) == PC_OK, "lazy mount");
+    expect(lz.mount.segments_verified == 0, "no CRC at mount");
+    expect(lz.mount.segments_deferred == total && lz.unverified_count == total, "all deferred");
+    expect(lz.catalog.count == total, "catalog from headers");
+
+    uint8_t zero[256];
+    memset(zero, 0, sizeof zero);
+    const size_t bad = lz.catalog.segs[0].base;
+    expect(pc_logseg_program_data(&f, bad, 0, zero, PROG) == PC_OK, "tamper data");
+
+    // Touches every segment: each is verified once, the bad one quarantined
+    pc_bucket_t b[1];
+    expect(pc_query_aggregate(&lz, 1, PC_SERIES_ANY, 0, 19999, 20000, PC_AGG_COUNT, b, 1) == PC_CORRUPT,
+           "aggregate reports the bad segment");
+    const uint64_t partial = b[0].count;
+    expect(partial > 0, "aggregate over the readable segments");
+    expect(lz.unverified_count == 0, "verified on first read");
+    expect(lz.quarantined_count == 1, "bad segment quarantined");
+    expect(pc_query_aggregate(&lz, 1, PC_SERIES_ANY, 0, 19999, 20000, PC_AGG_COUNT, b, 1) == PC_CORRUPT &&
+               b[0].count == partial,
+           "aggregate again");
+    expect(lz.quarantined_count == 1, "quarantined once");
+    uint32_t dts[8];
+    float dval[8];
+    uint32_t dn = 0;
+    expect(pc_query_derive(&lz, 1, 0, 0, 19999, PC_DERIVE_DELTA, dts, dval, 8, &dn) == PC_CORRUPT && dn > 0,
+           "derive reports the bad segment");
+    pc_series_t one = {1, 0};
+    float grid[4];
+    expect(pc_query_align(&lz, &one, 1, 0, 19999, 5000, PC_FILL_LOCF, grid, 4) == PC_CORRUPT,
+           "align reports the bad segment");
+    const float qs[1] = {0.5f};
+    float qv = 0;
+    uint64_t qn = 0;
+    expect(pc_query_quantile(&lz, 1, 0, 0, 19999, qs, 1, &qv, &qn) == PC_CORRUPT && qn == partial,
+           "quantile reports the bad segment");
+    uint16_t mid = 1;
+    pc_latest_t lat;
+    expect(pc_query_latest_many(&lz, &mid, 1, &lat) == PC_OK && lat.found, "latest_many stops before the bad segment");
+    uint32_t rts[4];
+    float rv[4];
+    pc_range_buf_t rb = {rts, rv, 4, 0, 0};
+    expect(pc_query_range_many(&lz, &mid, 1, 0, 19999, &rb) == PC_CORRUPT && rb.total == partial,
+           "range_many reports the bad segment");
+
+    // A scan streams the readable segments but reports the quarantined one
+    pc_query_filter_t q = {1, PC_SERIES_ANY, 0, UINT32_MAX, 0, 0, PC_READ_COMMITTED, NULL};
+    size_t seen = 0;
+    expect(pc_query_scan(&lz, &q, count_points, &seen) == PC_CORRUPT && seen > 0, "scan reports the bad segment");
+    size_t left = 1;
+    expect(pc_db_verify_step(&lz, 4, &left) == PC_OK && left == 0, "nothing left");
+    expect(lz.catalog.count == total - 1, "quarantined segment dropped");
+    size_t seen2 = 0;
+    expect(pc_query_scan(&lz, &q, count_points, &seen2) == PC_OK && seen2 == seen, "clean scan once dropped");
+    expect(pc_query_aggregate(&lz, 1, PC_SERIES_ANY, 0, 19999, 20000, PC_AGG_COUNT, b, 1) == PC_OK &&
+               b[0].count == partial,
+           "clean aggregate once dropped");
+    pc_db_deinit(&lz);
+
+    // Background steps alone, newest first
+    expect(pc_db_init_ex(&lz, &f, 512, 5000, PC_MOUNT_LAZY) == PC_OK, "lazy remount");
+    expect(pc_db_verify_step(&lz, 2, &left) == PC_OK && left == total - 2, "two per step");
+    expect(lz.quarantined_count == 0, "newest are fine");
+    size_t steps = 0;
+    while (left && steps++ < total)
+      expect(pc_db_verify_step(&lz, 2, &left) == PC_OK, "step");
+    expect(left == 0 && lz.quarantined_count == 1, "background found it");
+    expect(lz.catalog.count == total - 1, "dropped after step");
+    float lv = 0;
+    uint32_t lt = 0;
+    expect(pc_query_latest(&lz, 1, &lv, &lt) == PC_OK && lt == t0 && lv == v0, "latest unaffected");
+    pc_db_deinit(&lz);
+  }
+
+  // Multi-part snapshot round trip
+  {
+    pc_flash_t g = {0};
+    expect(pc_flash_init(&g, TOTAL, SEG, PROG, 0xFF), "flash2 init");
+    pc_alloc_t a;
+    expect(pc_alloc_init(&a, &g) == PC_OK, "alloc");
+    pc_index_blob_t blob;
+    pc_index_blob_init(&blob);
+    uint8_t *body = pc_index_blob_section(&blob, 99, 10000);
+    expect(body != NULL, "section");
+    for (size_t i = 0; i < 10000; ++i)
+      body[i] = (uint8_t)(i * 7);
+    pc_index_t ix;
+    pc_index_init(&ix);
+    uint32_t seq = 50;
+    expect(pc_index_write(&ix, &g, &a, &blob, 49, &seq) == PC_OK, "write multi-part");
+    expect(ix.nparts == 3 && seq == 53, "three parts");
+
+    pc_index_t ix2;
+    pc_catalog_t cat;
+    pc_index_blob_t got;
+    pc_mount_stats_t ms;
+    pc_index_init(&ix2);
+    pc_catalog_init(&cat);
+    pc_index_blob_init(&got);
+    expect(pc_index_mount(&ix2, &g, &cat, &got, &ms) == PC_OK, "mount multi-part");
+    expect(ms.used_index && ix2.nparts == 3 && ix2.covered_seq == 49, "snapshot found");
+    const uint8_t *p = NULL;
+    size_t len = 0;
+    expect(pc_index_blob_find(&got, 99, &p, &len) == PC_OK && len == 10000, "section found");
+    expect(memcmp(p, body, len) == 0, "section bytes");
+
+    pc_index_blob_free(&blob);
+    pc_index_blob_free(&got);
+    pc_index_free(&ix);
+    pc_index_free(&ix2);
+    pc_catalog_free(&cat);
+    pc_alloc_deinit(&a);
+    pc_flash_free(&g);
+  }
+
+  pc_flash_free(&f);
+  puts("index: ok");
+  return 0;
+}
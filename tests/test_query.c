@@ -0,0 +1,360 @@
+// PR-014 tests: batch queries over many metrics
+// - latest_many matches per-metric pc_query_latest, with missing + duplicate ids
+// - every block is decoded at most once per batch
+// - range_many returns sorted, bounded per-metric results (stable for
+//   backdated points) and rejects slot counts past INT32_MAX
+// PR-015: mapped and page-read decoding agree; I/O is per segment / page run
+// PR-016: bucketed aggregates match a brute-force fold; summarized blocks are
+//         answered without decoding points
+// PR-017: streaming scan delivers every match once, honours offset/limit/stop,
+//         and in read-your-writes mode also streams pending points
+// PR-018: quantiles from block sketches agree with raw points within the bound
+// PR-025: blocks written in ts order are flagged sorted; as-of lookups
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+typedef struct
+{
+  uint64_t points;
+  uint32_t batches;
+  uint32_t stop_after; // batches (0 = never stop)
+  uint32_t last_ts;
+  bool sorted;
+  bool valid; // values match fill()'s formula for their metric
+  uint32_t first_ts;
+} collect_t;
+
+static bool collect(void *ctx, const uint32_t *ts, const float *val, uint32_t n,
+                    uint16_t metric_id, uint16_t series_id)
+{
+  collect_t *c = (collect_t *)ctx;
+  expect(n >= 1 && n <= PC_QUERY_BATCH && series_id == 0, "batch shape");
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    if (c->points == 0)
+      c->first_ts = ts[i];
+    else if (ts[i] <= c->last_ts)
+      c->sorted = false;
+    uint32_t r = (ts[i] - 10000) / 100, k = (ts[i] - 10000) % 100;
+    if (val[i] != (float)(metric_id * 1000 + r * 10 + k))
+      c->valid = false;
+    c->last_ts = ts[i];
+    c->points++;
+  }
+  c->batches++;
+  return c->stop_after == 0 || c->batches < c->stop_after;
+}
+
+enum
+{
+  METRICS = 40,
+  ROUNDS = 30,
+  PER_ROUND = 4
+};
+
+// Metric m, round r, point k → ts = 10000 + r*100 + k, value = m*1000 + r*10 + k
+static void fill(pc_db_t *db)
+{
+  for (uint32_t r = 0; r < ROUNDS; ++r)
+  {
+    for (uint16_t m = 1; m <= METRICS; ++m)
+    {
+      for (uint32_t k = 0; k < PER_ROUND; ++k)
+        expect(pc_write(db, m, 0, 10000 + r * 100 + k, (float)(m * 1000 + r * 10 + k)) == PC_OK, "write");
+      while (pc_ring_size(&db->ring) >= 512)
+        expect(pc_db_flush_once(db) == PC_OK, "flush once");
+    }
+  }
+  expect(pc_db_flush_until_empty(db) == PC_OK, "flush all");
+}
+
+// Backdated writes come back from range_many sorted by ts, ties in write order
+static void backdated_range(void)
+{
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, 64 * 1024, 4096, 256, 0xFF), "flash init (backdated)");
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 64, 1) == PC_OK, "db init (backdated)");
+  const uint32_t late[5] = {500, 400, 500, 300, 400};
+  for (uint32_t i = 0; i < 5; ++i)
+    expect(pc_write(&db, 9, 0, late[i], (float)i) == PC_OK, "backdated write");
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush backdated");
+  uint32_t ts[8];
+  float v[8];
+  uint16_t id = 9;
+  pc_range_buf_t rb = {ts, v, 8, 0, 0};
+  expect(pc_query_range_many(&db, &id, 1, 0, 1000, &rb) == PC_OK && rb.count == 5, "backdated range");
+  expect(ts[0] == 300 && ts[1] == 400 && ts[2] == 400 && ts[3] == 500 && ts[4] == 500, "sorted by ts");
+  expect(v[1] == 1.0f && v[2] == 4.0f && v[3] == 0.0f && v[4] == 2.0f, "stable for equal ts");
+  pc_db_deinit(&db);
+  pc_flash_free(&f);
+}
+
+int main(void)
+{
+  // 256KB → 64 segments
+  const size_t TOTAL = 256 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init");
+
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 1024, 1) == PC_OK, "db init");
+  fill(&db);
+  expect(db.catalog.count > 4, "several segments");
+
+  // ---- latest_many ----
+  uint16_t ids[METRICS + 2];
+  pc_latest_t out[METRICS + 2];
+  for (uint16_t i = 0; i < METRICS; ++i)
+    ids[i] = (uint16_t)(METRICS - i); // any order
+  ids[METRICS] = 999;                  // unknown
+  ids[METRICS + 1] = 7;                // duplicate
+
+  size_t total_blocks = 0;
+  for (size_t i = 0; i < db.catalog.count; ++i)
+  {
+    expect(pc_scan_load_dir(&db.scan, db.catalog.segs[i].base, db.catalog.segs[i].record_count) == PC_OK, "dir");
+    total_blocks += db.scan.nblocks;
+  }
+
+  size_t blocks0 = db.scan.blocks_read;
+  expect(pc_query_latest_many(&db, ids, METRICS + 2, out) == PC_OK, "latest_many");
+  expect(db.scan.blocks_read - blocks0 <= total_blocks, "each block decoded at most once");
+  for (size_t i = 0; i < METRICS; ++i)
+  {
+    float v = 0;
+    uint32_t ts = 0;
+    expect(pc_query_latest(&db, ids[i], &v, &ts) == PC_OK, "single latest");
+    expect(out[i].found && out[i].ts == ts && out[i].value == v, "batch == single");
+    expect(ts == 10000 + (ROUNDS - 1) * 100 + PER_ROUND - 1, "newest round");
+  }
+  expect(!out[METRICS].found, "unknown metric not found");
+  expect(out[METRICS + 1].found && out[METRICS + 1].ts == out[METRICS - 7].ts, "duplicate answered");
+
+  // ---- range_many ----
+  const uint32_t t0 = 10000 + 10 * 100, t1 = 10000 + 12 * 100 + 1; // rounds 10, 11 and half of 12
+  uint32_t ts_a[64], ts_b[64], ts_c[4];
+  float v_a[64], v_b[64], v_c[4];
+  uint16_t rids[3] = {3, 25, 25};
+  pc_range_buf_t rb[3] = {{ts_a, v_a, 64, 0, 0}, {ts_b, v_b, 64, 0, 0}, {ts_c, v_c, 4, 0, 0}};
+  expect(pc_query_range_many(&db, rids, 3, t0, t1, rb) == PC_OK, "range_many");
+  expect(rb[0].count == 2 * PER_ROUND + 2 && rb[0].total == rb[0].count, "range count");
+  for (uint32_t i = 1; i < rb[0].count; ++i)
+    expect(ts_a[i] > ts_a[i - 1], "range ascending");
+  expect(ts_a[0] == t0 && v_a[0] == (float)(3 * 1000 + 100), "range first point");
+  expect(ts_a[rb[0].count - 1] == t1, "range last point");
+  expect(rb[1].count == rb[0].count && v_b[0] == (float)(25 * 1000 + 100), "second metric");
+  expect(rb[2].count == 4 && rb[2].total == rb[1].total, "duplicate truncated to its cap");
+
+  uint32_t n = 0;
+  expect(pc_query_range(&db, 3, t1 + 1000000, t1 + 2000000, ts_a, v_a, 64, &n) == PC_METRIC_UNKNOWN && n == 0, "empty range");
+  expect(pc_query_range(&db, 3, t1, t0, ts_a, v_a, 64, &n) == PC_INVALID_RANGE, "inverted range");
+  expect(pc_query_range_many(&db, rids, (size_t)INT32_MAX + 1u, t0, t1, rb) == PC_EINVAL, "too many slots");
+
+  backdated_range();
+
+  // ---- as-of ----
+  expect(pc_scan_load_seg(&db.scan, &db.catalog.segs[0]) == PC_OK && db.scan.nblocks > 0, "first segment");
+  for (size_t b = 0; b < db.scan.nblocks; ++b)
+    expect(db.scan.dir[b].flags & PC_BLOCK_F_SORTED, "appended blocks sorted");
+  float av = 0;
+  uint32_t ats = 0;
+  expect(pc_query_asof(&db, 3, 0, 10000 + 10 * 100 + 50, &av, &ats) == PC_OK, "asof");
+  expect(ats == 10000 + 10 * 100 + 3 && av == (float)(3 * 1000 + 100 + 3), "asof between rounds");
+  expect(pc_query_asof(&db, 3, PC_SERIES_ANY, 10000 + 20 * 100 + 2, &av, &ats) == PC_OK &&
+             ats == 10000 + 20 * 100 + 2 && av == (float)(3 * 1000 + 200 + 2),
+         "asof exact");
+  expect(pc_query_asof(&db, 3, 0, UINT32_MAX, &av, &ats) == PC_OK &&
+             ats == 10000 + (ROUNDS - 1) * 100 + PER_ROUND - 1,
+         "asof after the end = latest");
+  expect(pc_query_asof(&db, 3, 0, 9999, &av, &ats) == PC_METRIC_UNKNOWN, "asof before the start");
+  expect(pc_query_asof(&db, 3, 1, UINT32_MAX, &av, &ats) == PC_METRIC_UNKNOWN, "asof other series");
+
+  // ---- PR-015: decode from a mapped view vs. whole program pages ----
+  size_t loads0 = db.scan.dirs_loaded, reads0 = db.scan.flash_reads;
+  expect(pc_query_latest_many(&db, ids, METRICS, out) == PC_OK, "mapped latest_many");
+  expect(db.scan.flash_reads - reads0 == db.scan.dirs_loaded - loads0, "one map per segment");
+
+  db.scan.use_map = false;
+  pc_latest_t out2[METRICS];
+  loads0 = db.scan.dirs_loaded;
+  reads0 = db.scan.flash_reads;
+  expect(pc_query_latest_many(&db, ids, METRICS, out2) == PC_OK, "paged latest_many");
+  size_t pages_per_seg = pc_logseg_preheader_bytes(&f) / PROG;
+  expect(db.scan.flash_reads - reads0 <= (db.scan.dirs_loaded - loads0) * pages_per_seg, "at most one read per page");
+  for (size_t i = 0; i < METRICS; ++i)
+    expect(out2[i].found && out2[i].ts == out[i].ts && out2[i].value == out[i].value, "paged == mapped");
+  expect(pc_query_range_many(&db, rids, 2, t0, t1, rb) == PC_OK && rb[0].count == 2 * PER_ROUND + 2, "paged range");
+  expect(v_a[0] == (float)(3 * 1000 + 100), "paged range value");
+  db.scan.use_map = true;
+
+  // ---- PR-016: aggregate vs brute force over range ----
+  {
+    const uint32_t a0 = 10000 + 3 * 100 + 2, a1 = 10000 + 17 * 100 + 1, bs = 250;
+    pc_bucket_t bk[8];
+    expect(pc_query_aggregate(&db, 9, PC_SERIES_ANY, a0, a1, bs, PC_AGG_ALL, bk, 5) == PC_EINVAL, "too few buckets");
+    expect(pc_query_aggregate(&db, 9, PC_SERIES_ANY, a1, a0, bs, PC_AGG_ALL, bk, 8) == PC_INVALID_RANGE, "inverted");
+    // Full uint32 range in 1s buckets: 2^32 buckets, not 0
+    expect(pc_query_aggregate(&db, 9, PC_SERIES_ANY, 0, UINT32_MAX, 1, PC_AGG_ALL, bk, 8) == PC_EINVAL,
+           "full range bucket count");
+    expect(pc_query_aggregate(&db, 9, PC_SERIES_ANY, a0, a1, bs, PC_AGG_ALL, bk, 8) == PC_OK, "aggregate");
+    expect(pc_query_range(&db, 9, a0, a1, ts_a, v_a, 64, &n) == PC_OK, "brute range");
+    pc_bucket_t ref[8];
+    memset(ref, 0, sizeof ref);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      pc_bucket_t *r = &ref[(ts_a[i] - a0) / bs];
+      if (r->count == 0 || v_a[i] < r->min)
+        r->min = v_a[i];
+      if (r->count == 0 || v_a[i] > r->max)
+        r->max = v_a[i];
+      r->sum += v_a[i];
+      r->count++;
+    }
+    for (int k = 0; k < 6; ++k)
+    {
+      expect(bk[k].count == ref[k].count, "bucket count");
+      if (!ref[k].count)
+        continue;
+      expect(bk[k].min == ref[k].min && bk[k].max == ref[k].max && bk[k].sum == ref[k].sum, "bucket min/max/sum");
+      expect(bk[k].avg == (float)(ref[k].sum / ref[k].count), "bucket avg");
+    }
+    expect(pc_query_aggregate(&db, 9, 1, a0, a1, bs, PC_AGG_ALL, bk, 8) == PC_OK && bk[0].count == 0, "other series");
+    expect(pc_query_aggregate(&db, 9, 0, a0, a1, bs, PC_AGG_COUNT, bk, 8) == PC_OK, "count only");
+    expect(bk[1].count == ref[1].count && bk[1].sum == 0.0 && bk[1].max == 0.0f, "unrequested fields zeroed");
+  }
+
+  // ---- PR-017: streaming scan ----
+  {
+    pc_query_filter_t q = {5, PC_SERIES_ANY, 0, UINT32_MAX, 0, 0, PC_READ_COMMITTED, NULL};
+    collect_t c = {0, 0, 0, 0, true, true, 0};
+    expect(pc_query_scan(&db, &q, collect, &c) == PC_OK, "scan one metric");
+    expect(c.points == ROUNDS * PER_ROUND && c.sorted && c.valid, "all points, in order");
+
+    q.metric_id = PC_METRIC_ANY;
+    memset(&c, 0, sizeof c);
+    c.valid = true;
+    expect(pc_query_scan(&db, &q, collect, &c) == PC_OK && c.valid, "scan everything");
+    expect(c.points == (uint64_t)METRICS * ROUNDS * PER_ROUND, "every point once");
+
+    // Offset + limit inside a time window
+    q.metric_id = 5;
+    q.t0 = 10000 + 10 * 100;
+    q.t1 = 10000 + 20 * 100;
+    q.offset = 3;
+    q.limit = 6;
+    memset(&c, 0, sizeof c);
+    c.sorted = c.valid = true;
+    expect(pc_query_scan(&db, &q, collect, &c) == PC_OK, "offset/limit");
+    expect(c.points == 6 && c.sorted && c.first_ts == 10000 + 10 * 100 + 3, "window paged");
+
+    // Early exit after the first batch
+    q.metric_id = PC_METRIC_ANY;
+    q.offset = q.limit = 0;
+    memset(&c, 0, sizeof c);
+    c.valid = true;
+    c.stop_after = 1;
+    expect(pc_query_scan(&db, &q, collect, &c) == PC_OK && c.batches == 1, "callback stop");
+
+    q.t0 = q.t1 + 1;
+    expect(pc_query_scan(&db, &q, collect, &c) == PC_INVALID_RANGE, "inverted");
+
+    // Pending points only show up in read-your-writes mode
+    for (uint32_t k = 0; k < 3; ++k)
+      expect(pc_write(&db, 5, 0, 10000 + ROUNDS * 100 + k, (float)(5 * 1000 + ROUNDS * 10 + k)) == PC_OK, "pending");
+    pc_query_filter_t all5 = {5, PC_SERIES_ANY, 0, UINT32_MAX, 0, 0, PC_READ_YOUR_WRITES, NULL};
+    memset(&c, 0, sizeof c);
+    c.sorted = c.valid = true;
+    expect(pc_query_scan(&db, &all5, collect, &c) == PC_OK, "ryw scan");
+    expect(c.points == ROUNDS * PER_ROUND + 3 && c.sorted && c.valid, "ring points streamed last");
+    all5.mode = PC_READ_COMMITTED;
+    memset(&c, 0, sizeof c);
+    expect(pc_query_scan(&db, &all5, collect, &c) == PC_OK && c.points == ROUNDS * PER_ROUND, "committed scan");
+  }
+
+  pc_db_deinit(&db);
+
+  // ---- PR-016: summarized blocks inside one bucket are never decoded ----
+  {
+    pc_flash_t g = {0};
+    expect(pc_flash_init(&g, TOTAL, SEG, PROG, 0xFF), "flash2 init");
+    pc_db_t d;
+    expect(pc_db_init(&d, &g, 1024, 1) == PC_OK, "db2 init");
+    d.sketch_blocks = true;
+    double want = 0;
+    for (uint32_t r = 0; r < 40; ++r)
+    {
+      for (uint16_t m = 1; m <= 2; ++m)
+      {
+        for (uint32_t k = 0; k < 32; ++k) // one run → one summarized block
+        {
+          float v = (float)(m * 100 + k);
+          expect(pc_write(&d, m, 0, 1000 + r * 64 + k, v) == PC_OK, "write run");
+          want += m == 2 ? v : 0;
+        }
+        expect(pc_db_flush_once(&d) == PC_OK, "flush run");
+      }
+    }
+    expect(pc_db_flush_until_empty(&d) == PC_OK, "flush all runs");
+    expect(d.catalog.count > 1, "several segments");
+
+    pc_bucket_t one;
+    size_t blocks0 = d.scan.blocks_read;
+    expect(pc_query_aggregate(&d, 2, PC_SERIES_ANY, 0, 100000, 1000000, PC_AGG_ALL, &one, 1) == PC_OK, "one bucket");
+    expect(d.scan.blocks_read == blocks0, "no block decoded");
+    expect(one.count == 40 * 32 && one.sum == want, "count/sum from summaries");
+    expect(one.min == 200.0f && one.max == 231.0f, "min/max from summaries");
+
+    // Buckets that split blocks fall back to decoding and still agree.
+    pc_bucket_t bk[107];
+    blocks0 = d.scan.blocks_read;
+    expect(pc_query_aggregate(&d, 2, 0, 1000, 1000 + 40 * 64 - 1, 24, PC_AGG_SUM | PC_AGG_COUNT, bk, 107) == PC_OK, "fine buckets");
+    expect(d.scan.blocks_read > blocks0, "split blocks decoded");
+    double got = 0;
+    uint32_t cnt = 0;
+    for (int k = 0; k < 107; ++k)
+    {
+      got += bk[k].sum;
+      cnt += bk[k].count;
+    }
+    expect(cnt == 40 * 32 && got == want, "fine buckets total");
+
+    // PR-018: whole-range quantiles come from the sketches alone
+    const float qs[3] = {0.5f, 0.95f, 0.99f};
+    float qv[3];
+    uint64_t qn = 0;
+    blocks0 = d.scan.blocks_read;
+    expect(pc_query_quantile(&d, 2, PC_SERIES_ANY, 0, 100000, qs, 3, qv, &qn) == PC_OK, "quantile");
+    expect(d.scan.blocks_read == blocks0 && qn == 40 * 32, "sketches only");
+    for (int k = 0; k < 3; ++k)
+    {
+      // Values 200..231, each 40 times: rank r holds 200 + r / 40.
+      float exact = 200.0f + (float)((uint32_t)(qs[k] * (40 * 32 - 1)) / 40);
+      expect(qv[k] >= exact * (1.0f - (float)PC_SKETCH_REL_ERROR) &&
+                 qv[k] <= exact * (1.0f + (float)PC_SKETCH_REL_ERROR),
+             "quantile within bound");
+    }
+    // A window cutting blocks decodes them and bins the same way
+    expect(pc_query_quantile(&d, 2, 0, 1000 + 64 + 16, 1000 + 3 * 64 - 1, qs, 1, qv, &qn) == PC_OK, "partial window");
+    expect(d.scan.blocks_read > blocks0 && qn == 16 + 32, "partial blocks decoded");
+    expect(pc_query_quantile(&d, 7, 0, 0, 100000, qs, 1, qv, &qn) == PC_METRIC_UNKNOWN && qn == 0, "no samples");
+    pc_db_deinit(&d);
+    pc_flash_free(&g);
+  }
+
+  pc_flash_free(&f);
+  puts("query: ok");
+  return 0;
+}
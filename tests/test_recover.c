@@ -1,4 +1,7 @@
 // PR-006 tests: forward recovery scanner
+// PR-029: the parallel scan finds the same segments (seqno order, no output
+// limit) for any thread count; a mount with threads catalogues the same
+// segments as a serial one
 // Build & run: ctest --test-dir build --output-on-failure -R recover
 #include <stdio.h>
 #include <string.h>
@@ -8,6 +11,7 @@
 #include "pc_flash.h"
 #include "pc_logseg.h"
 #include "pc_recover.h"
+#include "pc_index.h"
 
 static void expect(int cond, const char *msg)
 {
@@ -30,6 +34,109 @@ static void write_payload_pages(pc_flash_t *f, size_t base, size_t prog, int pag
   }
 }
 
+typedef struct
+{
+  pc_seg_summary_t segs[64];
+  size_t n;
+  size_t stop_after; // 0 = never stop
+} collect_t;
+
+static bool collect(void *ctx, const pc_seg_summary_t *seg)
+{
+  collect_t *c = (collect_t *)ctx;
+  if (c->n < 64)
+    c->segs[c->n] = *seg;
+  c->n++;
+  return c->stop_after == 0 || c->n < c->stop_after;
+}
+
+static void parallel_scan(void)
+{
+  // 256KB → 64 segments, committed with scrambled seqnos; every 7th is corrupt
+  const size_t TOTAL = 256 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = (pc_flash_t){0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init (parallel)");
+  size_t valid = 0;
+  for (size_t i = 0; i < 60; ++i)
+  {
+    const size_t base = i * SEG;
+    const uint32_t seq = (uint32_t)((i * 37) % 61 + 1);
+    write_payload_pages(&f, base, PROG, 1 + (int)(i % 3), (uint8_t)i);
+    expect(pc_logseg_commit(&f, base, PC_SEG_DATA, seq, seq * 10, seq * 10 + 9, 1) == PC_OK, "commit");
+    if (i % 7 == 3)
+    {
+      uint8_t zero[256];
+      memset(zero, 0x00, sizeof zero);
+      expect(pc_logseg_program_data(&f, base, 0, zero, PROG) == PC_OK, "tamper");
+    }
+    else
+      valid++;
+  }
+  expect(pc_flash_mark_bad(&f, 62, true) == PC_OK, "mark bad");
+
+  const unsigned threads[] = {0, 1, 2, 3, 8, 100};
+  for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t)
+  {
+    collect_t c = {0};
+    size_t found = 0;
+    pc_result_t st = pc_recover_scan_all_parallel(&f, threads[t], collect, &c, &found);
+    if (!PC_THREADS && threads[t] > 1)
+    {
+      expect(st == PC_UNSUPPORTED, "threads not compiled in");
+      continue;
+    }
+    expect(st == PC_OK, "parallel scan");
+    expect(found == valid && c.n == valid, "all valid segments, beyond any fixed cap");
+    for (size_t i = 1; i < c.n; ++i)
+      expect(c.segs[i - 1].seqno < c.segs[i].seqno, "seqno order");
+    for (size_t i = 0; i < c.n; ++i)
+      expect(c.segs[i].ts_min == c.segs[i].seqno * 10, "summary fields");
+  }
+
+  // Early stop from the callback
+  collect_t c = {0};
+  c.stop_after = 5;
+  size_t found = 0;
+  expect(pc_recover_scan_all_parallel(&f, PC_THREADS ? 4 : 1, collect, &c, &found) == PC_OK, "scan with stop");
+  expect(c.n == 5 && found == valid, "stopped after five");
+
+  // Mount: header and CRC passes split across threads (serial fallback
+  // without PC_THREADS) give the serial catalog
+  pc_seg_summary_t serial[64];
+  size_t nserial = 0;
+  const unsigned mount_threads[] = {1, 4, 100};
+  for (size_t t = 0; t < sizeof(mount_threads) / sizeof(mount_threads[0]); ++t)
+  {
+    pc_index_t ix;
+    pc_catalog_t cat;
+    pc_index_blob_t blob;
+    pc_mount_stats_t ms;
+    pc_index_init(&ix);
+    pc_catalog_init(&cat);
+    pc_index_blob_init(&blob);
+    pc_mount_opts_t mo = {0};
+    mo.threads = mount_threads[t];
+    expect(pc_index_mount_ex(&ix, &f, &cat, &blob, &ms, &mo) == PC_OK, "threaded mount");
+    expect(cat.count == valid && ms.segments_verified == 60, "mount verified every segment");
+    if (t == 0)
+    {
+      nserial = cat.count;
+      memcpy(serial, cat.segs, nserial * sizeof(*serial));
+    }
+    else
+    {
+      expect(cat.count == nserial, "same count as serial mount");
+      for (size_t i = 0; i < nserial; ++i)
+        expect(cat.segs[i].base == serial[i].base && cat.segs[i].seqno == serial[i].seqno,
+               "same catalog as serial mount");
+    }
+    pc_index_blob_free(&blob);
+    pc_catalog_free(&cat);
+    pc_index_free(&ix);
+  }
+  pc_flash_free(&f);
+}
+
 int main(void)
 {
   // 32KB total → 8 segments of 4KB each
@@ -94,7 +201,14 @@ int main(void)
   expect(got[2].base == 4 * SEG, "entry2 base");
   expect(got[2].seqno == 5 && got[2].type == PC_SEG_INDEX, "entry2 fields");
 
+  // Same answer from the parallel scan, in seqno order
+  collect_t c = {0};
+  expect(pc_recover_scan_all_parallel(&f, PC_THREADS ? 3 : 1, collect, &c, &n) == PC_OK, "parallel ok");
+  expect(n == 3 && c.n == 3, "parallel found 3");
+  expect(c.segs[0].seqno == 1 && c.segs[1].seqno == 2 && c.segs[2].seqno == 5, "parallel order");
+
   pc_flash_free(&f);
+  parallel_scan();
   puts("recover: ok");
   return 0;
 }
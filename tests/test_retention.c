@@ -0,0 +1,156 @@
+// PR-032 tests: retention + space reclamation
+// - keep-N / max-bytes / max-age limits reclaim the oldest segments, a bounded
+//   number per background step, and their blocks leave the cache
+// - with a free-space floor a full device keeps ingesting as a ring log and
+//   survives a remount (with and without epochs)
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+// ~450 points fill a segment; metric 1, ts = ts0 + i
+static void write_points(pc_db_t *db, uint32_t n, uint32_t ts0)
+{
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    expect(pc_write(db, 1, 0, ts0 + i, (float)(ts0 + i)) == PC_OK, "write");
+    if (pc_ring_size(&db->ring) >= 256)
+      expect(pc_db_flush_once(db) == PC_OK, "flush once");
+  }
+  expect(pc_db_flush_until_empty(db) == PC_OK, "flush all");
+}
+
+static uint32_t count_range(pc_db_t *db, uint32_t t0, uint32_t t1)
+{
+  static uint32_t ts[8192];
+  static float val[8192];
+  uint32_t n = 0;
+  pc_result_t st = pc_query_range(db, 1, t0, t1, ts, val, 8192, &n);
+  expect(st == PC_OK || st == PC_METRIC_UNKNOWN, "range");
+  return st == PC_OK ? n : 0;
+}
+
+static void ring_log(bool epochs)
+{
+  const size_t SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, 16 * SEG, SEG, PROG, 0xFF), "flash init");
+  pc_db_config_t cfg;
+  pc_db_config_default(&cfg);
+  cfg.index_interval = 4;
+  cfg.retention.min_free_segments = 2;
+  pc_db_t db;
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "open");
+  if (epochs)
+    expect(pc_db_enable_epochs(&db) == PC_OK, "epochs");
+
+  // ~60 segments through a 16-sector device: never PC_NO_SPACE
+  uint32_t ts = 1;
+  for (int round = 0; round < 30; ++round)
+  {
+    write_points(&db, 900, ts);
+    ts += 900;
+    size_t n = 0;
+    if (round % 3 == 0)
+      expect(pc_db_reclaim_step(&db, 4, &n) == PC_OK, "background step");
+  }
+  expect(db.segments_reclaimed > 40, "old segments reclaimed");
+  expect(db.catalog.count < 16, "fits the device");
+  for (size_t k = 1; k < db.catalog.count; ++k)
+    expect(db.catalog.segs[k].seqno > db.catalog.segs[k - 1].seqno, "catalog in order");
+  float v = 0;
+  uint32_t lt = 0;
+  expect(pc_query_latest(&db, 1, &v, &lt) == PC_OK && lt == ts - 1, "newest point kept");
+  expect(count_range(&db, 1, 900) == 0, "oldest data gone");
+  const size_t count = db.catalog.count;
+  const uint32_t first_ts = db.catalog.segs[0].ts_min;
+  pc_db_deinit(&db);
+
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "reopen");
+  expect(db.epochs == epochs, "epochs detected");
+  expect(db.catalog.count == count && db.catalog.segs[0].ts_min == first_ts, "same live set");
+  expect(pc_query_latest(&db, 1, &v, &lt) == PC_OK && lt == ts - 1, "newest after reopen");
+  write_points(&db, 2000, ts);
+  expect(pc_query_latest(&db, 1, &v, &lt) == PC_OK && lt == ts + 1999, "ingest continues");
+  pc_db_deinit(&db);
+  pc_flash_free(&f);
+}
+
+int main(void)
+{
+  const size_t SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, 64 * SEG, SEG, PROG, 0xFF), "flash init");
+  pc_db_config_t cfg;
+  pc_db_config_default(&cfg);
+  cfg.index_interval = 0;
+  pc_db_t db;
+  expect(pc_db_open(&db, &f, &cfg) == PC_OK, "open");
+
+  // 8+ segments, cache warmed over the oldest ones
+  write_points(&db, 4000, 1000);
+  const size_t before = db.catalog.count;
+  expect(before >= 8, "segments written");
+  const uint32_t old_n = count_range(&db, 1000, 1999);
+  expect(old_n == 1000, "old range readable");
+  size_t n = 0;
+  expect(pc_db_reclaim_step(&db, 8, &n) == PC_OK && n == 0, "no policy, nothing reclaimed");
+
+  // keep-N, a bounded number per step
+  db.retention.keep_segments = 4;
+  expect(pc_db_reclaim_step(&db, 1, &n) == PC_OK && n == 1, "one per step");
+  expect(db.catalog.count == before - 1, "catalog updated");
+  expect(pc_db_reclaim_step(&db, 100, &n) == PC_OK && db.catalog.count == 4, "keep newest 4");
+  expect(count_range(&db, 1000, 1999) == 0, "reclaimed blocks not served from cache");
+  expect(pc_db_free_segments(&db) == 64 - 4, "free space back");
+
+  // max bytes
+  db.retention.keep_segments = 0;
+  db.retention.max_bytes = 3 * SEG;
+  expect(pc_db_reclaim_step(&db, 100, &n) == PC_OK && n == 1 && db.catalog.count == 3, "max bytes");
+
+  // max age: relative to the newest data
+  db.retention.max_bytes = 0;
+  write_points(&db, 2000, 100000);
+  db.retention.max_age_secs = 5000;
+  expect(pc_db_reclaim_step(&db, 100, &n) == PC_OK && n == 3, "aged out");
+  expect(db.catalog.segs[0].ts_min >= 100000, "only recent data left");
+  expect(count_range(&db, 100000, 101999) == 2000, "recent data intact");
+  pc_db_deinit(&db);
+
+  // Without a floor a full device still stops
+  {
+    pc_flash_t g = {0};
+    expect(pc_flash_init(&g, 4 * SEG, SEG, PROG, 0xFF), "small flash");
+    pc_db_t d;
+    pc_db_config_default(&cfg);
+    cfg.index_interval = 0;
+    expect(pc_db_open(&d, &g, &cfg) == PC_OK, "open small");
+    pc_result_t st = PC_OK;
+    for (uint32_t i = 0; i < 4000 && st == PC_OK; ++i)
+    {
+      expect(pc_write(&d, 1, 0, i, 0.0f) == PC_OK, "write");
+      st = pc_ring_size(&d.ring) >= 256 ? pc_db_flush_once(&d) : PC_OK;
+    }
+    expect(st == PC_NO_SPACE, "full without retention");
+    pc_db_deinit(&d);
+    pc_flash_free(&g);
+  }
+
+  ring_log(false);
+  ring_log(true);
+
+  pc_flash_free(&f);
+  puts("retention: ok");
+  return 0;
+}
@@ -1,6 +1,7 @@
 // Threaded stress test for SPSC ring (PR-002).
 // Verifies order & count across two threads using C11 atomics + pthreads.
 
+#define _POSIX_C_SOURCE 200809L // nanosleep under strict C11
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdint.h>
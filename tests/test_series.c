@@ -0,0 +1,238 @@
+// PR-019 tests: series dictionary
+// - same name + tags (any order) → same ids; reverse lookup formats them back
+// - capacity limit → PC_TOO_MANY_SERIES; reserve raises it
+// - the dictionary survives a remount through the INDEX snapshot
+// PR-020: tag selectors match a brute-force filter (array and bitset postings),
+//         survive a remount, and drive one-pass aggregate/scan queries
+// PR-020 fix: selectors are capped at PC_TAGINDEX_SELECT_MAX pairs; postings
+//         of a failed insert are rolled back
+// PR-019 fix: the dictionary is snapshotted before any block using a new id
+//         is committed, even when the id appears with a segment already open
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "pc_api.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+typedef struct
+{
+  const pc_series_set_t *set;
+  size_t points;
+  bool only_selected;
+} scan_count_t;
+
+static bool count_points(void *ctx, const uint32_t *ts, const float *val, uint32_t n,
+                         uint16_t metric_id, uint16_t series_id)
+{
+  scan_count_t *c = (scan_count_t *)ctx;
+  c->points += n;
+  c->only_selected = c->only_selected && pc_series_set_has(c->set, series_id);
+  return true;
+}
+
+int main(void)
+{
+  // ---- Dictionary alone ----
+  pc_series_dict_t d;
+  expect(pc_series_dict_init(&d, 4) == PC_OK, "dict init");
+
+  pc_tag_t ab[2] = {{"host", "a"}, {"dc", "eu"}};
+  pc_tag_t ba[2] = {{"dc", "eu"}, {"host", "a"}};
+  pc_series_t s1, s2, s3, m;
+  expect(pc_series_dict_resolve(&d, "cpu", ab, 2, &s1) == PC_OK, "resolve tagged");
+  expect(s1.metric_id == 1 && s1.series_id == 1, "first ids");
+  expect(d.count == 2, "name entry + series entry");
+  expect(pc_series_dict_resolve(&d, "cpu", ba, 2, &s2) == PC_OK, "resolve reordered");
+  expect(s2.metric_id == s1.metric_id && s2.series_id == s1.series_id, "tag order ignored");
+  expect(pc_series_dict_resolve(&d, "cpu", NULL, 0, &m) == PC_OK, "untagged");
+  expect(m.metric_id == 1 && m.series_id == 0 && d.count == 2, "untagged reuses the name entry");
+  expect(pc_series_dict_resolve(&d, "mem", NULL, 0, &s3) == PC_OK && s3.metric_id == 2, "second metric");
+
+  char buf[64];
+  expect(pc_series_dict_describe(&d, s1, buf, sizeof buf) == PC_OK, "describe");
+  expect(strcmp(buf, "cpu{dc=eu,host=a}") == 0, "canonical form");
+  expect(pc_series_dict_describe(&d, m, buf, sizeof buf) == PC_OK && strcmp(buf, "cpu") == 0, "describe name");
+  expect(pc_series_dict_describe(&d, s1, buf, 8) == PC_NO_SPACE, "small buffer");
+  pc_series_t bogus = {2, 1};
+  expect(pc_series_dict_describe(&d, bogus, buf, sizeof buf) == PC_METRIC_UNKNOWN, "ids mismatch");
+
+  pc_tag_t dup[2] = {{"host", "a"}, {"host", "b"}};
+  pc_tag_t eq[1] = {{"a=b", "c"}};
+  expect(pc_series_dict_resolve(&d, "cpu", dup, 2, &s2) == PC_EINVAL, "duplicate tag key");
+  expect(pc_series_dict_resolve(&d, "cpu", eq, 1, &s2) == PC_EINVAL, "'=' in tag key");
+  expect(pc_series_dict_resolve(&d, "", NULL, 0, &s2) == PC_EINVAL, "empty name");
+
+  // Full: one slot left, a new tagged metric needs two
+  pc_tag_t h[1] = {{"host", "b"}};
+  expect(pc_series_dict_resolve(&d, "disk", h, 1, &s2) == PC_TOO_MANY_SERIES, "full");
+  expect(d.count == 3, "nothing half-inserted");
+  expect(pc_series_dict_resolve(&d, "cpu", h, 1, &s2) == PC_OK && s2.series_id == 2, "last slot");
+  expect(pc_series_dict_find(&d, "cpu", h, 1, &s3) == PC_OK && s3.series_id == 2, "find");
+  expect(pc_series_dict_find(&d, "disk", h, 1, &s3) == PC_METRIC_UNKNOWN, "find absent");
+  expect(pc_series_dict_reserve(&d, 2) == PC_EINVAL, "cannot shrink below count");
+  expect(pc_series_dict_reserve(&d, 64) == PC_OK, "grow");
+  for (int i = 0; i < 50; ++i)
+  {
+    char v[8];
+    snprintf(v, sizeof v, "n%d", i);
+    pc_tag_t t[1] = {{"host", v}};
+    expect(pc_series_dict_resolve(&d, "net", t, 1, &s3) == PC_OK, "bulk resolve");
+  }
+  expect(pc_series_dict_find(&d, "cpu", ab, 2, &s2) == PC_OK && s2.series_id == s1.series_id, "rehash kept entries");
+  pc_series_dict_free(&d);
+
+  // ---- Persisted through the DB ----
+  const size_t TOTAL = 128 * 1024, SEG = 4096, PROG = 256;
+  pc_flash_t f = {0};
+  expect(pc_flash_init(&f, TOTAL, SEG, PROG, 0xFF), "flash init");
+  pc_db_t db;
+  expect(pc_db_init(&db, &f, 256, 1) == PC_OK, "db init");
+  pc_series_t cpu_a, cpu_b;
+  pc_tag_t ta[1] = {{"host", "a"}}, tb[1] = {{"host", "b"}};
+  expect(pc_series_resolve(&db, "cpu", ta, 1, &cpu_a) == PC_OK, "db resolve a");
+  expect(pc_series_resolve(&db, "cpu", tb, 1, &cpu_b) == PC_OK, "db resolve b");
+  for (uint32_t i = 0; i < 20; ++i)
+  {
+    expect(pc_write_series(&db, cpu_a, 100 + i, (float)i) == PC_OK, "write a");
+    expect(pc_write_series(&db, cpu_b, 100 + i, (float)(1000 + i)) == PC_OK, "write b");
+  }
+  expect(pc_db_flush_until_empty(&db) == PC_OK, "flush");
+  expect(!db.series.dirty && db.index.nparts == 1, "dirty dictionary forced a snapshot");
+  pc_db_deinit(&db);
+
+  expect(pc_db_init(&db, &f, 256, 100) == PC_OK, "remount");
+  pc_series_t again;
+  expect(pc_series_resolve(&db, "cpu", tb, 1, &again) == PC_OK, "resolve after remount");
+  expect(again.metric_id == cpu_b.metric_id && again.series_id == cpu_b.series_id, "same ids");
+  expect(!db.series.dirty, "no new entries");
+  expect(pc_series_describe(&db, cpu_a, buf, sizeof buf) == PC_OK && strcmp(buf, "cpu{host=a}") == 0, "reverse after remount");
+  pc_tag_t tc[1] = {{"host", "c"}};
+  expect(pc_series_resolve(&db, "cpu", tc, 1, &again) == PC_OK && again.series_id == 3, "ids continue");
+
+  // New id while no segment is open: snapshotted before the segment opens
+  expect(pc_write_series(&db, cpu_a, 500, 1.0f) == PC_OK && pc_db_flush_once(&db) == PC_OK, "flush a");
+  expect(!db.series.dirty && db.app_open, "dictionary on flash first");
+  // New id while a segment is open: the segment and dictionary go first
+  pc_tag_t td[1] = {{"host", "d"}};
+  pc_series_t cpu_d;
+  expect(pc_series_resolve(&db, "cpu", td, 1, &cpu_d) == PC_OK && db.series.dirty, "new id");
+  expect(pc_write_series(&db, cpu_d, 502, 2.0f) == PC_OK && pc_db_flush_once(&db) == PC_OK, "flush d");
+  expect(!db.series.dirty && db.app_open, "dictionary saved before the block for d");
+  pc_db_deinit(&db); // crash: the open segment is lost, the id is not
+  expect(pc_db_init(&db, &f, 256, 200) == PC_OK, "remount after crash");
+  expect(pc_series_resolve(&db, "cpu", td, 1, &again) == PC_OK && again.series_id == cpu_d.series_id, "id kept");
+  expect(!db.series.dirty, "not handed out again");
+
+  pc_bucket_t bk;
+  expect(pc_query_aggregate(&db, cpu_b.metric_id, cpu_b.series_id, 0, 1000, 2000, PC_AGG_MIN, &bk, 1) == PC_OK, "per-series query");
+  expect(bk.count == 20 && bk.min == 1000.0f, "series b data");
+  pc_db_deinit(&db);
+
+  // ---- PR-020: tag selectors ----
+  {
+    pc_flash_t g = {0};
+    expect(pc_flash_init(&g, TOTAL, SEG, PROG, 0xFF), "flash2 init");
+    pc_db_t t;
+    expect(pc_db_init(&t, &g, 512, 1) == PC_OK, "db2 init");
+    expect(pc_db_series_capacity(&t, 400) == PC_OK, "capacity");
+    enum
+    {
+      NS = 300
+    };
+    static const char *sites[3] = {"north", "south", "east"};
+    pc_series_t ser[NS];
+    for (int i = 0; i < NS; ++i)
+    {
+      char host[8], mod[4];
+      snprintf(host, sizeof host, "h%d", i);
+      snprintf(mod, sizeof mod, "%d", i % 7);
+      pc_tag_t tg[4] = {{"site", sites[i % 3]}, {"kind", i % 2 ? "temp" : "hum"}, {"host", host}, {"mod", mod}};
+      expect(pc_series_resolve(&t, "env", tg, 4, &ser[i]) == PC_OK, "resolve env");
+    }
+
+    pc_series_set_t set;
+    pc_series_set_init(&set);
+    pc_tag_t sel[2] = {{"kind", "temp"}, {"site", "north"}};
+    expect(pc_series_select(&t, sel, 2, &set) == PC_OK, "select");
+    size_t want = 0;
+    for (int i = 0; i < NS; ++i)
+    {
+      bool m = (i % 2) && (i % 3 == 0);
+      want += m;
+      expect(pc_series_set_has(&set, ser[i].series_id) == m, "select == brute force");
+    }
+    expect(set.count == want, "select count");
+    pc_tag_t one[2] = {{"host", "h123"}, {"mod", "4"}};
+    expect(pc_series_select(&t, one, 2, &set) == PC_OK && set.count == 1 && pc_series_set_has(&set, ser[123].series_id), "sparse posting");
+    pc_tag_t none[2] = {{"kind", "temp"}, {"site", "west"}};
+    expect(pc_series_select(&t, none, 2, &set) == PC_OK && set.count == 0, "unknown pair");
+    pc_tag_t many[PC_TAGINDEX_SELECT_MAX + 1];
+    for (size_t i = 0; i <= PC_TAGINDEX_SELECT_MAX; ++i)
+      many[i] = sel[i % 2];
+    expect(pc_series_select(&t, many, PC_TAGINDEX_SELECT_MAX, &set) == PC_OK && set.count == want, "max pairs");
+    expect(pc_series_select(&t, many, PC_TAGINDEX_SELECT_MAX + 1, &set) == PC_EINVAL, "too many pairs");
+
+    // Rollback of a partly indexed series (what a failed insert does)
+    pc_tagindex_t tix;
+    pc_tagindex_init(&tix);
+    for (uint16_t id = 1; id <= 200; ++id)
+      expect(pc_tagindex_add(&tix, id % 2 ? "k=a" : "k=b", 3, id) == PC_OK, "tag add");
+    expect(pc_tagindex_add(&tix, "k=c", 3, 201) == PC_OK && pc_tagindex_add(&tix, "k=a", 3, 201) == PC_OK, "new series");
+    pc_tagindex_remove(&tix, "k=c", 3, 201);
+    pc_tagindex_remove(&tix, "k=a", 3, 201);
+    pc_tag_t ka = {"k", "a"}, kc = {"k", "c"};
+    expect(pc_tagindex_select(&tix, &ka, 1, &set) == PC_OK && set.count == 100 && !pc_series_set_has(&set, 201),
+           "removed from bitset posting");
+    expect(pc_tagindex_select(&tix, &kc, 1, &set) == PC_OK && set.count == 0, "removed from array posting");
+    expect(pc_tagindex_add(&tix, "k=a", 3, 201) == PC_OK && pc_tagindex_select(&tix, &ka, 1, &set) == PC_OK &&
+               set.count == 101,
+           "id reusable after rollback");
+    pc_tagindex_free(&tix);
+
+    // Data: 5 points per series, value = series index
+    for (uint32_t k = 0; k < 5; ++k)
+    {
+      for (int i = 0; i < NS; ++i)
+      {
+        expect(pc_write_series(&t, ser[i], 100 + k, (float)i) == PC_OK, "write env");
+        if (pc_ring_size(&t.ring) >= 256)
+          while (!pc_ring_is_empty(&t.ring))
+            expect(pc_db_flush_once(&t) == PC_OK, "flush env");
+      }
+    }
+    expect(pc_db_flush_until_empty(&t) == PC_OK, "flush all env");
+    pc_db_deinit(&t);
+
+    // Index rebuilt from the dictionary section
+    expect(pc_db_init(&t, &g, 512, 1000) == PC_OK, "remount env");
+    expect(pc_series_select(&t, sel, 2, &set) == PC_OK && set.count == want, "select after remount");
+    pc_bucket_t bk;
+    expect(pc_query_aggregate_set(&t, ser[0].metric_id, &set, 0, 1000, 2000, PC_AGG_SUM, &bk, 1) == PC_OK, "aggregate set");
+    double sum = 0;
+    for (int i = 0; i < NS; ++i)
+      if ((i % 2) && (i % 3 == 0))
+        sum += 5.0 * i;
+    expect(bk.count == want * 5 && bk.sum == sum, "aggregate over selected series");
+
+    pc_query_filter_t q = {ser[0].metric_id, PC_SERIES_ANY, 0, UINT32_MAX, 0, 0, PC_READ_COMMITTED, &set};
+    scan_count_t sc = {&set, 0, true};
+    expect(pc_query_scan(&t, &q, count_points, &sc) == PC_OK, "scan set");
+    expect(sc.points == want * 5 && sc.only_selected, "scan streams only selected series");
+    pc_series_set_free(&set);
+    pc_db_deinit(&t);
+    pc_flash_free(&g);
+  }
+
+  pc_flash_free(&f);
+  puts("series: ok");
+  return 0;
+}
@@ -0,0 +1,104 @@
+// PR-018 tests: log-histogram quantile sketch
+// - quantiles of encoded + merged sketches are within PC_SKETCH_REL_ERROR of exact
+// - merging encoded blocks == adding the raw values one by one
+// - negatives, zero and NaN are handled; foreign bucket layouts are refused
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "pc_sketch.h"
+
+static void expect(int cond, const char *msg)
+{
+  if (!cond)
+  {
+    fprintf(stderr, "FAIL: %s\n", msg);
+    exit(1);
+  }
+}
+
+static int cmp_float(const void *a, const void *b)
+{
+  float x = *(const float *)a, y = *(const float *)b;
+  return (x > y) - (x < y);
+}
+
+static uint32_t rng = 12345u;
+static uint32_t next_rand(void)
+{
+  rng = rng * 1664525u + 1013904223u;
+  return rng >> 8;
+}
+
+enum
+{
+  BLOCKS = 40,
+  PER_BLOCK = 128
+};
+
+int main(void)
+{
+  static float vals[BLOCKS * PER_BLOCK];
+  pc_sketch_acc_t merged, raw;
+  pc_sketch_acc_init(&merged);
+  pc_sketch_acc_init(&raw);
+
+  // Latency-like values spread over several decades, some negatives and zeros.
+  for (uint32_t i = 0; i < BLOCKS * PER_BLOCK; ++i)
+  {
+    float v = (float)(next_rand() % 100000u) / 37.0f + 0.001f;
+    if (i % 17 == 0)
+      v = v * v;
+    if (i % 29 == 0)
+      v = -v;
+    if (i % 101 == 0)
+      v = 0.0f;
+    vals[i] = v;
+  }
+
+  uint8_t enc[PC_SKETCH_MAX_BYTES];
+  for (uint32_t b = 0; b < BLOCKS; ++b)
+  {
+    size_t len = pc_sketch_encode(vals + b * PER_BLOCK, PER_BLOCK, enc, sizeof enc);
+    expect(len >= sizeof(pc_sketch_hdr_t) && len <= sizeof enc, "encode");
+    expect(pc_sketch_encoded_bytes(enc, len) == len, "encoded size");
+    expect(pc_sketch_acc_merge(&merged, enc, len) == PC_OK, "merge");
+  }
+  for (uint32_t i = 0; i < BLOCKS * PER_BLOCK; ++i)
+    expect(pc_sketch_acc_add(&raw, vals[i]) == PC_OK, "add");
+  expect(merged.total == BLOCKS * PER_BLOCK && raw.total == merged.total, "totals");
+
+  qsort(vals, BLOCKS * PER_BLOCK, sizeof(float), cmp_float);
+  const float qs[] = {0.0f, 0.01f, 0.25f, 0.5f, 0.9f, 0.95f, 0.99f, 0.999f, 1.0f};
+  for (size_t k = 0; k < sizeof qs / sizeof qs[0]; ++k)
+  {
+    float a = 0, b = 0;
+    expect(pc_sketch_acc_quantile(&merged, qs[k], &a) == PC_OK, "quantile");
+    expect(pc_sketch_acc_quantile(&raw, qs[k], &b) == PC_OK && a == b, "merged == raw");
+    float exact = vals[(size_t)((double)qs[k] * (BLOCKS * PER_BLOCK - 1))];
+    expect(fabs((double)a - exact) <= PC_SKETCH_REL_ERROR * fabs((double)exact), "relative error bound");
+  }
+
+  // NaN / Inf are ignored, bad q rejected, empty accumulator reports no data
+  float v = 0;
+  expect(pc_sketch_acc_add(&raw, NAN) == PC_OK && pc_sketch_acc_add(&raw, INFINITY) == PC_OK, "non-finite");
+  expect(raw.total == merged.total, "non-finite not counted");
+  expect(pc_sketch_acc_quantile(&raw, 1.5f, &v) == PC_EINVAL, "bad q");
+  pc_sketch_acc_t empty;
+  pc_sketch_acc_init(&empty);
+  expect(pc_sketch_acc_quantile(&empty, 0.5f, &v) == PC_METRIC_UNKNOWN, "empty");
+
+  // A sketch written with another bucket layout is refused, not misread
+  size_t len = pc_sketch_encode(vals, 16, enc, sizeof enc);
+  enc[0] ^= 1u;
+  expect(pc_sketch_acc_merge(&empty, enc, len) == PC_UNSUPPORTED, "foreign layout");
+  expect(pc_sketch_acc_merge(&empty, enc, 4) == PC_CORRUPT, "truncated");
+  expect(pc_sketch_encode(vals, 16, enc, 8) == 0, "no room");
+
+  pc_sketch_acc_free(&merged);
+  pc_sketch_acc_free(&raw);
+  pc_sketch_acc_free(&empty);
+  puts("sketch: ok");
+  return 0;
+}